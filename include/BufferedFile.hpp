@@ -0,0 +1,68 @@
+#ifndef YAOHUI_MASTER_THESIS_BUFFEREDFILE_HPP
+#define YAOHUI_MASTER_THESIS_BUFFEREDFILE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace yaohui {
+
+/**
+ * @brief 带固定大小缓冲区的只写文件
+ *
+ * 数据先写入缓冲区, 缓冲区满时才对文件描述符调用一次write, 内存占用与输出
+ * 文件的大小无关. 析构时自动刷新并关闭文件.
+ */
+class BufferedFile {
+private:
+  int fd_ = -1;                   // 文件描述符
+  std::vector<char> buffer_ = {}; // 输出缓冲区
+  size_t size_ = 0;               // 缓冲区中已使用的字节数
+  bool failed_ = false;           // 是否发生过写入错误
+
+public:
+  BufferedFile() = delete;
+  BufferedFile(const BufferedFile &) = delete;
+  BufferedFile &operator=(const BufferedFile &) = delete;
+  BufferedFile(BufferedFile &&) = delete;
+  BufferedFile &operator=(BufferedFile &&) = delete;
+  /**
+   * @param f_name 文件名
+   * @param buffer_size 缓冲区大小(字节)
+   * @param append 为true时追加到已有文件的末尾, 否则已有文件将被截断
+   */
+  explicit BufferedFile(const std::string &f_name,
+                        size_t buffer_size = 1 << 16, bool append = false);
+  ~BufferedFile();
+
+  bool is_open() const;
+  bool good() const; // 文件已打开且未发生写入错误
+  void write(const char *data, size_t n);
+  void write(const std::string &s) { write(s.data(), s.size()); }
+  void put(char c) {
+    if (size_ == buffer_.size()) {
+      flush();
+    }
+    buffer_[size_++] = c;
+  }
+  void write_int(int64_t v); // 以十进制写入整数
+  // 以能精确还原该值的最短十进制形式写入浮点数, 与nlohmann::json的输出相同
+  void write_double(double v);
+  /**
+   * @brief 在缓冲区中预留至少n个字节的连续空间
+   *
+   * @return 预留空间的首地址, 写入k个字节后须调用commit(k)
+   */
+  char *reserve(size_t n);
+  void commit(size_t n) { size_ += n; }
+  void flush();
+  bool close(); // 刷新并关闭文件, 返回整个写入过程是否成功
+
+private:
+  void write_all(const char *data, size_t n); // 绕过缓冲区直接写入文件
+};
+
+} // namespace yaohui
+
+#endif // YAOHUI_MASTER_THESIS_BUFFEREDFILE_HPP
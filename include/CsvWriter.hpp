@@ -0,0 +1,48 @@
+#ifndef YAOHUI_MASTER_THESIS_CSVWRITER_HPP
+#define YAOHUI_MASTER_THESIS_CSVWRITER_HPP
+
+#include "BufferedFile.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace yaohui {
+
+/**
+ * @brief 各输出路径共用的csv写出器
+ *
+ * 字段直接格式化进大块输出缓冲区(默认1MiB), 缓冲区满时才调用一次write.
+ * 浮点数按能精确还原的最短十进制形式输出.
+ */
+class CsvWriter {
+private:
+  BufferedFile file_;     // 输出文件
+  bool row_begin_ = true; // 下一个字段是否为行首
+
+public:
+  CsvWriter() = delete;
+  CsvWriter(const CsvWriter &) = delete;
+  CsvWriter &operator=(const CsvWriter &) = delete;
+  // append为true时追加到已有文件的末尾
+  explicit CsvWriter(const std::string &f_name, size_t buffer_size = 1 << 20,
+                     bool append = false);
+
+  bool is_open() const;
+  CsvWriter &field(double v);
+  CsvWriter &field(int64_t v);
+  CsvWriter &field(int32_t v) { return field(static_cast<int64_t>(v)); }
+  CsvWriter &field(const char *v);
+  CsvWriter &field(const std::string &v);
+  CsvWriter &row(const std::vector<double> &values); // 整行写出并换行
+  void end_row();
+  void flush(); // 把缓冲区中的数据写入文件
+  bool close(); // 刷新并关闭文件, 返回整个写入过程是否成功
+
+private:
+  void separator();
+};
+
+} // namespace yaohui
+
+#endif // YAOHUI_MASTER_THESIS_CSVWRITER_HPP
@@ -0,0 +1,56 @@
+#ifndef YAOHUI_MASTER_THESIS_ENERGYBINARYFORMAT_HPP
+#define YAOHUI_MASTER_THESIS_ENERGYBINARYFORMAT_HPP
+
+#include <cstdint>
+
+namespace yaohui {
+
+/*
+ * 能量分布曲线的二进制列存格式(小端序), 可直接内存映射读取:
+ *
+ *   EnergyBinaryHeader                      文件头, 64字节
+ *   EnergyBinaryColumn[column_cnt]          列目录, 每项32字节
+ *   列数据...                                每列起始偏移按8字节对齐
+ *
+ * 列的顺序为: 各供电臂的用能曲线(按供电臂id升序), 然后是各供电臂的产能曲线.
+ * 每列对应一个供电臂在时刻[0, sample_cnt)秒内每秒的能量(kJ).
+ *
+ * encoding为kRaw时, 列数据为sample_cnt个float32或float64;
+ * encoding为kZeroRunLength时, 列数据为若干个连续的记录, 每个记录为
+ *   uint32 zero_cnt     先跟随的0值个数
+ *   uint32 literal_cnt  随后的非0值个数
+ *   literal_cnt个float32或float64
+ * 所有记录展开后恰好为sample_cnt个值.
+ */
+
+constexpr char kEnergyBinaryMagic[8] = {'Y', 'H', 'E', 'N', 'E', 'R', 'G', 'Y'};
+constexpr uint32_t kEnergyBinaryVersion = 1;
+
+enum EnergyBinaryValueType : uint32_t { kFloat32 = 1, kFloat64 = 2 };
+enum EnergyBinaryEncoding : uint32_t { kRaw = 0, kZeroRunLength = 1 };
+enum EnergyBinaryColumnKind : uint32_t { kConsume = 0, kProduce = 1 };
+
+struct EnergyBinaryHeader {
+  char magic[8];        // kEnergyBinaryMagic
+  uint32_t version;     // kEnergyBinaryVersion
+  uint32_t column_cnt;  // 列数目
+  uint64_t sample_cnt;  // 每列展开后的值个数(秒)
+  uint32_t value_type;  // EnergyBinaryValueType
+  uint32_t encoding;    // EnergyBinaryEncoding
+  uint64_t reserved[4]; // 保留, 写0
+};
+
+struct EnergyBinaryColumn {
+  int32_t supply_arm_id; // 供电臂id
+  uint32_t kind;         // EnergyBinaryColumnKind
+  uint64_t offset;       // 列数据相对文件头的偏移(字节)
+  uint64_t byte_size;    // 列数据长度(字节)
+  uint64_t nonzero_cnt;  // 非0值个数
+};
+
+static_assert(sizeof(EnergyBinaryHeader) == 64, "header layout");
+static_assert(sizeof(EnergyBinaryColumn) == 32, "column layout");
+
+} // namespace yaohui
+
+#endif // YAOHUI_MASTER_THESIS_ENERGYBINARYFORMAT_HPP
@@ -0,0 +1,150 @@
+#ifndef YAOHUI_MASTER_THESIS_EVALUATOR_HPP
+#define YAOHUI_MASTER_THESIS_EVALUATOR_HPP
+
+#include "BaseDef.hpp"
+#include "TimetableConfig.hpp"
+#include <cstddef>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace yaohui {
+
+/**
+ * @brief 增量评价器
+ *
+ * 保存各运行线在各车站的到站时刻和停站时长, 以及各供电臂的产能/用能分布
+ * 曲线. 平移一条运行线的发车时刻或改变一个停站时长时, 只在受影响的用能窗口
+ * (consume_duration秒)和产能窗口(produce_duration秒)内重新累计, 不必重建
+ * Timetable. 复用率的定义与Timetable::total_reuse_ratio()相同, 刚构造或
+ * resync之后两者逐位相等.
+ *
+ * 运行线编号与Timetable相同: 先下行后上行. 车站位置pos按列车的运行方向
+ * 计数, 0为始发站.
+ */
+class Evaluator {
+public:
+  /**
+   * @brief 单基因移动
+   *
+   * 把运行线mission在pos之后的事件整体平移delta秒: pos为0时平移始发站
+   * 发车时刻, 否则把第pos个车站的停站时长增加delta.
+   */
+  struct Move {
+    size_t mission;
+    size_t pos;
+    second_t delta;
+  };
+
+  /**
+   * @brief 单事件平移的增益表
+   *
+   * gain[((mission * station_cnt + pos) * 2 + type) * (2 * max_shift + 1) +
+   * delta + max_shift]为只把运行线mission第pos个车站的一个事件平移delta秒,
+   * 其余事件不动时复用率的变化. type为0时是离站的用能事件, 为1时是到站的
+   * 产能事件; 末站没有用能事件, 始发站没有产能事件, 对应项为0.
+   */
+  struct GainTable {
+    second_t max_shift = 0;
+    size_t station_cnt = 0;
+    std::vector<double> gain = {};
+    double consume(size_t mission, size_t pos, second_t delta) const;
+    double produce(size_t mission, size_t pos, second_t delta) const;
+  };
+
+private:
+  // 一个产能或用能窗口在某供电臂上覆盖的[beg, end)
+  struct Window {
+    size_t arm;
+    second_t beg;
+    second_t end;
+  };
+
+  TimetableConfig config_;   // 基础染色体, config()在其上写回
+  size_t down_cnt_ = 0;      // 下行运行线数目
+  size_t mission_cnt_ = 0;   // 运行线数目
+  size_t station_cnt_ = 0;   // 车站数目
+  second_t consume_len_ = 0; // 用能窗口长度
+  second_t produce_len_ = 0; // 产能窗口长度
+  // 下行/上行第pos个车站所属供电臂的稠密编号
+  std::vector<size_t> down_arm_ = {};
+  std::vector<size_t> up_arm_ = {};
+  // 下行/上行由第pos个车站到第pos+1个车站的行程时长
+  std::vector<second_t> down_travel_ = {};
+  std::vector<second_t> up_travel_ = {};
+  // 运行线m第pos个车站的到站时刻和停站时长, 下标为m * station_cnt_ + pos
+  std::vector<second_t> arrive_ = {};
+  std::vector<second_t> dwell_ = {};
+  std::vector<std::vector<joule_t>> consume_ = {}; // 各供电臂用能分布
+  std::vector<std::vector<joule_t>> produce_ = {}; // 各供电臂产能分布
+  // 供电臂有用能事件时才计入复用率, 与Timetable相同
+  std::vector<bool> counted_ = {};
+  double reuse_ = 0.0;               // 各供电臂sum(min(产能, 用能))
+  double produce_total_ = 0.0;       // 计入复用率的总产能
+  std::vector<Window> windows_ = {}; // apply的临时空间
+
+public:
+  Evaluator() = delete;
+  // 有能量窗口早于0秒时抛出std::out_of_range
+  explicit Evaluator(TimetableConfig config);
+
+  double ratio() const; // 当前的复用率
+  size_t missions_cnt() const;
+  size_t stations_cnt() const;
+  second_t departure(size_t mission) const; // 始发站发车时刻
+  second_t dwell(size_t mission, size_t pos) const;
+  // 当前时刻表对应的染色体
+  TimetableConfig config() const;
+
+  // 执行移动并返回新的复用率, 以相反的delta再执行一次即可撤销.
+  // 移动后有能量窗口早于0秒时抛出std::out_of_range, 状态不变
+  double apply(const Move &move);
+  /**
+   * @brief 在Individual随机化所用的范围内随机抽取一个单基因移动
+   *
+   * 等概率地选择一个非首班车的发车时刻或一个中间车站的停站时长, 在前车
+   * 发车时刻的最小/最大追踪间隔之间或停站时长上下限之间重新取值. 新值与
+   * 原值相同, 使后车的追踪间隔越界, 或使能量窗口早于0秒时返回false,
+   * 因此返回的移动可直接交给apply而不会抛出异常.
+   */
+  bool random_move(std::default_random_engine &e, Move &move) const;
+  /**
+   * @brief 一次计算所有事件平移-k..k秒的增益表
+   *
+   * 每个事件只与其附近的用能或产能窗口相互作用: 去掉该事件后的曲线上,
+   * 事件位于x时的贡献为窗口内sum(min(产能, 用能))之差, 对2k+1个位置各求
+   * 一次即可, 不必为每个候选重建Timetable或执行apply.
+   */
+  GainTable gain_table(second_t k) const;
+  // 把增益表写入csv, 每行为一个事件的一个平移量, 写入成功时返回true
+  bool output_gain_table(const std::string &f_name, second_t k) const;
+
+  // 由到站时刻和停站时长重新累计分布曲线, 消除增量更新的浮点误差
+  void resync();
+  // 当前的到站时刻和停站时长, 用于保存和恢复状态
+  std::vector<second_t> genome() const;
+  // 长度不符时抛出std::invalid_argument, 有能量窗口早于0秒时抛出
+  // std::out_of_range, 两种情况下状态均不变
+  void set_genome(const std::vector<second_t> &genome);
+
+private:
+  bool is_down(size_t mission) const;
+  size_t arm_at(size_t mission, size_t pos) const;
+  // 检查各用能和产能窗口的起点不早于0秒, 否则抛出std::out_of_range
+  void check_windows(const second_t *arrive, const second_t *dwell) const;
+  // 移动后受影响的能量窗口的起点是否都不早于0秒
+  bool move_keeps_windows(const Move &move) const;
+  // 把kernel的前len个值乘以sign累加到curve的[beg, beg + len)上
+  static void accumulate(std::vector<joule_t> &curve, second_t beg,
+                         second_t len, const P_curve_t &kernel, double sign);
+  void ensure_horizon(second_t end);
+  double windows_reuse() const;
+  // 事件的kernel位于窗口起点x = -k..k时的贡献, 结果减去x = 0时的贡献
+  static void event_gains(const joule_t *other, const joule_t *self,
+                          const P_curve_t &kernel, second_t len, second_t k,
+                          std::vector<double> &scratch, double *out);
+};
+
+} // namespace yaohui
+
+#endif // YAOHUI_MASTER_THESIS_EVALUATOR_HPP
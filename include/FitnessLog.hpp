@@ -0,0 +1,68 @@
+#ifndef YAOHUI_MASTER_THESIS_FITNESSLOG_HPP
+#define YAOHUI_MASTER_THESIS_FITNESSLOG_HPP
+
+#include "CsvWriter.hpp"
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace yaohui {
+
+/**
+ * @brief 每代适应度的流式日志
+ *
+ * 优化线程调用append()把一代的适应度放入队列后立即返回, 后台写线程负责格式化
+ * 并追加到csv文件, 每次队列写空后刷新到磁盘, 进程中途崩溃时已完成的代仍然可用.
+ * 每行格式: generation,best,worst,avg,fitness_0,...,fitness_{N-1}, 其中N为
+ * 构造时给定的每代个体数.
+ */
+class FitnessLog {
+private:
+  // 一代的记录
+  struct Record {
+    size_t generation;
+    std::vector<double> fitness;
+  };
+
+  bool resumed_;                  // 是否续写已有的日志
+  CsvWriter out_;                 // 输出文件
+  std::mutex mutex_;              // 保护queue_和stop_
+  std::condition_variable cv_;    // 通知写线程
+  std::deque<Record> queue_ = {}; // 待写出的记录
+  bool stop_ = false;             // 是否停止写线程
+  std::thread writer_;            // 后台写线程
+
+public:
+  FitnessLog() = delete;
+  FitnessLog(const FitnessLog &) = delete;
+  FitnessLog &operator=(const FitnessLog &) = delete;
+  FitnessLog(const std::string &f_name, size_t fitness_cnt);
+  /**
+   * @brief 从检查点恢复时续写f_name中已有的日志
+   *
+   * 保留表头和第generation代及之前的行, 其后的行由上次运行在最后一个检查点
+   * 之后写入, 续算时会重新生成, 因此丢弃. 文件不存在或不是适应度日志时与
+   * 新建日志相同.
+   */
+  FitnessLog(const std::string &f_name, size_t fitness_cnt,
+             size_t generation);
+  ~FitnessLog(); // 写完队列中剩余的记录后关闭文件
+
+  bool is_open() const;
+  // 追加一代的适应度(按由大到小排列)
+  void append(size_t generation, std::vector<double> fitness);
+  // 写完队列中剩余的记录后关闭文件, 全部写入成功时返回true
+  bool close();
+
+private:
+  void write_header(size_t fitness_cnt);
+  void write_loop();
+};
+
+} // namespace yaohui
+
+#endif // YAOHUI_MASTER_THESIS_FITNESSLOG_HPP
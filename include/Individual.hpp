@@ -5,7 +5,9 @@
 #include "Timetable.hpp"
 #include "TimetableConfig.hpp"
 #include <cstdint>
+#include <functional>
 #include <map>
+#include <random>
 #include <utility>
 #include <vector>
 
@@ -24,7 +26,10 @@ public:
   Individual &operator=(const Individual &) = default; // 拷贝赋值
   Individual &operator=(Individual &&) = default;      // 移动赋值
   ~Individual() = default;                             // 默认析构
-  explicit Individual(TimetableConfig tb_config);
+  // 使用给定的随机数引擎在tb_config基础上随机化
+  Individual(TimetableConfig tb_config, std::default_random_engine &e);
+  // 直接使用给定染色体(不做随机化)构造个体并评分
+  static Individual from_config(TimetableConfig tb_config);
 
 public:
   double score() const;
@@ -32,7 +37,17 @@ public:
   const TimetableConfig &timetable_config() const;
   TimetableConfig &timetable_config();
   void update_score();
-  std::vector<double> random_walk(size_t k);
+  // 进程启动以来所有线程调用update_score(完整评价一次运行图)的总次数
+  static uint64_t evaluation_count();
+  // 以标准运行图为基础随机抽样k次, 返回每次的适应度, 个体保留最后一次的结果
+  std::vector<double> random_walk(size_t k, std::default_random_engine &e);
+  // 同上, 但不保存结果, 每次抽样后以个体自身调用on_sample
+  void random_walk(size_t k, std::default_random_engine &e,
+                   const std::function<void(const Individual &)> &on_sample);
+
+private:
+  // 在当前染色体基础上随机化发车时刻和中间站停站时长, 并更新score
+  void randomize(std::default_random_engine &e);
 };
 
 } // namespace yaohui
@@ -0,0 +1,53 @@
+#ifndef YAOHUI_MASTER_THESIS_JSONWRITER_HPP
+#define YAOHUI_MASTER_THESIS_JSONWRITER_HPP
+
+#include "BufferedFile.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace yaohui {
+
+/**
+ * @brief 流式(SAX风格)json输出
+ *
+ * 按调用顺序直接把json文本写入BufferedFile, 不构造DOM, 内存占用只与嵌套深度
+ * 有关. 缩进格式与nlohmann::json::dump(indent)的输出一致, indent < 0时输出
+ * 不带任何空白的紧凑格式. 调用者负责保证调用序列构成合法的json.
+ */
+class JsonWriter {
+private:
+  BufferedFile &out_;               // 输出文件
+  int indent_ = 2;                  // 缩进空格数, 小于0表示紧凑格式
+  std::vector<size_t> counts_ = {}; // 每层容器中已写入的元素数目
+  bool after_key_ = false;          // 上一次调用是否为key()
+
+public:
+  JsonWriter() = delete;
+  JsonWriter(const JsonWriter &) = delete;
+  JsonWriter &operator=(const JsonWriter &) = delete;
+  explicit JsonWriter(BufferedFile &out, int indent = 2);
+
+  void begin_object();
+  void end_object();
+  void begin_array();
+  void end_array();
+  void key(const char *k);
+  void value(int64_t v);
+  void value(int32_t v) { value(static_cast<int64_t>(v)); }
+  void value(bool v);
+  void value(double v); // 最短的可精确还原的十进制形式
+  void value(const std::string &v);
+  void null();
+
+private:
+  void before_value(); // 写入元素前的逗号, 换行和缩进
+  void end_container(char c);
+  void newline_indent(size_t depth);
+  void write_string(const char *s, size_t n);
+};
+
+} // namespace yaohui
+
+#endif // YAOHUI_MASTER_THESIS_JSONWRITER_HPP
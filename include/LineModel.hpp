@@ -0,0 +1,197 @@
+#ifndef YAOHUI_MASTER_THESIS_LINEMODEL_HPP
+#define YAOHUI_MASTER_THESIS_LINEMODEL_HPP
+
+#include "BaseDef.hpp"
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace yaohui {
+
+// 线路参数的原始数据, 默认值为内置的16站4供电臂线路.
+// 校验通过后才能构造为不可变的LineModel.
+struct LineData {
+  // 下行方向的列车经过的车站的默认id(参数)
+  // 脚标i为下行方向列车经过的第i个车站
+  // 脚标i对应的值stations.at(i)为该车站的默认id
+  down_stations_id_seq_t stations = {0, 1, 2,  3,  4,  5,  6,  7,
+                                     8, 9, 10, 11, 12, 13, 14, 15};
+
+  // 车站所属供电臂id(参数)
+  supply_arm_map_t supply_arm = {
+      {0, 0}, {1, 0}, {2, 0},  {3, 0},  {4, 1},  {5, 1},  {6, 1},  {7, 1},
+      {8, 2}, {9, 2}, {10, 2}, {11, 2}, {12, 3}, {13, 3}, {14, 3}, {15, 3}};
+
+  // 区间标准行程时长(参数)
+  travel_duration_t travel_duration = {
+      {{0, 1}, 185},   {{1, 0}, 185},   {{1, 2}, 136},   {{2, 1}, 136},
+      {{2, 3}, 127},   {{3, 2}, 127},   {{3, 4}, 145},   {{4, 3}, 145},
+      {{4, 5}, 150},   {{5, 4}, 150},   {{5, 6}, 119},   {{6, 5}, 119},
+      {{6, 7}, 105},   {{7, 6}, 105},   {{7, 8}, 134},   {{8, 7}, 134},
+      {{8, 9}, 143},   {{9, 8}, 143},   {{9, 10}, 136},  {{10, 9}, 136},
+      {{10, 11}, 167}, {{11, 10}, 167}, {{11, 12}, 157}, {{12, 11}, 157},
+      {{12, 13}, 172}, {{13, 12}, 172}, {{13, 14}, 181}, {{14, 13}, 181},
+      {{14, 15}, 185}, {{15, 14}, 185}};
+
+  second_t produce_duration = 15; // 标准产能时长(参数)
+  second_t consume_duration = 30; // 标准用能时长(参数)
+  // 车站标准停站时长
+  stop_duration_t stop_duration = {{0, 0},   {1, 30},  {2, 30},  {3, 30},
+                                   {4, 45},  {5, 45},  {6, 45},  {7, 45},
+                                   {8, 45},  {9, 45},  {10, 30}, {11, 30},
+                                   {12, 30}, {13, 30}, {14, 30}, {15, 0}};
+
+  stop_duration_t stop_duration_min = {{0, 0},   {1, 25},  {2, 25},  {3, 25},
+                                       {4, 40},  {5, 40},  {6, 40},  {7, 40},
+                                       {8, 40},  {9, 40},  {10, 25}, {11, 25},
+                                       {12, 25}, {13, 25}, {14, 25}, {15, 0}};
+
+  stop_duration_t stop_duration_max = {{0, 0},   {1, 35},  {2, 35},  {3, 35},
+                                       {4, 50},  {5, 50},  {6, 50},  {7, 50},
+                                       {8, 50},  {9, 50},  {10, 35}, {11, 35},
+                                       {12, 35}, {13, 35}, {14, 35}, {15, 0}};
+  // 各个时段的标准追踪间隔(参数)
+  departure_T_t departure_T = {
+      {{19800, 25200}, 600}, // [5:30-7:00) 10min
+      {{25200, 28800}, 240}, // [7:00,8:00) 4min
+      {{28800, 36000}, 120}, // [8:00,10:00) 2min
+      {{36000, 39600}, 240}, // [10:00,11:00) 4min
+      {{39600, 57600}, 600}, // [11:00,16:00) 10min
+      {{57600, 61200}, 240}, // [16:00,17:00) 4min
+      {{61200, 68400}, 120}, // [17:00,19:00) 2min
+      {{68400, 72000}, 240}, // [19:00,20:00) 4min
+      {{72000, 84600}, 600}  // [20:00,23:30) 10min
+  };
+  // 各个时段的最小追踪间隔(参数)
+  departure_T_t departure_T_min = {
+      {{19800, 25200}, 570}, // [5:30-7:00) 10min
+      {{25200, 28800}, 210}, // [7:00,8:00) 4min
+      {{28800, 36000}, 90},  // [8:00,10:00) 2min
+      {{36000, 39600}, 210}, // [10:00,11:00) 4min
+      {{39600, 57600}, 570}, // [11:00,16:00) 10min
+      {{57600, 61200}, 210}, // [16:00,17:00) 4min
+      {{61200, 68400}, 90},  // [17:00,19:00) 2min
+      {{68400, 72000}, 210}, // [19:00,20:00) 4min
+      {{72000, 84600}, 570}  // [20:00,23:30) 10min
+  };
+  // 各个时段的最大追踪间隔(参数)
+  departure_T_t departure_T_max = {
+      {{19800, 25200}, 630}, // [5:30-7:00) 10min
+      {{25200, 28800}, 270}, // [7:00,8:00) 4min
+      {{28800, 36000}, 150}, // [8:00,10:00) 2min
+      {{36000, 39600}, 270}, // [10:00,11:00) 4min
+      {{39600, 57600}, 630}, // [11:00,16:00) 10min
+      {{57600, 61200}, 270}, // [16:00,17:00) 4min
+      {{61200, 68400}, 150}, // [17:00,19:00) 2min
+      {{68400, 72000}, 270}, // [19:00,20:00) 4min
+      {{72000, 84600}, 630}  // [20:00,23:30) 10min
+  };
+
+  // 首班车发车时刻(5:30)(包含)(参数)
+  // 末班车发车时刻(23:30)(不包含)(参数)
+  second_t first_train_time = 61200;
+  second_t last_train_time = 68400;
+
+  // 用能功率曲线
+  P_curve_t consume_vec = {
+      202.544, 607.53,  1012.21, 1416.8, 1820.87, 2224.65, 2627.32, 3029.41,
+      3430.61, 3676.98, 3680.0,  3680.0, 3680.0,  3680.0,  3680.0,  3680.0,
+      3680.0,  3680.0,  3680.0,  3680.0, 3680.0,  3680.0,  3680.0,  3680.0,
+      3680.0,  3680.0,  3680.0,  3680.0, 3680.0,  3680.0}; // 启动阶段的用能关系
+  // 产能功率曲线
+  P_curve_t produce_vec = {4499.74, 4189.41, 3879.09, 3568.76,
+                           3258.44, 2948.11, 2637.79, 2327.47,
+                           2017.14, 1706.97, 1396.46, 1086.14,
+                           671.127, 0.0,     0.0}; // 再生制动阶段的产能关系
+};
+
+/**
+ * @brief 不可变的线路模型
+ *
+ * 构造时对线路数据做一次完整校验(区间行程时长是否齐全, 供电臂是否覆盖所有
+ * 车站, 停站时长和追踪间隔是否满足min <= std <= max等), 并生成按下行车站
+ * 顺序排列的稠密查找表, 之后的热点路径不再需要带边界检查的查找.
+ * 运行期间所有TimetableConfig共享同一个LineModel.
+ */
+class LineModel {
+private:
+  LineData data_;                             // 线路原始数据
+  std::vector<supply_arm_id_t> arm_seq_ = {}; // 第i个车站所属的供电臂
+  // 下行第i个车站到第i+1个车站的行程时长
+  std::vector<second_t> down_travel_seq_ = {};
+  // 上行方向由第i+1个车站到第i个车站的行程时长
+  std::vector<second_t> up_travel_seq_ = {};
+
+public:
+  LineModel() = delete;
+  LineModel(const LineModel &) = default;
+  LineModel(LineModel &&) = default;
+  LineModel &operator=(const LineModel &) = delete;
+  LineModel &operator=(LineModel &&) = delete;
+  ~LineModel() = default;
+  /**
+   * @param data 线路原始数据
+   * @throw std::invalid_argument 校验失败, 异常信息中列出全部问题
+   */
+  explicit LineModel(LineData data);
+
+  // 内置的默认线路
+  static std::shared_ptr<const LineModel> default_model();
+  /**
+   * @brief 从json线路描述文件加载线路模型
+   *
+   * @throw std::runtime_error 文件无法打开或格式错误
+   * @throw std::invalid_argument 线路数据校验失败
+   */
+  static std::shared_ptr<const LineModel> load_from_file(const std::string &f);
+  // 当前使用的线路模型(未设置时为内置线路), 默认构造的TimetableConfig使用它
+  static std::shared_ptr<const LineModel> current();
+  // 设置当前线路模型, 应在启动时, 创建任何TimetableConfig之前调用
+  static void set_current(std::shared_ptr<const LineModel> model);
+
+  // 将线路模型写至json线路描述文件, 写入成功时返回true
+  bool write_to_file(const std::string &f) const;
+  // 线路数据的64位FNV-1a指纹, 数据相同的线路指纹相同
+  uint64_t hash() const;
+
+  const LineData &data() const { return data_; }
+  const down_stations_id_seq_t &stations() const { return data_.stations; }
+  const supply_arm_map_t &supply_arm() const { return data_.supply_arm; }
+  const travel_duration_t &travel_duration() const {
+    return data_.travel_duration;
+  }
+  second_t produce_duration() const { return data_.produce_duration; }
+  second_t consume_duration() const { return data_.consume_duration; }
+  const stop_duration_t &stop_duration() const { return data_.stop_duration; }
+  const stop_duration_t &stop_duration_min() const {
+    return data_.stop_duration_min;
+  }
+  const stop_duration_t &stop_duration_max() const {
+    return data_.stop_duration_max;
+  }
+  const departure_T_t &departure_T() const { return data_.departure_T; }
+  const departure_T_t &departure_T_min() const {
+    return data_.departure_T_min;
+  }
+  const departure_T_t &departure_T_max() const {
+    return data_.departure_T_max;
+  }
+  second_t first_train_time() const { return data_.first_train_time; }
+  second_t last_train_time() const { return data_.last_train_time; }
+  const P_curve_t &consume_vec() const { return data_.consume_vec; }
+  const P_curve_t &produce_vec() const { return data_.produce_vec; }
+  const std::vector<supply_arm_id_t> &arm_seq() const { return arm_seq_; }
+  const std::vector<second_t> &down_travel_seq() const {
+    return down_travel_seq_;
+  }
+  const std::vector<second_t> &up_travel_seq() const { return up_travel_seq_; }
+  // 查找时刻t所在时段的追踪间隔, t不在任何时段内时返回0
+  static second_t find_departure_T(second_t t, const departure_T_t &dT);
+
+private:
+  static std::vector<std::string> validate(const LineData &data);
+};
+
+} // namespace yaohui
+
+#endif // YAOHUI_MASTER_THESIS_LINEMODEL_HPP
@@ -0,0 +1,48 @@
+#ifndef YAOHUI_MASTER_THESIS_METROPOLISCHAIN_HPP
+#define YAOHUI_MASTER_THESIS_METROPOLISCHAIN_HPP
+
+#include "Evaluator.hpp"
+#include <random>
+#include <vector>
+
+namespace yaohui {
+
+/**
+ * @brief 在Evaluator上运行的Metropolis链
+ *
+ * 每一步由Evaluator::random_move抽取一个单基因移动, 复用率不降低时接受,
+ * 降低gain时以exp(gain / T)的概率接受, 否则撤销. 链记录经过的最好解,
+ * 只在离开最好解时才保存其染色体, 避免每次改进都复制.
+ * 模拟退火和并行退火共用.
+ */
+class MetropolisChain {
+private:
+  Evaluator *ev_;                          // 当前状态, 不归链所有
+  double current_ = 0.0;                   // 当前解的复用率
+  double best_ = 0.0;                      // 最好解的复用率
+  std::vector<second_t> best_genome_ = {}; // 最好解
+  bool at_best_ = false;    // 当前解即最好解且尚未保存
+  size_t resync_every_;     // 每隔多少步重新累计一次分布曲线
+  size_t since_resync_ = 0; // 上次重新累计以来的步数
+
+public:
+  MetropolisChain() = delete;
+  explicit MetropolisChain(Evaluator *ev, size_t resync_every = 100000);
+
+  // 以温度T进行一步, 返回是否接受了移动
+  bool step(std::default_random_engine &e, double T);
+  // 改为在ev上继续, 用于交换状态和重启. 调用前应先save_best
+  void reset(Evaluator *ev);
+  // 当前解即最好解时保存其染色体
+  void save_best();
+
+  Evaluator *state() const;
+  double current() const;
+  double best() const;
+  // 最好解的染色体, 调用前应先save_best
+  const std::vector<second_t> &best_genome() const;
+};
+
+} // namespace yaohui
+
+#endif // YAOHUI_MASTER_THESIS_METROPOLISCHAIN_HPP
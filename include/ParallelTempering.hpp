@@ -0,0 +1,89 @@
+#ifndef YAOHUI_MASTER_THESIS_PARALLELTEMPERING_HPP
+#define YAOHUI_MASTER_THESIS_PARALLELTEMPERING_HPP
+
+#include "Evaluator.hpp"
+#include "Individual.hpp"
+#include "TimetableConfig.hpp"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace yaohui {
+
+/**
+ * @brief 并行退火(副本交换)优化器
+ *
+ * 每个温度层一条Metropolis链, 各占一个线程, 温度由t_min到t_max按等比数列
+ * 排列. 每隔exchange_every步进行一轮交换: 第r轮中温度层k与k+1(k与r同奇偶)
+ * 以概率min(1, exp((1/T_k - 1/T_{k+1}) * (f_{k+1} - f_k)))交换状态, f为
+ * 复用率. 相邻两层通过无锁的交换槽交接Evaluator指针, 不复制状态, 互不相关
+ * 的层之间也不需要同步.
+ */
+class ParallelTempering {
+private:
+  // 温度层k与k+1之间的交换槽, 由原子的轮次号发布和应答
+  struct ExchangeSlot {
+    std::atomic<int64_t> posted{-1};  // 上层已发布状态的轮次
+    std::atomic<int64_t> replied{-1}; // 下层已应答的轮次
+    double upper_ratio = 0.0;         // 上层当前解的复用率
+    Evaluator *upper_state = nullptr; // 上层的当前状态
+    Evaluator *lower_state = nullptr; // 下层的当前状态
+    bool swapped = false;             // 本轮是否交换
+  };
+
+  // 一个温度层的运行结果
+  struct LevelResult {
+    double current = 0.0;         // 结束时的复用率
+    double best = 0.0;            // 经过的最好解的复用率
+    std::vector<second_t> genome; // 经过的最好解
+    uint64_t swap_attempts = 0;   // 与第level + 1层尝试交换的次数
+    uint64_t swap_accepted = 0;   // 与第level + 1层交换成功的次数
+  };
+
+  size_t steps_ = 1000000;        // 每条链的步数
+  size_t replica_cnt_ = 0;        // 温度层数目
+  double t_min_ = 1e-6;           // 最低温度
+  double t_max_ = 1e-3;           // 最高温度
+  size_t exchange_every_ = 10000; // 每隔多少步交换一次
+  unsigned seed_ = 0;             // 各温度层种子的来源
+  std::vector<double> temperatures_ = {}; // 各层的温度
+  // 各条链的状态, 交换后状态与温度层不再一一对应
+  std::vector<std::unique_ptr<Evaluator>> states_ = {};
+  std::unique_ptr<ExchangeSlot[]> slots_; // 相邻层的交换槽
+  std::vector<LevelResult> results_ = {}; // 各层的结果
+  Individual first_individual_;           // 初始解
+  Individual best_individual_;            // 最好的解
+
+public:
+  ParallelTempering() = delete;
+  ParallelTempering(const ParallelTempering &) = delete;
+  ParallelTempering &operator=(const ParallelTempering &) = delete;
+  /**
+   * @param steps 每条链的步数
+   * @param replica_cnt 温度层数目, 0为硬件线程数
+   * @param start_config 各条链的初始染色体
+   */
+  ParallelTempering(size_t steps, size_t replica_cnt, double t_min,
+                    double t_max, size_t exchange_every,
+                    const TimetableConfig &start_config = TimetableConfig());
+  // 各温度层的种子由seed导出, 相同的种子和层数得到相同的各层随机数序列
+  ParallelTempering(size_t steps, size_t replica_cnt, double t_min,
+                    double t_max, size_t exchange_every,
+                    const TimetableConfig &start_config, unsigned seed);
+
+  const Individual &individual_before_optimize() const;
+  const Individual &individual_after_optimize() const;
+  void do_optimization();
+  // 输出各温度层的温度、结果和交换接受率, 写入成功时返回true
+  bool output_optimization_result(
+      const std::string &f_name = "tempering-process-data.csv") const;
+
+private:
+  LevelResult run_level(size_t level, unsigned seed);
+};
+
+} // namespace yaohui
+
+#endif // YAOHUI_MASTER_THESIS_PARALLELTEMPERING_HPP
@@ -0,0 +1,67 @@
+#ifndef YAOHUI_MASTER_THESIS_PERFCOUNTERS_HPP
+#define YAOHUI_MASTER_THESIS_PERFCOUNTERS_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace yaohui {
+
+// 采样的硬件事件
+enum class PerfEvent {
+  kCycles,       // CPU周期
+  kInstructions, // 退役的指令数
+  kCacheMisses,  // 末级缓存未命中
+  kBranchMisses, // 分支预测失败
+  kCount
+};
+
+constexpr size_t kPerfEventCnt = static_cast<size_t>(PerfEvent::kCount);
+
+using perf_values_t = std::array<uint64_t, kPerfEventCnt>;
+
+// 一次组读数: 各事件的累计数值, 以及组被启用和实际在PMU上计数的累计时间
+// (ns). running小于enabled说明组与其他事件分时复用了PMU, 数值只覆盖
+// running的时段
+struct PerfReading {
+  perf_values_t values;
+  uint64_t time_enabled;
+  uint64_t time_running;
+};
+
+const char *perf_event_name(PerfEvent event);
+
+/**
+ * @brief 调用线程的一组硬件性能计数器
+ *
+ * 通过Linux的perf_event_open打开, 只统计本线程在用户态的事件, 不依赖外部
+ * 工具. 所有事件在同一个组内, 一次read即可同时读出. 某个事件打不开(例如
+ * 虚拟机没有PMU, 或perf_event_paranoid过高)时只有该事件不可用, 读数为0;
+ * 其他平台上所有事件都不可用.
+ */
+class PerfCounters {
+private:
+  std::array<int, kPerfEventCnt> fds_;      // 各事件的文件描述符, -1为不可用
+  std::array<size_t, kPerfEventCnt> slots_; // 各事件在组读数中的位置
+  int leader_ = -1;                         // 组长的文件描述符
+  size_t member_cnt_ = 0;                   // 组内成功打开的事件数
+  std::string error_;                       // 第一个打开失败的原因
+
+public:
+  PerfCounters(const PerfCounters &) = delete;
+  PerfCounters &operator=(const PerfCounters &) = delete;
+  PerfCounters();
+  ~PerfCounters();
+
+  bool available(PerfEvent event) const;
+  bool any_available() const { return member_cnt_ != 0; }
+  // 打开失败的原因, 全部成功时为空
+  const std::string &error() const { return error_; }
+  // 读取各事件自打开以来的累计数值和计时, 失败时返回false
+  bool read(PerfReading &reading) const;
+};
+
+} // namespace yaohui
+
+#endif // YAOHUI_MASTER_THESIS_PERFCOUNTERS_HPP
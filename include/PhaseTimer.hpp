@@ -0,0 +1,116 @@
+#ifndef YAOHUI_MASTER_THESIS_PHASETIMER_HPP
+#define YAOHUI_MASTER_THESIS_PHASETIMER_HPP
+
+#include "PerfCounters.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace yaohui {
+
+// 被计时的阶段, 除kMove外均为遗传算法一代中的阶段
+enum class Phase {
+  kBirth,       // 主线程分发繁殖任务并收集子代(含等待)
+  kSelection,   // 按权重选择父母(random_choose)
+  kCrossover,   // 交叉(parents_cross, 不含评价)
+  kEvaluation,  // 评价(Individual::update_score)
+  kMove,        // 增量评价(Evaluator的移动), 用于退火和局部搜索
+  kMutation,    // 变异(child_mutate, 不含评价)
+  kSort,        // 按适应度排序
+  kLocalSearch, // 模因局部搜索
+  kStatistics,  // 统计每代的适应度
+  kLogging,     // 输出日志
+  kCheckpoint,  // 写检查点
+  kCount
+};
+
+constexpr size_t kPhaseCnt = static_cast<size_t>(Phase::kCount);
+
+const char *phase_name(Phase phase);
+
+// 各阶段累计的时间、进入次数、堆分配和硬件计数. 分配数组的最后一项为不在
+// 任何阶段内的分配, 阶段名为"other"
+struct PhaseTotals {
+  std::array<uint64_t, kPhaseCnt> ns;              // 各阶段的独占时间(纳秒)
+  std::array<uint64_t, kPhaseCnt> calls;           // 各阶段的进入次数
+  std::array<uint64_t, kPhaseCnt + 1> alloc_cnt;   // 各阶段的分配次数
+  std::array<uint64_t, kPhaseCnt + 1> alloc_bytes; // 各阶段分配的字节数
+  std::array<perf_values_t, kPhaseCnt> perf;       // 各阶段独占的硬件计数
+};
+
+/**
+ * @brief 按阶段计时的作用域
+ *
+ * 构造时进入phase, 析构时退出. 嵌套时只把时间计入最内层的阶段, 例如交叉中
+ * 调用的评价只计入kEvaluation. 计数器按线程分开, 每个线程只写自己的计数器,
+ * 不需要同步; 线程退出后其计数器留给之后的线程复用, 已累计的数值保留.
+ * 定义YAOHUI_PHASE_TIMERS时才启用, 否则YAOHUI_PHASE_SCOPE展开为空.
+ * 定义YAOHUI_ALLOC_TRACKING时, 堆分配也按线程当前所在的阶段计数.
+ * 调用enable_perf_counters后, 每次进出阶段还读取一次本线程的硬件计数器,
+ * 差值同样只计入最内层的阶段.
+ */
+class ScopedPhase {
+private:
+  Phase phase_;  // 本作用域的阶段
+  Phase parent_; // 外层阶段, 无外层时为Phase::kCount
+
+public:
+  ScopedPhase(const ScopedPhase &) = delete;
+  ScopedPhase &operator=(const ScopedPhase &) = delete;
+  explicit ScopedPhase(Phase phase);
+  ~ScopedPhase();
+
+  /**
+   * @brief 汇总所有线程自上次collect以来的计数
+   *
+   * 只应在工作线程的结果已经取回(future::get)之后调用,
+   * 此时它们写入的计数都已可见.
+   */
+  static PhaseTotals collect();
+  /**
+   * @brief 把一次堆分配计入本线程当前所在的阶段
+   *
+   * 由替换的全局operator new调用, 不分配内存也不加锁.
+   */
+  static void note_allocation(size_t bytes);
+  // 编译时是否同时定义了YAOHUI_ALLOC_TRACKING和YAOHUI_PHASE_TIMERS
+  // (替换全局operator new), 只定义前者时分配无从归属, 视为不可用
+  static bool allocation_tracking();
+  /**
+   * @brief 启用硬件性能计数器
+   *
+   * 应在进入任何阶段之前调用. 先在调用线程上试打开, 一个事件都不可用时
+   * 输出原因并返回false, 此后的计时不受影响. 之后每个线程第一次进入阶段时
+   * 打开自己的计数器.
+   */
+  static bool enable_perf_counters();
+  static bool perf_counters_enabled();
+  // 启用时试打开的结果, 不可用的事件读数恒为0
+  static bool perf_event_available(PerfEvent event);
+  // 是否有时段因分时复用PMU而按time_enabled / time_running放大了计数
+  static bool perf_counts_scaled();
+  // 是否有时段启用了计数器却完全没有计数, 此时各阶段的计数偏低, 不可用
+  static bool perf_counts_unmeasured();
+};
+
+/**
+ * @brief 输出各阶段硬件计数的汇总
+ *
+ * 每个阶段一行: 周期、指令、IPC, 以及每千条指令的缓存未命中和分支预测失败
+ * (MPKI). 未启用硬件计数器时不输出. 计数器与其他事件分时复用PMU时计数按
+ * 比例放大, 有时段完全没有计数时显示为n/a.
+ */
+void print_perf_summary(const std::array<perf_values_t, kPhaseCnt> &perf);
+
+} // namespace yaohui
+
+#ifdef YAOHUI_PHASE_TIMERS
+#define YAOHUI_PHASE_CONCAT_(a, b) a##b
+#define YAOHUI_PHASE_CONCAT(a, b) YAOHUI_PHASE_CONCAT_(a, b)
+#define YAOHUI_PHASE_SCOPE(phase)                                              \
+  ::yaohui::ScopedPhase YAOHUI_PHASE_CONCAT(phase_scope_, __LINE__)(phase)
+#else
+#define YAOHUI_PHASE_SCOPE(phase) ((void)0)
+#endif
+
+#endif // YAOHUI_MASTER_THESIS_PHASETIMER_HPP
@@ -0,0 +1,99 @@
+#ifndef YAOHUI_MASTER_THESIS_QUASIRANDOMSAMPLER_HPP
+#define YAOHUI_MASTER_THESIS_QUASIRANDOMSAMPLER_HPP
+
+#include "Individual.hpp"
+#include "ThreadPool.hpp"
+#include "TimetableConfig.hpp"
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace yaohui {
+
+// 设计空间的抽样方法
+enum class SamplingMethod {
+  kSobol,         // 随机数字平移的Sobol序列
+  kLatinHypercube // 每批样本构成一个拉丁超立方
+};
+
+// 由名称"sobol"或"lhs"解析抽样方法, 名称无效时返回false
+bool parse_sampling_method(const std::string &name, SamplingMethod &method);
+
+/**
+ * @brief 运行图染色体的有界设计空间
+ *
+ * 把[0, 1)^dimension中的点映射为染色体, 各维度依次为:
+ *   下行第1..n-1列车的发车间隔, 上行第1..n-1列车的发车间隔,
+ *   各下行运行线中间车站的停站时长, 各上行运行线中间车站的停站时长.
+ * 发车间隔在前车发车时刻的最小/最大追踪间隔之间取整数, 停站时长在
+ * 停站时长上下限之间取整数, 与Individual的随机化使用相同的范围.
+ */
+class DesignSpace {
+private:
+  TimetableConfig base_; // 首班车发车时刻和首末站停站时长取自base_
+  size_t inner_cnt_ = 0; // 中间车站数目
+
+public:
+  explicit DesignSpace(TimetableConfig base);
+  size_t dimension() const;
+  TimetableConfig decode(const double *u) const;
+};
+
+/**
+ * @brief Sobol低差异序列
+ *
+ * 本原多项式按次数由低到高逐个枚举生成, 初始方向数在满足奇数且小于2^k的
+ * 条件下随机选取, 因此维度数不受预置表的限制. 输出再异或一个随机的数字
+ * 平移, 保留序列的均匀性而避免首个点落在原点.
+ */
+class SobolSequence {
+private:
+  size_t dimension_;                 // 维度数
+  std::vector<uint32_t> directions_; // 方向数, 每维32个
+  std::vector<uint32_t> shift_;      // 数字平移
+  std::vector<uint32_t> state_;      // 当前点(格雷码顺序)
+  uint64_t index_ = 0;               // 已输出的点数
+
+public:
+  SobolSequence(size_t dimension, unsigned seed);
+  size_t dimension() const;
+  void next(double *out); // 输出下一个点的dimension个坐标
+};
+
+/**
+ * @brief 在设计空间中成批生成并评价染色体
+ *
+ * 可以代替逐个独立均匀抽样的随机漫步, 用于生成初始种群和基准样本. 点的生成
+ * 在调用线程中按顺序进行, 结果与线程数无关; 解码和评分交给线程池并行执行.
+ */
+class QuasiRandomSampler {
+private:
+  SamplingMethod method_;
+  DesignSpace space_;
+  std::unique_ptr<SobolSequence> sobol_;
+  std::default_random_engine e_;     // 拉丁超立方的排列和抖动
+  std::unique_ptr<ThreadPool> pool_; // 评分用线程池
+
+public:
+  QuasiRandomSampler() = delete;
+  QuasiRandomSampler(const QuasiRandomSampler &) = delete;
+  QuasiRandomSampler &operator=(const QuasiRandomSampler &) = delete;
+  /**
+   * @param base 设计空间的基础染色体
+   * @param thread_cnt 评分线程数, 0为硬件线程数
+   */
+  QuasiRandomSampler(SamplingMethod method, TimetableConfig base,
+                     unsigned seed, size_t thread_cnt = 0);
+
+  size_t dimension() const;
+  // 下一批cnt个[0, 1)^dimension中的点, 按行存放
+  std::vector<double> next_points(size_t cnt);
+  // 下一批cnt个已评分的个体, 顺序与next_points相同
+  std::vector<Individual> next_batch(size_t cnt);
+};
+
+} // namespace yaohui
+
+#endif // YAOHUI_MASTER_THESIS_QUASIRANDOMSAMPLER_HPP
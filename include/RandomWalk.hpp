@@ -2,9 +2,14 @@
 #define YAOHUI_MASTER_THESIS_RANDOMWALK_HPP
 
 #include "Individual.hpp"
+#include "QuasiRandomSampler.hpp"
+#include "SampleStats.hpp"
 #include "TimetableConfig.hpp"
+#include <chrono>
 #include <fstream>
+#include <random>
 #include <string>
+#include <vector>
 
 namespace yaohui {
 
@@ -12,18 +17,33 @@ class RandomWalk {
 private:
   size_t pop_cnt_ = 0;
   size_t walk_times_ = 0;
+  size_t thread_cnt_ = 0;                                // 线程数目, 0为自动
+  std::vector<std::default_random_engine> engines_ = {}; // 各个体的随机引擎
   std::vector<Individual> pop_ = {};
   std::vector<std::vector<double>> rw_result_ = {}; // 保存适应度
   Individual best_individual_;                      // 保存最优个体
+  bool online_ = false;                             // 在线统计, 不保存每个样本
+  size_t best_k_ = 0;                               // 在线模式保留的最优个体数
+  std::string spill_name_;                          // 原始样本的溢出文件名
+  bool spill_written_ = false;                      // 溢出文件是否写入成功
+  RunningStats stats_;                              // 所有样本的均值和方差
+  TDigest digest_;                                  // 所有样本的分位数草图
+  Histogram histogram_;                             // 所有样本的直方图
+  std::vector<Individual> best_individuals_ = {};   // 最优的best_k_个个体
+  bool sampled_ = false;                            // 用低差异序列代替随机抽样
+  SamplingMethod sampling_method_ = SamplingMethod::kSobol;
 
-  void init_pop() {
-    // 生成n个个体
-    std::vector<Individual> pop;
-    pop.reserve(pop_cnt_);
+  void init_pop(unsigned seed) {
+    // 生成n个个体, 每个个体使用独立的随机数引擎, 种子由seed派生
+    std::seed_seq seeds{seed};
+    std::vector<unsigned> engine_seeds(pop_cnt_);
+    seeds.generate(engine_seeds.begin(), engine_seeds.end());
+    engines_.reserve(pop_cnt_);
+    pop_.reserve(pop_cnt_);
+    TimetableConfig default_config;
     while (pop_.size() < pop_cnt_) {
-      TimetableConfig default_config;
-      Individual default_individual(default_config);
-      pop_.push_back(default_individual);
+      engines_.emplace_back(engine_seeds[pop_.size()]);
+      pop_.emplace_back(default_config, engines_.back());
     }
   }
 
@@ -35,12 +55,44 @@ public:
   RandomWalk &operator=(const RandomWalk &) = default;
   RandomWalk &operator=(RandomWalk &&) = default;
 
-  RandomWalk(size_t pop_cnt, size_t walk_times);
+  RandomWalk(size_t pop_cnt, size_t walk_times, size_t thread_cnt = 0);
+  // 各个体的随机数引擎由固定的seed派生, 结果与线程数无关
+  RandomWalk(size_t pop_cnt, size_t walk_times, size_t thread_cnt,
+             unsigned seed);
+
+  /**
+   * @brief 启用在线统计模式
+   *
+   * 不再保存每个样本, 只保留均值方差、分位数草图、直方图和最好的best_k个
+   * 个体, 内存占用与样本数无关. spill_name非空时原始样本另写入该二进制文件.
+   */
+  void set_online(size_t best_k = 10, const std::string &spill_name = "");
+  /**
+   * @brief 用Sobol序列或拉丁超立方代替独立均匀抽样
+   *
+   * 每一步生成一批pop_cnt个样本并行评分, 第i个样本计入第i个个体.
+   * 在线模式下溢出文件的每个块为一步的全部样本, 块的来源为步数.
+   */
+  void set_sampling(SamplingMethod method);
 
   void do_random_walk();
 
-  void output_process_result(const std::string &s) const;
-  void output_plot_data(const std::string &s) const;
+  // 各输出函数在文件写入成功时返回true
+  bool output_process_result(const std::string &s) const;
+  bool output_plot_data(const std::string &s) const;
+  // 在线模式下输出汇总统计量和直方图
+  bool output_statistics(const std::string &s) const;
+  bool output_histogram(const std::string &s) const;
+  // 上一次随机漫步的溢出文件是否已完整写入
+  bool spill_written() const;
+  // 在线模式下最好的若干个体, 按适应度由大到小排列
+  const std::vector<Individual> &best_individuals() const;
+
+private:
+  void do_online_walk();
+  void do_sampled_walk();
+  void reset_online();
+  void pick_best_individual();
 };
 
 } // namespace yaohui
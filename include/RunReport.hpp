@@ -0,0 +1,66 @@
+#ifndef YAOHUI_MASTER_THESIS_RUNREPORT_HPP
+#define YAOHUI_MASTER_THESIS_RUNREPORT_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace yaohui {
+
+/**
+ * @brief 一次运行的机器可读汇总, 输出为json
+ *
+ * 记录进化参数、种子、线路指纹, 各优化引擎的墙钟时间、CPU时间、评价次数和
+ * 吞吐率, 进程的峰值常驻内存, 最优和默认运行图的复用率以及输出的文件.
+ * CPU时间为整个进程(所有线程)的用户态与内核态时间之和. 评价次数只计完整
+ * 评价(Individual::update_score), 不含Evaluator的增量移动.
+ */
+class RunReport {
+private:
+  // 一个引擎的计时结果
+  struct EngineRun {
+    std::string name;     // 引擎名
+    double wall_seconds;  // 墙钟时间
+    double cpu_seconds;   // 进程的CPU时间
+    uint64_t evaluations; // 完整评价次数
+  };
+
+  size_t gene_cnt_ = 200;                 // 进化次数
+  size_t population_cnt_ = 100;           // 种群规模
+  double cross_p_ = 0.8;                  // 交叉概率
+  double mutate_p_ = 0.05;                // 变异概率
+  double alpha_ = 0.015;                  // 选择参数alpha
+  size_t thread_cnt_ = 8;                 // 线程数目
+  unsigned seed_ = 0;                     // 随机数种子
+  bool has_seed_ = true;                  // 种子是否决定了本次运行
+  std::vector<EngineRun> engines_ = {};   // 已结束的引擎
+  std::vector<std::string> outputs_ = {}; // 输出的文件
+  double best_reuse_ratio_ = 0.0;         // 最优运行图的复用率
+  double default_reuse_ratio_ = 0.0;      // 默认运行图的复用率
+
+  std::string running_ = {};                       // 正在计时的引擎名
+  std::chrono::steady_clock::time_point wall_beg_; // 开始计时的时刻
+  double cpu_beg_ = 0.0;                           // 开始计时时的CPU时间
+  uint64_t eval_beg_ = 0;                          // 开始计时时的评价次数
+
+public:
+  RunReport() = delete;
+  RunReport(size_t gene_cnt, size_t population_cnt, double cross_p,
+            double mutate_p, double alpha, size_t thread_cnt, unsigned seed);
+
+  // 开始为引擎name计时, 同一时刻只有一个引擎在计时
+  void begin_engine(const std::string &name);
+  // 结束当前引擎的计时, 返回其墙钟时间(秒)
+  double end_engine();
+  void set_reuse_ratio(double best, double default_ratio);
+  // 随机数状态不由种子决定(如从检查点恢复)时调用, 报告中的种子为null
+  void clear_seed();
+  // 记录一个已成功写入的输出文件
+  void add_output(const std::string &f_name);
+  bool write_to_file(const std::string &json_name) const;
+};
+
+} // namespace yaohui
+
+#endif // YAOHUI_MASTER_THESIS_RUNREPORT_HPP
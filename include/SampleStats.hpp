@@ -0,0 +1,125 @@
+#ifndef YAOHUI_MASTER_THESIS_SAMPLESTATS_HPP
+#define YAOHUI_MASTER_THESIS_SAMPLESTATS_HPP
+
+#include "BufferedFile.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace yaohui {
+
+/**
+ * @brief 单遍计算均值和方差(Welford算法), 内存占用与样本数无关
+ *
+ * 两个对象可以用merge合并(Chan等人的并行公式), 便于多线程各自统计后汇总.
+ */
+class RunningStats {
+private:
+  uint64_t count_ = 0; // 样本数
+  double mean_ = 0.0;  // 均值
+  double m2_ = 0.0;    // 离差平方和
+  double min_ = 0.0;   // 最小值
+  double max_ = 0.0;   // 最大值
+
+public:
+  void add(double x);
+  void merge(const RunningStats &other);
+  uint64_t count() const;
+  double mean() const;
+  double variance() const; // 样本方差(n-1), 样本数小于2时为0
+  double stddev() const;
+  double min() const;
+  double max() const;
+};
+
+/**
+ * @brief 分位数草图(合并式t-digest)
+ *
+ * 样本先放入缓冲区, 缓冲区满时与已有质心一起排序并按k1尺度函数合并,
+ * 质心数目约为compression的量级. 两端质心较小, 所以极端分位数的误差也很小.
+ */
+class TDigest {
+private:
+  struct Centroid {
+    double mean;
+    double weight;
+  };
+
+  double compression_;              // 压缩参数delta
+  std::vector<Centroid> centroids_; // 按均值升序排列的质心
+  std::vector<Centroid> buffer_;    // 尚未合并的样本
+  double total_weight_ = 0.0;       // 已合并的总权重
+  double min_ = 0.0;                // 最小值
+  double max_ = 0.0;                // 最大值
+
+public:
+  explicit TDigest(double compression = 100.0);
+  void add(double x, double weight = 1.0);
+  void merge(const TDigest &other);
+  void compress(); // 把缓冲区中的样本合并到质心
+  // 估计分位数q(0 <= q <= 1), 没有样本时返回NaN
+  double quantile(double q) const;
+  size_t centroid_cnt() const;
+};
+
+/**
+ * @brief 等宽直方图, 区间[lo, hi)之外的样本分别计入下溢和上溢
+ */
+class Histogram {
+private:
+  double lo_;                    // 下界
+  double hi_;                    // 上界
+  std::vector<uint64_t> counts_; // 各个桶的计数
+  uint64_t underflow_ = 0;       // 小于lo的样本数
+  uint64_t overflow_ = 0;        // 不小于hi的样本数
+
+public:
+  Histogram(double lo, double hi, size_t bin_cnt);
+  void add(double x);
+  void merge(const Histogram &other); // 两者的区间和桶数必须相同
+  size_t bin_cnt() const;
+  double bin_begin(size_t i) const;
+  double bin_end(size_t i) const;
+  uint64_t count(size_t i) const;
+  uint64_t underflow() const;
+  uint64_t overflow() const;
+};
+
+/*
+ * 原始样本溢出文件的二进制格式(小端序):
+ *
+ *   char   magic[8]        "YHSAMPLE"
+ *   uint32 version         1
+ *   uint32 reserved        0
+ *   块...
+ *
+ * 每个块为一个样本来源(如随机漫步的个体序号)的一段连续样本:
+ *   uint32 source          样本来源
+ *   uint32 cnt             样本个数
+ *   uint64 first_index     第一个样本在该来源中的序号
+ *   double values[cnt]
+ * 多个来源的块可以交错出现.
+ */
+class SampleSpill {
+private:
+  std::mutex mutex_; // 多线程写入时保护file_
+  BufferedFile file_;
+
+public:
+  SampleSpill() = delete;
+  SampleSpill(const SampleSpill &) = delete;
+  SampleSpill &operator=(const SampleSpill &) = delete;
+  explicit SampleSpill(const std::string &f_name);
+
+  bool is_open() const;
+  // 线程安全
+  void append(uint32_t source, uint64_t first_index, const double *values,
+              size_t cnt);
+  bool close();
+};
+
+} // namespace yaohui
+
+#endif // YAOHUI_MASTER_THESIS_SAMPLESTATS_HPP
@@ -0,0 +1,59 @@
+#ifndef YAOHUI_MASTER_THESIS_SCALINGBENCHMARK_HPP
+#define YAOHUI_MASTER_THESIS_SCALINGBENCHMARK_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace yaohui {
+
+/**
+ * @brief 端到端的线程扩展性基准测试
+ *
+ * 以固定种子依次用1..max_threads个线程运行main中的工作负载(遗传算法和随机
+ * 漫步), 记录墙钟时间、评价次数和吞吐率. 加速比为n线程与单线程的吞吐率
+ * 之比, 并行效率为加速比除以n. 不同线程数下遗传算法的子代划分不同, 进化
+ * 过程并不完全相同, 因此以吞吐率而不是总时长比较.
+ */
+class ScalingBenchmark {
+private:
+  // 一个线程数下的测量结果
+  struct ScalingPoint {
+    size_t thread_cnt = 0;              // 线程数目
+    double ga_seconds = 0.0;            // 遗传算法进化的墙钟时间
+    uint64_t ga_evaluations = 0;        // 遗传算法进化中的评价次数
+    double ga_evals_per_second = 0.0;   // 遗传算法的吞吐率
+    double ga_speedup = 0.0;            // 遗传算法的加速比
+    double ga_efficiency = 0.0;         // 遗传算法的并行效率
+    double best_fitness = 0.0;          // 末代最好的适应度
+    double walk_seconds = 0.0;          // 随机漫步的墙钟时间
+    uint64_t walk_evaluations = 0;      // 随机漫步中的评价次数
+    double walk_evals_per_second = 0.0; // 随机漫步的吞吐率
+    double walk_speedup = 0.0;          // 随机漫步的加速比
+    double walk_efficiency = 0.0;       // 随机漫步的并行效率
+  };
+
+  size_t gene_cnt_ = 10;                  // 进化次数
+  size_t population_cnt_ = 100;           // 种群规模
+  double cross_p_ = 0.8;                  // 交叉概率
+  double mutate_p_ = 0.05;                // 变异概率
+  double alpha_ = 0.015;                  // 选择参数alpha
+  size_t walk_times_ = 10;                // 随机漫步每个个体的步数
+  unsigned seed_ = 20230101;              // 遗传算法和随机漫步的种子
+  std::vector<ScalingPoint> points_ = {}; // 各线程数的结果
+
+public:
+  ScalingBenchmark() = delete;
+  ScalingBenchmark(size_t gene_cnt, size_t population_cnt, double cross_p,
+                   double mutate_p, double alpha, size_t walk_times,
+                   unsigned seed);
+
+  // 依次以1..max_threads个线程运行
+  void run(size_t max_threads);
+  void print_summary() const;
+  bool write_to_file(const std::string &json_name) const;
+};
+
+} // namespace yaohui
+
+#endif // YAOHUI_MASTER_THESIS_SCALINGBENCHMARK_HPP
@@ -0,0 +1,82 @@
+#ifndef YAOHUI_MASTER_THESIS_SIMULATEDANNEALING_HPP
+#define YAOHUI_MASTER_THESIS_SIMULATEDANNEALING_HPP
+
+#include "Evaluator.hpp"
+#include "Individual.hpp"
+#include "TimetableConfig.hpp"
+#include <random>
+#include <string>
+#include <vector>
+
+namespace yaohui {
+
+// 退火的降温方式
+enum class CoolingSchedule {
+  kGeometric, // 温度按等比数列由t_begin降到t_end
+  kLinear     // 温度按等差数列由t_begin降到t_end
+};
+
+// 由名称"geometric"或"linear"解析降温方式, 名称无效时返回false
+bool parse_cooling_schedule(const std::string &name,
+                            CoolingSchedule &schedule);
+
+/**
+ * @brief 模拟退火优化器
+ *
+ * 与Solver使用相同的染色体和复用率, 以MetropolisChain在逐步降低的温度下
+ * 搜索发车时刻或停站时长的单基因移动. 共进行restarts轮退火, 第一轮从初始
+ * 染色体出发, 之后每轮从此前最好的解出发并重新升温.
+ */
+class SimulatedAnnealing {
+private:
+  // 过程记录的一行
+  struct Record {
+    size_t run;         // 第几轮退火
+    size_t step;        // 本轮已进行的步数
+    double temperature; // 当前温度
+    double current;     // 当前解的复用率
+    double best;        // 目前最好解的复用率
+    double accepted;    // 上次记录以来的接受率
+  };
+
+  size_t steps_ = 1000000; // 每轮退火的步数
+  size_t restarts_ = 4;     // 退火轮数
+  double t_begin_ = 1e-3;   // 初始温度
+  double t_end_ = 1e-6;     // 终止温度
+  CoolingSchedule schedule_ = CoolingSchedule::kGeometric;
+  size_t resync_every_ = 100000;     // 每隔多少步重新累计分布曲线
+  size_t record_cnt_ = 1000;         // 每轮记录的过程数据行数
+  std::default_random_engine rng_;   // 随机数引擎
+  Individual first_individual_;      // 初始解
+  Individual best_individual_;       // 最好的解
+  std::vector<Record> records_ = {}; // 退火过程
+
+public:
+  SimulatedAnnealing() = delete;
+  SimulatedAnnealing(const SimulatedAnnealing &) = delete;
+  SimulatedAnnealing &operator=(const SimulatedAnnealing &) = delete;
+  // 从标准运行图出发
+  SimulatedAnnealing(size_t steps, size_t restarts, double t_begin,
+                     double t_end, CoolingSchedule schedule);
+  // 从给定染色体出发
+  SimulatedAnnealing(size_t steps, size_t restarts, double t_begin,
+                     double t_end, CoolingSchedule schedule,
+                     const TimetableConfig &start_config);
+  // 随机数引擎使用固定种子, 相同的种子得到相同的退火过程
+  SimulatedAnnealing(size_t steps, size_t restarts, double t_begin,
+                     double t_end, CoolingSchedule schedule,
+                     const TimetableConfig &start_config, unsigned seed);
+
+  const Individual &individual_before_optimize() const;
+  const Individual &individual_after_optimize() const;
+  void do_optimization();
+  bool output_optimization_result(
+      const std::string &f_name = "annealing-process-data.csv") const;
+
+private:
+  double temperature(size_t step) const;
+};
+
+} // namespace yaohui
+
+#endif // YAOHUI_MASTER_THESIS_SIMULATEDANNEALING_HPP
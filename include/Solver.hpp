@@ -1,17 +1,42 @@
 #ifndef YAOHUI_MASTER_THESIS_SOLVER_HPP
 #define YAOHUI_MASTER_THESIS_SOLVER_HPP
 
+#include "FitnessLog.hpp"
 #include "Individual.hpp"
+#include "PhaseTimer.hpp"
+#include "QuasiRandomSampler.hpp"
 #include <cmath>
 #include <fstream>
 #include <future>
 #include <iostream>
+#include <memory>
 #include <random>
 #include <string>
 #include <vector>
 
 namespace yaohui {
 
+// Solver的构造参数, 未设置的字段取默认值
+struct SolverOptions {
+  size_t gene_cnt = 200;      // 进化次数
+  size_t population_cnt = 50; // 种群规模
+  double cross_p = 0.8;       // 交叉概率
+  double mutate_p = 0.01;     // 变异概率
+  double alpha = 0.05;        // 选择参数alpha
+  size_t thread_cnt = 8;      // 线程数目
+  bool verbose = true;        // 是否在标准输出打印每一代的进化日志
+  // 主随机数引擎的种子, 相同的种子和线程数得到相同的进化过程.
+  // has_seed为false时种子取时钟
+  bool has_seed = false;
+  unsigned seed = 0;
+  // 非空时以该运行图及其邻域个体作为初始种群(热启动), 只在构造期间使用
+  const TimetableConfig *warm_start = nullptr;
+  // 为true时以Sobol序列或拉丁超立方在设计空间中均匀地生成初始种群.
+  // 两者均未设置时随机生成初始种群
+  bool sampled_init = false;
+  SamplingMethod init_method = SamplingMethod::kSobol;
+};
+
 class Solver {
 
 private:
@@ -21,6 +46,9 @@ private:
   double mutate_p_ = 0.01;             // 变异概率
   double alpha_ = 0.05;                // 选择参数alpha
   size_t thread_cnt_ = 8;              // 线程数目
+  bool verbose_ = true;                // 是否打印每一代的进化日志
+  size_t generation_ = 0;              // 已完成的进化代数
+  std::default_random_engine rng_;     // 主随机数引擎
   std::vector<double> weights_;        // 选择权重
   std::vector<Individual> population_; // 初始种群
   Individual first_best_individual_;   // 初代最好的解
@@ -29,6 +57,18 @@ private:
   std::vector<double> min_fitness_vec_; // 每代最小适应度构成的数组
   std::vector<double> avg_fitness_vec_; // 每代平均适应度构成的数组
   std::vector<std::vector<double>> fitness_vec_; // 每代所有适应度
+  std::string fitness_log_name_;            // 适应度流式日志文件名
+  std::unique_ptr<FitnessLog> fitness_log_; // 适应度流式日志
+  std::string checkpoint_name_;             // 检查点文件名
+  size_t checkpoint_every_ = 0;             // 每隔多少代写一次检查点
+  std::future<bool> pending_checkpoint_;    // 正在后台写入的检查点
+  bool checkpoint_written_ = false;         // 最近一次检查点是否写入成功
+  std::future<void> population_released_;   // 检查点已不再读取种群
+  size_t local_search_k_ = 0;               // 每代做局部搜索的个体数
+  size_t local_search_budget_ = 0;          // 每个个体的评价次数
+  std::vector<double> generation_seconds_;  // 每代的墙钟时间
+  std::vector<PhaseTotals> phase_totals_;   // 每代各阶段的计时
+  friend class BenchmarkAccess;             // 微基准测试直接调用私有的热点函数
 public:
   Solver() = delete;                          // 默认构造
   Solver(const Solver &) = delete;            // 拷贝构造
@@ -36,27 +76,76 @@ public:
   Solver &operator=(const Solver &) = delete; // 拷贝赋值
   Solver &operator=(Solver &&) = delete;      // 移动赋值
   ~Solver() = default;                        // 默认析构
-  Solver(size_t gene_cnt, size_t population_cnt, double cross_p,
-         double mutate_p, double alpha, size_t thread_cnt);
+  explicit Solver(const SolverOptions &options);
+  /**
+   * @brief 从检查点恢复, 之后调用do_optimization继续剩余的进化
+   *
+   * 进化参数、种群、统计数据和随机数引擎状态均取自检查点.
+   *
+   * @throw std::runtime_error 文件无法读取、格式不符或与当前线路不一致
+   */
+  Solver(const std::string &checkpoint_name, size_t thread_cnt);
   const Individual &individual_before_optimize() const;
   const Individual &individual_after_optimize() const;
   void do_optimization();
-  void output_optimization_result(std::string f_name = "processing-data.csv");
+  // 输出进化过程, 各文件(启用流式日志时包括日志)均写入成功时返回true
+  bool output_optimization_result(std::string f_name = "processing-data.csv");
+  /**
+   * @brief 输出每代各阶段的计时表
+   *
+   * 各阶段的时间为所有线程的独占时间之和(秒), 并行的阶段可能超过墙钟时间.
+   * 编译时未定义YAOHUI_PHASE_TIMERS时只有墙钟时间. 定义YAOHUI_ALLOC_TRACKING
+   * 时另有各阶段的分配次数和字节数, 以及每次评价的分配. 启用硬件计数器时
+   * 另有各阶段的周期、指令、缓存未命中和分支预测失败数.
+   */
+  bool output_phase_profile(
+      const std::string &f_name = "phase-profile.csv") const;
+  // 所有代相加后输出各阶段硬件计数的汇总, 见yaohui::print_perf_summary
+  void print_perf_summary() const;
+  // 将每代的适应度流式写入f_name, 不再保存在fitness_vec_中.
+  // 从流式日志运行的检查点恢复时续写f_name中已有的各代.
+  // 文件打不开时返回false, 适应度仍保存在内存中
+  bool set_fitness_log(const std::string &f_name);
+  // 每隔every代(及最后一代)把进化状态写入检查点f_name
+  void set_checkpoint(const std::string &f_name, size_t every);
+  // 最近一次检查点是否已写入成功, do_optimization返回后有效
+  bool checkpoint_written() const;
+  /**
+   * @brief 启用模因局部搜索
+   *
+   * 每代变异之后, 对最好的k个个体并行做首次改进爬山: 随机抽取单个发车时刻
+   * 或停站时长的移动, 复用率提高即接受, 每个个体最多评价budget次.
+   */
+  void set_local_search(size_t k, size_t budget);
 
 private:
   static bool is_better(const Individual &lhs, const Individual &rhs);
   void init_weights();
   void init_population();
+  void init_population(const TimetableConfig &seed_config);
+  void init_population(SamplingMethod method);
+  void record_first_generation();
+  void record_generation_fitness(size_t generation);
+  static Individual perturbed_neighbour(const Individual &seed,
+                                        std::default_random_engine &e);
   static Individual random_choose(const std::vector<Individual> &population,
-                                  const std::vector<double> &weight);
-  static void parents_cross(Individual &father, Individual &mother);
+                                  const std::vector<double> &weight,
+                                  std::default_random_engine &e);
+  static void parents_cross(Individual &father, Individual &mother,
+                            std::default_random_engine &e);
   static std::vector<Individual>
   birth_single_threading(const std::vector<Individual> &population,
                          const std::vector<double> &weights, double cross_p,
-                         size_t child_cnt);
+                         size_t child_cnt, unsigned seed);
 
-  std::vector<Individual> birth_multi_threading() const;
-  void child_mutate(Individual &child) const;
+  std::vector<Individual> birth_multi_threading();
+  void child_mutate(Individual &child);
+  static Individual hill_climb(const Individual &start, size_t budget,
+                               unsigned seed);
+  void local_search();
+  std::vector<char> encode_checkpoint_head() const;
+  void restore_checkpoint(const std::vector<char> &data);
+  void save_checkpoint();
 };
 
 } // namespace yaohui
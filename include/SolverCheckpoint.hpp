@@ -0,0 +1,57 @@
+#ifndef YAOHUI_MASTER_THESIS_SOLVERCHECKPOINT_HPP
+#define YAOHUI_MASTER_THESIS_SOLVERCHECKPOINT_HPP
+
+#include <cstdint>
+
+namespace yaohui {
+
+/*
+ * Solver检查点的二进制格式(小端序):
+ *
+ *   SolverCheckpointHeader                  文件头, 128字节
+ *   int32  stations[station_cnt]            线路车站序列
+ *   char   rng_state[rng_state_size]        主随机数引擎状态(operator<<的文本)
+ *   double max_fitness[generation]          每代最大适应度
+ *   double min_fitness[generation]          每代最小适应度
+ *   double avg_fitness[generation]          每代平均适应度
+ *   double fitness[fitness_row_cnt][population_cnt]   内存中的每代全部适应度
+ *   染色体记录[2 + population_cnt]           初代最优, 末代最优, 当前种群
+ *
+ * 每条染色体记录长度固定, 依次为
+ *   double score
+ *   int32  down_departure[down_missions_cnt]
+ *   int32  up_departure[up_missions_cnt]
+ *   int32  stop_duration[down_missions_cnt + up_missions_cnt][station_cnt]
+ * 停站时长按运行线(先下行后上行)、车站id升序排列.
+ *
+ * 恢复时核对车站序列和线路指纹(LineModel::hash), 供电臂、区间运行时间或
+ * 发车间隔等任何线路参数不同的检查点都会被拒绝.
+ */
+
+constexpr char kSolverCheckpointMagic[8] = {'Y', 'H', 'C', 'K',
+                                            'P', 'T', '\0', '\0'};
+constexpr uint32_t kSolverCheckpointVersion = 2;
+
+struct SolverCheckpointHeader {
+  char magic[8];              // kSolverCheckpointMagic
+  uint32_t version;           // kSolverCheckpointVersion
+  uint32_t station_cnt;       // 车站数目
+  uint64_t generation;        // 已完成的进化代数
+  uint64_t gene_cnt;          // 进化次数
+  uint64_t population_cnt;    // 种群规模
+  uint32_t down_missions_cnt; // 下行运行线数目
+  uint32_t up_missions_cnt;   // 上行运行线数目
+  double cross_p;             // 交叉概率
+  double mutate_p;            // 变异概率
+  double alpha;               // 选择参数alpha
+  uint64_t rng_state_size;    // 随机数引擎状态的字节数
+  uint64_t fitness_row_cnt;   // 保存的全部适应度的代数
+  uint64_t line_model_hash;   // 线路指纹, LineModel::hash()
+  uint64_t reserved[4];       // 保留, 写0
+};
+
+static_assert(sizeof(SolverCheckpointHeader) == 128, "header layout");
+
+} // namespace yaohui
+
+#endif // YAOHUI_MASTER_THESIS_SOLVERCHECKPOINT_HPP
@@ -0,0 +1,51 @@
+#ifndef YAOHUI_MASTER_THESIS_SYNTHETICLINE_HPP
+#define YAOHUI_MASTER_THESIS_SYNTHETICLINE_HPP
+
+#include "BaseDef.hpp"
+#include "LineModel.hpp"
+#include <string>
+#include <vector>
+
+namespace yaohui {
+
+// 合成线路的一个追踪间隔时段
+struct HeadwayPeriod {
+  second_t length;  // 时段长度
+  second_t headway; // 标准追踪间隔
+  second_t slack;   // 最小/最大追踪间隔与标准值之差
+};
+
+// 合成线路的规模和参数, 默认值与内置线路的量级相同
+struct SyntheticLineSpec {
+  size_t station_cnt = 16;           // 车站数目
+  size_t arm_cnt = 4;                // 供电臂数目, 连续的车站划入同一供电臂
+  second_t first_train_time = 19800; // 首班车发车时刻(包含)
+  second_t last_train_time = 84600;  // 末班车发车时刻(不包含), 可超过一天
+  // 从首班车时刻起循环排列的追踪间隔时段, 直到覆盖整个发车窗口
+  std::vector<HeadwayPeriod> headway_pattern = {
+      {5400, 600, 30}, {3600, 240, 30}, {7200, 120, 30}, {3600, 240, 30}};
+  second_t travel_min = 105; // 区间行程时长的下限
+  second_t travel_max = 185; // 区间行程时长的上限
+  second_t stop_min = 30;    // 中间站标准停站时长的下限
+  second_t stop_max = 45;    // 中间站标准停站时长的上限
+  second_t stop_slack = 5;   // 停站时长上下限与标准值之差
+  unsigned seed = 20230101;  // 行程时长和停站时长的随机数种子
+};
+
+/**
+ * @brief 按spec生成合成线路数据
+ *
+ * 车站id为0..station_cnt-1, 依次均分到arm_cnt个供电臂. 区间行程时长(上下行
+ * 相同)和中间站的标准停站时长在给定范围内均匀抽取, 首末站停站时长为0.
+ * 能量曲线与内置线路相同. 结果可直接构造LineModel.
+ *
+ * @throw std::invalid_argument 车站或供电臂数目、范围参数不合法
+ */
+LineData make_synthetic_line(const SyntheticLineSpec &spec);
+
+// 由"<车站数>,<供电臂数>[,<发车窗口小时数>]"解析spec, 格式无效时返回false
+bool parse_synthetic_line(const std::string &text, SyntheticLineSpec &spec);
+
+} // namespace yaohui
+
+#endif // YAOHUI_MASTER_THESIS_SYNTHETICLINE_HPP
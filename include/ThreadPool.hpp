@@ -0,0 +1,61 @@
+#ifndef YAOHUI_MASTER_THESIS_THREADPOOL_HPP
+#define YAOHUI_MASTER_THESIS_THREADPOOL_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace yaohui {
+
+/**
+ * @brief 固定线程数的线程池
+ *
+ * 任务按提交顺序从共享队列中取出执行, 与每个任务都新建线程的std::async相比,
+ * 线程只在构造时创建一次. 析构时先执行完队列中剩余的任务再退出.
+ */
+class ThreadPool {
+private:
+  std::mutex mutex_;                              // 保护tasks_和stop_
+  std::condition_variable cv_;                    // 通知工作线程
+  std::deque<std::function<void()>> tasks_ = {};  // 待执行的任务
+  bool stop_ = false;                             // 是否停止工作线程
+  std::vector<std::thread> workers_ = {};         // 工作线程
+
+public:
+  ThreadPool() = delete;
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+  // thread_cnt为0时使用硬件线程数
+  explicit ThreadPool(size_t thread_cnt);
+  ~ThreadPool();
+
+  size_t size() const; // 工作线程数目
+
+  // 提交一个无参任务, 通过返回的future取得结果或异常
+  template <typename F>
+  std::future<typename std::result_of<F()>::type> submit(F f) {
+    using result_t = typename std::result_of<F()>::type;
+    auto task = std::make_shared<std::packaged_task<result_t()>>(std::move(f));
+    std::future<result_t> fut = task->get_future();
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      tasks_.emplace_back([task] { (*task)(); });
+    }
+    cv_.notify_one();
+    return fut;
+  }
+
+private:
+  void work_loop();
+};
+
+} // namespace yaohui
+
+#endif // YAOHUI_MASTER_THESIS_THREADPOOL_HPP
@@ -20,6 +20,7 @@ private:
   timetable_id_t timetable_id_ = INT32_MIN; // 运行图id
   std::vector<Mission> missions_ = {}; // 运行图包含的运输任务序列
   TimetableConfig config_;             // 运行图的基因
+  friend class BenchmarkAccess;        // 微基准测试直接调用私有的热点函数
 public:
   Timetable() = delete;                              // 默认构造
   Timetable(Timetable &&) = default;                 // 移动构造
@@ -32,12 +33,18 @@ public:
   const std::vector<Mission> &missions() const;
   // 各个供电臂的总能量利用率
   double total_reuse_ratio() const;
+  // 以下输出函数在所有文件写入成功时返回true
   // 输出能量分布曲线
-  void output_energy_distribution(std::string pre_name) const;
-  // 将运行图写至json文件
-  void write_to_file(std::string json_name="timetable.json") const;
+  bool output_energy_distribution(std::string pre_name) const;
+  // 以二进制列存格式输出全部供电臂的能量分布曲线(见EnergyBinaryFormat.hpp)
+  bool output_energy_distribution_binary(
+      std::string f_name = "energy-distribution.bin", bool use_float32 = false,
+      bool zero_run = false) const;
+  // 将运行图写至json文件(流式输出, compact为true时不缩进)
+  bool write_to_file(std::string json_name = "timetable.json",
+                     bool compact = false) const;
   // 输出运行图画图数据
-  void output_plot_data(std::string f_name = "timetable-plot-data.csv") const;
+  bool output_plot_data(std::string f_name = "timetable-plot-data.csv") const;
 
 private:
   std::vector<Station> make_down_stations_vec(size_t down_id);
@@ -52,7 +59,8 @@ private:
   tb_plot_data_t get_plot_data() const;
   // 各个供电臂的产能区间和各个供电臂的用能区间
   std::pair<energy_map_t, energy_map_t> energy_exchange_duration() const;
-  // 各个供电臂的产能分布和各个供电臂的用能分布
+  // 各个供电臂的产能分布和各个供电臂的用能分布,
+  // 有窗口早于0秒时抛出std::out_of_range
   std::pair<energy_distribution_t, energy_distribution_t>
   energy_distribution() const;
 };
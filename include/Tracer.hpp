@@ -0,0 +1,51 @@
+#ifndef YAOHUI_MASTER_THESIS_TRACER_HPP
+#define YAOHUI_MASTER_THESIS_TRACER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace yaohui {
+
+/**
+ * @brief 记录各线程事件的时间线, 输出为Chrome trace格式的json
+ *
+ * 每个线程一个固定容量的环形缓冲区, 只有所属线程写入, 写满后覆盖最早的
+ * 事件. 线程退出后其缓冲区留给之后的线程复用, 因此trace中的一个tid对应
+ * 一个缓冲区而不是一个系统线程. 未启用时TraceScope只读一次原子标志.
+ * 输出的文件可在chrome://tracing或Perfetto中打开.
+ */
+class Tracer {
+public:
+  Tracer() = delete;
+  // 启用记录, capacity为每个线程保留的最近事件数. 应在启动时调用一次
+  static void enable(size_t capacity = 1 << 16);
+  static bool enabled();
+  /**
+   * @brief 把所有缓冲区中的事件写入json文件
+   *
+   * 只应在所有被记录的线程都已结束或空闲时调用.
+   */
+  static bool write_to_file(const std::string &json_name);
+};
+
+// 在作用域内记录一个事件, name和arg_name须为字符串字面量
+class TraceScope {
+private:
+  void *buffer_ = nullptr; // 本线程的缓冲区, 未启用时为空
+  const char *name_;       // 事件名
+  const char *arg_name_;   // 附加参数名, 为空时没有参数
+  int64_t arg_;            // 附加参数
+  uint64_t beg_ns_ = 0;    // 开始时刻
+
+public:
+  TraceScope(const TraceScope &) = delete;
+  TraceScope &operator=(const TraceScope &) = delete;
+  explicit TraceScope(const char *name, const char *arg_name = nullptr,
+                      int64_t arg = 0);
+  ~TraceScope();
+};
+
+} // namespace yaohui
+
+#endif // YAOHUI_MASTER_THESIS_TRACER_HPP
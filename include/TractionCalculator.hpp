@@ -2,22 +2,60 @@
 #define YAOHUI_MASTER_THESIS_TRACTIONCALCULATOR_HPP
 
 #include <cmath>
+#include <cstddef>
 #include <cstdint>
 #include <iostream>
 #include <limits>
 #include <map>
+#include <vector>
 
 namespace yaohui {
 
+// 列车牵引计算的可调参数(默认值即为原车型参数)
+struct TractionParams {
+  double vehicle_m = 4 * 37.4 + 2 * 34.2; // 空车质量(t)
+  int32_t passenger_capacity = 674 * 2;   // 定员载客量(人)
+  double F_const = 352.0;                 // 最大牵引力(kN)
+  double P_limit = 3680.0;                // 最大牵引功率(kW)
+  double F_brake = 384.0;                 // 再生制动阶段制动力(kN)
+  double brake_eta = 0.629;               // 再生制动能量占动能的比
+};
+
 class TractionCalculator {
 public:
+  TractionCalculator() = default;
+  explicit TractionCalculator(const TractionParams &params);
+
   void show() const;
   double v_P_limit() const;       // 功率限制速度(km/h)
   double time_to_P_limit() const; // 从v0=0加速到功率限制阶段初的时间(s)
+  // 最大牵引力是否大于功率限制速度下的阻力, 否则列车到不了功率限制阶段,
+  // time_to_P_limit不会结束
+  bool reaches_P_limit() const;
   // 加速阶段0-tm秒时段内的牵引做功(J)
   std::map<double, double> accelerating_stage_W(double tm) const;
   // 再生制动阶段内0-tm秒的制动回收能量(J)
   std::map<double, double> brake_stage_W(double tm) const;
+  // 加速阶段按秒汇总的牵引做功(kJ), 下标i为第[i, i+1)秒
+  std::vector<double> accelerating_stage_W_per_second(size_t seconds) const;
+  // 再生制动阶段按秒汇总的回收能量(kJ), 下标i为制动开始后第[i, i+1)秒
+  std::vector<double> brake_stage_W_per_second(size_t seconds) const;
+
+  /**
+   * @brief 批量计算: 对速度序列v[0, n)逐点求值, 结果写入out[0, n)
+   *
+   * 与速度无关的系数已在构造时预先算好, 循环体内没有函数调用和分支,
+   * 便于编译器向量化. 运算顺序与对应的逐点函数相同, 结果逐位一致.
+   * v与out不得重叠.
+   *
+   * @param v 列车运行速度序列 (km/h)
+   * @param out 输出序列
+   * @param n 序列长度
+   */
+  void f_w0_batch(const double *v, double *out, size_t n) const; // (N/kN)
+  void f_ws_batch(const double *v, double *out, size_t n) const; // (N/kN)
+  void f_total_batch(const double *v, double *out, size_t n) const; // (kN)
+  std::vector<double> f_total_batch(const std::vector<double> &v) const;
 
 private:
   const int32_t passenger_capacity_ = 674 * 2; // 定员载客量(人)
@@ -26,8 +64,9 @@ private:
   const double MCP_m_ = 37.4;                  // 带司机室的动车质量(t)
   const int32_t T_cnt = 2;                     // 不带司机室的拖车数目
   const double T_m_ = 34.2; // 不带司机室的拖车质量(t)
-  const double train_m_ = passenger_capacity_ * passenger_m_avg_ +
-                          MCP_cnt_ * MCP_m_ + T_cnt * T_m_; // 列车质量 (t)
+  const double vehicle_m_ = MCP_cnt_ * MCP_m_ + T_cnt * T_m_; // 空车质量(t)
+  const double train_m_ =
+      passenger_capacity_ * passenger_m_avg_ + vehicle_m_; // 列车质量 (t)
   const double F_const_ = 352.0;  // 最大牵引力(kN)
   const double P_limit_ = 3680.0; // 最大牵引功率(kW)
   const double g_ = 9.8;          // 重力加速度 m·s^(-2)
@@ -40,6 +79,14 @@ private:
   const double brake_eta_ = 0.629; // 再生制动能量占动能的比
   std::map<int32_t, double> power_time_data_ = {};
 
+  // 与速度无关的项(每个实例只计算一次)
+  // 单位隧道附加阻力的系数, f_ws(v) = ws_coef_ * v^2
+  const double ws_coef_ =
+      ((0.00357 * L_) / train_m_) *
+      pow(1.0 - (1.0 / (1.0 + sqrt((61.475 + 0.177 * (Ls_ - L_)) / L_))), 2);
+  const double wi_ = is_uphill_ ? i_ : -i_; // 单位坡道附加阻力 (N/kN)
+  const double wr_ = 600.0 / r_;            // 单位曲线附加阻力 (N/kN)
+
   /**
    *
    * @param v 列车运行速度 (km/h)
@@ -0,0 +1,77 @@
+#ifndef YAOHUI_MASTER_THESIS_TRACTIONSWEEP_HPP
+#define YAOHUI_MASTER_THESIS_TRACTIONSWEEP_HPP
+
+#include "TractionCalculator.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace yaohui {
+
+// 单个参数组合的计算结果
+struct TractionSweepRecord {
+  TractionParams params;            // 参数组合
+  std::vector<double> consume = {}; // 加速阶段每秒用能(kJ)
+  std::vector<double> produce = {}; // 再生制动阶段每秒产能(kJ)
+  double total_consume = 0.0;       // 加速阶段总用能(kJ)
+  double total_produce = 0.0;       // 再生制动阶段总产能(kJ)
+};
+
+/**
+ * @brief 牵引计算参数扫描
+ *
+ * 对质量, 定员, 最大牵引力, 最大牵引功率, 制动力和再生效率六个参数的取值
+ * 范围做笛卡尔积, 多线程计算每个参数组合的用能/产能曲线, 结果写入一个按列
+ * 排列的csv文件(每行一个参数组合).
+ */
+class TractionSweep {
+private:
+  std::vector<double> mass_;               // 空车质量取值(t)
+  std::vector<int32_t> passenger_capacity_; // 定员载客量取值(人)
+  std::vector<double> F_const_;            // 最大牵引力取值(kN)
+  std::vector<double> P_limit_;            // 最大牵引功率取值(kW)
+  std::vector<double> F_brake_;            // 再生制动力取值(kN)
+  std::vector<double> brake_eta_;          // 再生效率取值
+  size_t consume_seconds_ = 30;            // 用能曲线时长(s)
+  size_t produce_seconds_ = 15;            // 产能曲线时长(s)
+  std::vector<TractionSweepRecord> records_ = {}; // 计算结果
+
+public:
+  TractionSweep(); // 各参数默认只取原车型的值
+  ~TractionSweep() = default;
+  TractionSweep(const TractionSweep &) = default;
+  TractionSweep(TractionSweep &&) = default;
+  TractionSweep &operator=(const TractionSweep &) = default;
+  TractionSweep &operator=(TractionSweep &&) = default;
+
+  /**
+   * @brief 设置某个参数的取值范围[beg, end], 步长step
+   *
+   * @param name mass, passenger_capacity, F_const, P_limit, F_brake,
+   * brake_eta之一
+   * @return 参数名无效或范围无效时返回false. 定员的起止和步长须为非负整数,
+   * brake_eta须在(0, 1]内, 其余参数须为正数
+   */
+  bool set_range(const std::string &name, double beg, double end, double step);
+  size_t grid_size() const; // 参数组合总数
+  /**
+   * @brief 多线程计算所有参数组合
+   *
+   * @return 某个组合的最大牵引力不大于功率限制速度下的阻力(列车到不了
+   * 功率限制阶段)时不做计算, 输出该组合并返回false
+   */
+  bool run(size_t thread_cnt);
+  const std::vector<TractionSweepRecord> &records() const;
+  void output_result(const std::string &f_name = "traction-sweep.csv") const;
+
+private:
+  bool set_capacity_range(double beg, double end, double step);
+  TractionParams params_at(size_t index) const;
+  static void run_range(const TractionSweep &sweep, size_t beg, size_t end,
+                        std::vector<TractionSweepRecord> &out);
+};
+
+} // namespace yaohui
+
+#endif // YAOHUI_MASTER_THESIS_TRACTIONSWEEP_HPP
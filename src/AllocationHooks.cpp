@@ -0,0 +1,44 @@
+#include "PhaseTimer.hpp"
+#include <cstdlib>
+#include <new>
+
+// 没有阶段计时时分配无从归属, 不替换operator new
+#if defined(YAOHUI_ALLOC_TRACKING) && defined(YAOHUI_PHASE_TIMERS)
+
+// 替换全局的operator new/delete, 每次分配计入当前线程所在的阶段
+void *operator new(std::size_t n) {
+  yaohui::ScopedPhase::note_allocation(n);
+  while (true) {
+    if (void *p = std::malloc(n == 0 ? 1 : n)) {
+      return p;
+    }
+    std::new_handler handler = std::get_new_handler();
+    if (handler == nullptr) {
+      throw std::bad_alloc();
+    }
+    handler();
+  }
+}
+void *operator new[](std::size_t n) { return operator new(n); }
+void *operator new(std::size_t n, const std::nothrow_t &) noexcept {
+  try {
+    return operator new(n);
+  } catch (const std::bad_alloc &) {
+    return nullptr;
+  }
+}
+void *operator new[](std::size_t n, const std::nothrow_t &) noexcept {
+  return operator new(n, std::nothrow);
+}
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete[](void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::size_t) noexcept { std::free(p); }
+void operator delete(void *p, const std::nothrow_t &) noexcept {
+  std::free(p);
+}
+void operator delete[](void *p, const std::nothrow_t &) noexcept {
+  std::free(p);
+}
+
+#endif
@@ -0,0 +1,377 @@
+#include "CsvWriter.hpp"
+#include "Evaluator.hpp"
+#include "Individual.hpp"
+#include "PhaseTimer.hpp"
+#include "Solver.hpp"
+#include "SyntheticLine.hpp"
+#include "Timetable.hpp"
+#include "TimetableConfig.hpp"
+#include "TractionCalculator.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace yaohui {
+
+// 转发Timetable和Solver中被测的私有函数
+class BenchmarkAccess {
+public:
+  static std::pair<energy_map_t, energy_map_t>
+  energy_exchange_duration(const Timetable &tb) {
+    return tb.energy_exchange_duration();
+  }
+  static std::pair<energy_distribution_t, energy_distribution_t>
+  energy_distribution(const Timetable &tb) {
+    return tb.energy_distribution();
+  }
+  static Individual random_choose(const std::vector<Individual> &population,
+                                  const std::vector<double> &weight,
+                                  std::default_random_engine &e) {
+    return Solver::random_choose(population, weight, e);
+  }
+  static void parents_cross(Individual &father, Individual &mother,
+                            std::default_random_engine &e) {
+    Solver::parents_cross(father, mother, e);
+  }
+  static void child_mutate(Solver &solver, Individual &child) {
+    solver.child_mutate(child);
+  }
+};
+
+} // namespace yaohui
+
+using namespace std;
+using namespace yaohui;
+
+namespace {
+
+// 防止被测代码的结果被优化掉
+volatile double g_sink = 0.0;
+
+struct BenchmarkCase {
+  string name;
+  function<void()> run;
+  // 可选, 在计时之外为接下来的n次run准备输入(如被修改的个体的副本),
+  // 使计时和分配统计只包含被测函数本身
+  function<void(uint64_t)> prepare;
+};
+
+struct BenchmarkResult {
+  string name;
+  uint64_t iterations;
+  double ns_per_op;
+  double allocs_per_op; // 未统计堆分配时为NaN
+};
+
+// 自上次调用以来所有线程的堆分配次数, 由AllocationHooks.cpp计数
+uint64_t allocations_since_last_call() {
+  PhaseTotals t = ScopedPhase::collect();
+  uint64_t cnt = 0;
+  for (uint64_t c : t.alloc_cnt) {
+    cnt += c;
+  }
+  return cnt;
+}
+
+string format_allocs(double allocs_per_op) {
+  if (std::isnan(allocs_per_op)) {
+    return "n/a";
+  }
+  char buf[32];
+  snprintf(buf, sizeof(buf), "%.1f", allocs_per_op);
+  return buf;
+}
+
+// 反复调用c.run, 直到一轮的总时长不少于min_time秒
+BenchmarkResult run_benchmark(const BenchmarkCase &c, double min_time) {
+  if (c.prepare) {
+    c.prepare(1);
+  }
+  c.run(); // 预热
+  uint64_t iters = 1;
+  while (true) {
+    if (c.prepare) {
+      c.prepare(iters);
+    }
+    allocations_since_last_call();
+    auto beg = chrono::steady_clock::now();
+    for (uint64_t i = 0; i != iters; ++i) {
+      c.run();
+    }
+    double sec =
+        chrono::duration<double>(chrono::steady_clock::now() - beg).count();
+    uint64_t allocs = allocations_since_last_call();
+    if (sec >= min_time) {
+      double n = static_cast<double>(iters);
+      double allocs_per_op = ScopedPhase::allocation_tracking()
+                                 ? static_cast<double>(allocs) / n
+                                 : NAN;
+      return {c.name, iters, sec * 1e9 / n, allocs_per_op};
+    }
+    // 按本轮用时估计下一轮的次数, 每轮最多放大10倍
+    uint64_t next = iters * 10;
+    if (sec > 0.0) {
+      next = min(next, static_cast<uint64_t>(static_cast<double>(iters) *
+                                             min_time * 1.2 / sec) +
+                           1);
+    }
+    iters = max(iters + 1, next);
+  }
+}
+
+void print_usage() {
+  cout << "Usage: benchmarks [--filter=<substring>] [--min-time=<seconds>] "
+          "[--csv=<file>] [--line=<line.json>] "
+          "[--synthetic-line=<stations>,<arms>[,<hours>]]"
+       << endl;
+}
+
+// 解析--min-time的取值, 须为有限的正数
+bool parse_min_time(const string &text, double &value) {
+  char *end = nullptr;
+  double v = strtod(text.c_str(), &end);
+  if (text.empty() || *end != '\0' || !std::isfinite(v) || v <= 0.0) {
+    return false;
+  }
+  value = v;
+  return true;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  string filter;
+  double min_time = 0.5;
+  string csv_file;
+  for (int i = 1; i < argc; ++i) {
+    string arg = argv[i];
+    if (arg.compare(0, 9, "--filter=") == 0) {
+      filter = arg.substr(9);
+    } else if (arg.compare(0, 11, "--min-time=") == 0) {
+      if (!parse_min_time(arg.substr(11), min_time)) {
+        cout << "Invalid value: " << arg << endl;
+        print_usage();
+        return 1;
+      }
+    } else if (arg.compare(0, 6, "--csv=") == 0) {
+      csv_file = arg.substr(6);
+    } else if (arg.compare(0, 7, "--line=") == 0) {
+      try {
+        LineModel::set_current(LineModel::load_from_file(arg.substr(7)));
+      } catch (const std::exception &e) {
+        cout << e.what() << endl;
+        return 1;
+      }
+    } else if (arg.compare(0, 17, "--synthetic-line=") == 0) {
+      // 在合成线路上测量热点函数随车站、供电臂和运行线数目的变化
+      SyntheticLineSpec spec;
+      if (!parse_synthetic_line(arg.substr(17), spec)) {
+        print_usage();
+        return 1;
+      }
+      try {
+        LineModel::set_current(
+            make_shared<const LineModel>(make_synthetic_line(spec)));
+      } catch (const std::exception &e) {
+        cout << e.what() << endl;
+        return 1;
+      }
+    } else {
+      print_usage();
+      return 1;
+    }
+  }
+
+  // 所有随机数引擎使用固定种子, 保证每次运行的输入相同
+  const unsigned kSeed = 20230101;
+  default_random_engine e(kSeed);
+  TimetableConfig default_config;
+  Individual sample(default_config, e);
+  const TimetableConfig &config = sample.timetable_config();
+  Timetable tb(config);
+
+  // 选择用的种群和权重与Solver相同(alpha = 0.015)
+  vector<Individual> population;
+  for (size_t i = 0; i != 100; ++i) {
+    population.emplace_back(default_config, e);
+  }
+  sort(population.begin(), population.end(),
+       [](const Individual &a, const Individual &b) {
+         return a.score() > b.score();
+       });
+  vector<double> weights;
+  for (size_t i = 0; i != population.size(); ++i) {
+    weights.push_back(0.015 * pow(1 - 0.015, i));
+  }
+  // mutate_p为1, child_mutate每次都执行变异
+  SolverOptions options;
+  options.gene_cnt = 1;
+  options.population_cnt = 2;
+  options.cross_p = 0.8;
+  options.mutate_p = 1.0;
+  options.alpha = 0.015;
+  options.thread_cnt = 1;
+  options.has_seed = true;
+  options.seed = kSeed;
+  Solver solver(options);
+
+  Evaluator ev(config);
+  TractionCalculator traction;
+  vector<double> speeds(1000);
+  for (size_t i = 0; i != speeds.size(); ++i) {
+    speeds[i] = 80.0 * static_cast<double>(i) /
+                static_cast<double>(speeds.size());
+  }
+  vector<double> speeds_out(speeds.size());
+
+  // 适应度一类的非整数值, 比较CsvWriter与被它替换的to_string+ofstream
+  uniform_real_distribution<double> fitness_dist(0.0, 1.0);
+  vector<double> fitness_values(1000);
+  for (auto &v : fitness_values) {
+    v = fitness_dist(e);
+  }
+  CsvWriter csv_sink("/dev/null");
+  ofstream stream_sink("/dev/null");
+
+  // 交叉和变异直接修改个体, 每次调用前在计时之外准备好副本
+  vector<Individual> fathers;
+  vector<Individual> mothers;
+  size_t next_copy = 0;
+
+  vector<BenchmarkCase> cases = {
+      {"Timetable/construct",
+       [&] { g_sink = Timetable(config).missions().size(); }},
+      {"Timetable/energy_exchange_duration",
+       [&] {
+         g_sink = BenchmarkAccess::energy_exchange_duration(tb).first.size();
+       }},
+      {"Timetable/energy_distribution",
+       [&] {
+         g_sink = BenchmarkAccess::energy_distribution(tb).first.size();
+       }},
+      {"Timetable/total_reuse_ratio",
+       [&] { g_sink = tb.total_reuse_ratio(); }},
+      {"Timetable/construct_and_score",
+       [&] { g_sink = Timetable(config).total_reuse_ratio(); }},
+      {"Individual/construct",
+       [&] { g_sink = Individual(default_config, e).score(); }},
+      {"Solver/random_choose",
+       [&] {
+         g_sink = BenchmarkAccess::random_choose(population, weights, e)
+                      .score();
+       }},
+      {"Solver/parents_cross",
+       [&] {
+         Individual &father = fathers[next_copy];
+         Individual &mother = mothers[next_copy];
+         ++next_copy;
+         BenchmarkAccess::parents_cross(father, mother, e);
+         g_sink = father.score() + mother.score();
+       },
+       [&](uint64_t n) {
+         fathers.assign(n, population[0]);
+         mothers.assign(n, population[1]);
+         next_copy = 0;
+       }},
+      {"Solver/child_mutate",
+       [&] {
+         Individual &child = fathers[next_copy++];
+         BenchmarkAccess::child_mutate(solver, child);
+         g_sink = child.score();
+       },
+       [&](uint64_t n) {
+         fathers.assign(n, population[0]);
+         mothers.clear();
+         next_copy = 0;
+       }},
+      {"Evaluator/apply_and_undo",
+       [&] {
+         Evaluator::Move move;
+         if (ev.random_move(e, move)) {
+           g_sink = ev.apply(move);
+           move.delta = -move.delta;
+           g_sink = ev.apply(move);
+         }
+       }},
+      {"Evaluator/gain_table_k30",
+       [&] { g_sink = ev.gain_table(30).gain.size(); }},
+      {"TractionCalculator/accelerating_stage_W",
+       [&] { g_sink = traction.accelerating_stage_W(30.0).size(); }},
+      {"TractionCalculator/brake_stage_W",
+       [&] { g_sink = traction.brake_stage_W(15.0).size(); }},
+      {"TractionCalculator/accelerating_stage_W_per_second",
+       [&] { g_sink = traction.accelerating_stage_W_per_second(30).back(); }},
+      {"TractionCalculator/brake_stage_W_per_second",
+       [&] { g_sink = traction.brake_stage_W_per_second(15).back(); }},
+      {"TractionCalculator/f_total_batch_1000",
+       [&] {
+         traction.f_total_batch(speeds.data(), speeds_out.data(),
+                                speeds.size());
+         g_sink = speeds_out.back();
+       }},
+      {"CsvWriter/field_double_1000",
+       [&] {
+         csv_sink.row(fitness_values);
+         g_sink = fitness_values.back();
+       }},
+      {"ofstream/to_string_1000",
+       [&] {
+         for (double v : fitness_values) {
+           stream_sink << to_string(v) << ",";
+         }
+         stream_sink << "\n";
+         g_sink = fitness_values.back();
+       }},
+  };
+
+  vector<BenchmarkResult> results;
+  printf("%-52s %12s %14s %12s\n", "benchmark", "iterations", "ns/op",
+         "allocs/op");
+  for (const auto &c : cases) {
+    if (!filter.empty() && c.name.find(filter) == string::npos) {
+      continue;
+    }
+    results.push_back(run_benchmark(c, min_time));
+    const BenchmarkResult &r = results.back();
+    printf("%-52s %12llu %14.1f %12s\n", r.name.c_str(),
+           static_cast<unsigned long long>(r.iterations), r.ns_per_op,
+           format_allocs(r.allocs_per_op).c_str());
+    fflush(stdout);
+  }
+
+  if (!csv_file.empty()) {
+    CsvWriter output(csv_file);
+    if (!output.is_open()) {
+      cout << "Failed to open [" << csv_file << "] !" << endl;
+      return 1;
+    }
+    output.field("benchmark")
+        .field("iterations")
+        .field("ns_per_op")
+        .field("allocs_per_op")
+        .end_row();
+    for (const auto &r : results) {
+      output.field(r.name)
+          .field(static_cast<int64_t>(r.iterations))
+          .field(r.ns_per_op)
+          .field(format_allocs(r.allocs_per_op))
+          .end_row();
+    }
+    if (!output.close()) {
+      cout << "Failed to write [" << csv_file << "] !" << endl;
+      return 1;
+    }
+    cout << "Save file [" << csv_file << "] successful!" << endl;
+  }
+  return 0;
+}
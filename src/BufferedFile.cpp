@@ -0,0 +1,118 @@
+#include "BufferedFile.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <json.hpp>
+#include <unistd.h>
+
+namespace yaohui {
+
+BufferedFile::BufferedFile(const std::string &f_name, size_t buffer_size,
+                           bool append)
+    : buffer_(std::max<size_t>(buffer_size, 64)) {
+  fd_ = ::open(f_name.c_str(),
+               O_WRONLY | O_CREAT | (append ? O_APPEND : O_TRUNC), 0644);
+}
+
+BufferedFile::~BufferedFile() { close(); }
+
+bool BufferedFile::is_open() const { return fd_ >= 0; }
+
+bool BufferedFile::good() const { return fd_ >= 0 && !failed_; }
+
+void BufferedFile::write(const char *data, size_t n) {
+  if (size_ + n > buffer_.size()) {
+    flush();
+    if (n >= buffer_.size()) {
+      // 大块数据直接写入文件, 不经过缓冲区
+      write_all(data, n);
+      return;
+    }
+  }
+  std::memcpy(buffer_.data() + size_, data, n);
+  size_ += n;
+}
+
+void BufferedFile::write_int(int64_t v) {
+  char tmp[24];
+  char *end = tmp + sizeof(tmp);
+  char *p = end;
+  // 取绝对值时避免INT64_MIN溢出
+  uint64_t u = v < 0 ? 0 - static_cast<uint64_t>(v) : static_cast<uint64_t>(v);
+  do {
+    *--p = static_cast<char>('0' + u % 10);
+    u /= 10;
+  } while (u != 0);
+  if (v < 0) {
+    *--p = '-';
+  }
+  write(p, static_cast<size_t>(end - p));
+}
+
+void BufferedFile::write_double(double v) {
+  // 整数值(如能量分布中大量的0)直接按整数输出
+  if (v == std::floor(v) && std::fabs(v) < 9007199254740992.0) {
+    if (v == 0.0 && std::signbit(v)) {
+      write("-0", 2);
+      return;
+    }
+    write_int(static_cast<int64_t>(v));
+    return;
+  }
+  char *p = reserve(32);
+  if (!std::isfinite(v)) {
+    commit(static_cast<size_t>(std::snprintf(p, 32, "%g", v)));
+    return;
+  }
+  // nlohmann::json输出浮点数所用的Grisu2算法, 一次生成能还原原值的表示,
+  // 几乎总是最短. 逐个精度尝试snprintf+strtod要慢一个数量级
+  char *end = nlohmann::detail::to_chars(p, p + 32, v);
+  commit(static_cast<size_t>(end - p));
+}
+
+char *BufferedFile::reserve(size_t n) {
+  if (size_ + n > buffer_.size()) {
+    flush();
+    if (n > buffer_.size()) {
+      buffer_.resize(n);
+    }
+  }
+  return buffer_.data() + size_;
+}
+
+void BufferedFile::flush() {
+  write_all(buffer_.data(), size_);
+  size_ = 0;
+}
+
+void BufferedFile::write_all(const char *data, size_t n) {
+  while (n > 0 && fd_ >= 0 && !failed_) {
+    ssize_t w = ::write(fd_, data, n);
+    if (w < 0 && errno == EINTR) {
+      continue;
+    }
+    if (w <= 0) {
+      failed_ = true;
+      break;
+    }
+    data += w;
+    n -= static_cast<size_t>(w);
+  }
+}
+
+bool BufferedFile::close() {
+  if (fd_ < 0) {
+    return false;
+  }
+  flush();
+  if (::close(fd_) != 0) {
+    failed_ = true;
+  }
+  fd_ = -1;
+  return !failed_;
+}
+
+} // namespace yaohui
@@ -0,0 +1,60 @@
+#include "CsvWriter.hpp"
+#include <cstring>
+
+namespace yaohui {
+
+CsvWriter::CsvWriter(const std::string &f_name, size_t buffer_size,
+                     bool append)
+    : file_(f_name, buffer_size, append) {}
+
+bool CsvWriter::is_open() const { return file_.is_open(); }
+
+void CsvWriter::separator() {
+  if (!row_begin_) {
+    file_.put(',');
+  }
+  row_begin_ = false;
+}
+
+CsvWriter &CsvWriter::field(double v) {
+  separator();
+  file_.write_double(v);
+  return *this;
+}
+
+CsvWriter &CsvWriter::field(int64_t v) {
+  separator();
+  file_.write_int(v);
+  return *this;
+}
+
+CsvWriter &CsvWriter::field(const char *v) {
+  separator();
+  file_.write(v, std::strlen(v));
+  return *this;
+}
+
+CsvWriter &CsvWriter::field(const std::string &v) {
+  separator();
+  file_.write(v);
+  return *this;
+}
+
+CsvWriter &CsvWriter::row(const std::vector<double> &values) {
+  for (double v : values) {
+    field(v);
+  }
+  end_row();
+  return *this;
+}
+
+void CsvWriter::end_row() {
+  file_.put('\n');
+  row_begin_ = true;
+}
+
+void CsvWriter::flush() { file_.flush(); }
+
+bool CsvWriter::close() { return file_.close(); }
+
+} // namespace yaohui
@@ -0,0 +1,505 @@
+#include "Evaluator.hpp"
+#include "CsvWriter.hpp"
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+#include <map>
+#include <stdexcept>
+#include <string>
+
+namespace yaohui {
+
+Evaluator::Evaluator(TimetableConfig config) : config_(std::move(config)) {
+  const LineModel &line = config_.line();
+  const auto &stations = line.stations();
+  station_cnt_ = stations.size();
+  down_cnt_ = config_.down_missions_cnt();
+  mission_cnt_ = config_.missions_cnt();
+  consume_len_ = line.consume_duration();
+  produce_len_ = line.produce_duration();
+
+  // 供电臂按id升序编号, 与Timetable中各供电臂的累计顺序一致
+  std::map<supply_arm_id_t, size_t> arm_index;
+  for (supply_arm_id_t id : line.arm_seq()) {
+    arm_index[id] = 0;
+  }
+  size_t arm_cnt = 0;
+  for (auto &p : arm_index) {
+    p.second = arm_cnt++;
+  }
+  const size_t n = station_cnt_;
+  for (size_t pos = 0; pos != n; ++pos) {
+    down_arm_.push_back(arm_index[line.arm_seq()[pos]]);
+    up_arm_.push_back(arm_index[line.arm_seq()[n - 1 - pos]]);
+  }
+  for (size_t pos = 0; pos + 1 < n; ++pos) {
+    down_travel_.push_back(line.down_travel_seq()[pos]);
+    up_travel_.push_back(line.up_travel_seq()[n - 2 - pos]);
+  }
+
+  // 各运行线的到站时刻和停站时长, 推算方式与Timetable相同
+  arrive_.resize(mission_cnt_ * n);
+  dwell_.resize(mission_cnt_ * n);
+  counted_.assign(arm_cnt, false);
+  for (size_t m = 0; m != mission_cnt_; ++m) {
+    bool down = is_down(m);
+    second_t t = down ? config_.down_departure_time_vec()[m]
+                      : config_.up_departure_time_vec()[m - down_cnt_];
+    const auto &stop_dur = down
+                               ? config_.down_stop_duration_vec()[m]
+                               : config_.up_stop_duration_vec()[m - down_cnt_];
+    for (size_t pos = 0; pos != n; ++pos) {
+      station_id_t id = down ? stations[pos] : stations[n - 1 - pos];
+      arrive_[m * n + pos] = t;
+      dwell_[m * n + pos] = stop_dur.find(id)->second;
+      if (pos + 1 != n) {
+        counted_[arm_at(m, pos)] = true;
+        t += dwell_[m * n + pos] +
+             (down ? down_travel_[pos] : up_travel_[pos]);
+      }
+    }
+  }
+  check_windows(arrive_.data(), dwell_.data());
+  resync();
+}
+
+double Evaluator::ratio() const { return reuse_ / produce_total_; }
+size_t Evaluator::missions_cnt() const { return mission_cnt_; }
+size_t Evaluator::stations_cnt() const { return station_cnt_; }
+second_t Evaluator::departure(size_t mission) const {
+  return arrive_[mission * station_cnt_];
+}
+second_t Evaluator::dwell(size_t mission, size_t pos) const {
+  return dwell_[mission * station_cnt_ + pos];
+}
+
+TimetableConfig Evaluator::config() const {
+  TimetableConfig config = config_;
+  const auto &stations = config.stations();
+  const size_t n = station_cnt_;
+  for (size_t m = 0; m != mission_cnt_; ++m) {
+    bool down = is_down(m);
+    size_t i = down ? m : m - down_cnt_;
+    auto &de_vec = down ? config.down_departure_time_vec()
+                        : config.up_departure_time_vec();
+    auto &stop_dur = down ? config.down_stop_duration_vec()[i]
+                          : config.up_stop_duration_vec()[i];
+    de_vec[i] = departure(m);
+    for (size_t pos = 0; pos != n; ++pos) {
+      station_id_t id = down ? stations[pos] : stations[n - 1 - pos];
+      stop_dur.at(id) = dwell(m, pos);
+    }
+  }
+  return config;
+}
+
+bool Evaluator::is_down(size_t mission) const { return mission < down_cnt_; }
+
+size_t Evaluator::arm_at(size_t mission, size_t pos) const {
+  return is_down(mission) ? down_arm_[pos] : up_arm_[pos];
+}
+
+void Evaluator::check_windows(const second_t *arrive,
+                              const second_t *dwell) const {
+  const size_t n = station_cnt_;
+  for (size_t m = 0; m != mission_cnt_; ++m) {
+    for (size_t pos = 0; pos + 1 < n; ++pos) {
+      second_t beg = std::min(arrive[m * n + pos] + dwell[m * n + pos],
+                              arrive[m * n + pos + 1] - produce_len_);
+      // 曲线从0秒开始, 更早的窗口会写到曲线之外
+      if (beg < 0) {
+        throw std::out_of_range("energy window starts before 0 s at " +
+                                std::to_string(beg));
+      }
+    }
+  }
+}
+
+bool Evaluator::move_keeps_windows(const Move &move) const {
+  const size_t n = station_cnt_;
+  const size_t base = move.mission * n;
+  // 平移只影响pos及之后车站的用能窗口和pos之后车站的产能窗口
+  for (size_t pos = move.pos; pos + 1 < n; ++pos) {
+    if (arrive_[base + pos] + dwell_[base + pos] + move.delta < 0 ||
+        arrive_[base + pos + 1] + move.delta - produce_len_ < 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void Evaluator::accumulate(std::vector<joule_t> &curve, second_t beg,
+                           second_t len, const P_curve_t &kernel,
+                           double sign) {
+  assert(beg >= 0);
+  joule_t *p = curve.data() + beg;
+  for (second_t i = 0; i != len; ++i) {
+    p[i] += sign * kernel[i];
+  }
+}
+
+void Evaluator::ensure_horizon(second_t end) {
+  size_t horizon = static_cast<size_t>(end);
+  if (consume_.empty() || horizon <= consume_.front().size()) {
+    return;
+  }
+  // 按比例放大, 避免反复扩容
+  horizon = std::max(horizon, consume_.front().size() * 5 / 4);
+  for (auto *curves : {&consume_, &produce_}) {
+    for (auto &c : *curves) {
+      c.resize(horizon, 0.0);
+    }
+  }
+}
+
+void Evaluator::resync() {
+  const LineModel &line = config_.line();
+  const size_t n = station_cnt_;
+  // 曲线长度至少为100000秒, 与Timetable相同
+  second_t end = 100000;
+  for (size_t m = 0; m != mission_cnt_; ++m) {
+    for (size_t pos = 0; pos + 1 < n; ++pos) {
+      end = std::max(end, arrive_[m * n + pos] + dwell_[m * n + pos] +
+                              consume_len_);
+      end = std::max(end, arrive_[m * n + pos + 1]);
+    }
+  }
+  consume_.assign(counted_.size(), std::vector<joule_t>(end, 0.0));
+  produce_.assign(counted_.size(), std::vector<joule_t>(end, 0.0));
+  for (size_t m = 0; m != mission_cnt_; ++m) {
+    for (size_t pos = 0; pos + 1 < n; ++pos) {
+      accumulate(consume_[arm_at(m, pos)],
+                 arrive_[m * n + pos] + dwell_[m * n + pos], consume_len_,
+                 line.consume_vec(), 1.0);
+      accumulate(produce_[arm_at(m, pos + 1)],
+                 arrive_[m * n + pos + 1] - produce_len_, produce_len_,
+                 line.produce_vec(), 1.0);
+    }
+  }
+  reuse_ = 0.0;
+  produce_total_ = 0.0;
+  for (size_t arm = 0; arm != counted_.size(); ++arm) {
+    if (!counted_[arm]) {
+      continue;
+    }
+    const auto &p = produce_[arm];
+    const auto &c = consume_[arm];
+    double arm_produce = 0.0;
+    double arm_reuse = 0.0;
+    for (size_t i = 0; i != p.size(); ++i) {
+      arm_produce += p[i];
+      arm_reuse += (p[i] > c[i] ? c[i] : p[i]);
+    }
+    produce_total_ += arm_produce;
+    reuse_ += arm_reuse;
+  }
+}
+
+double Evaluator::windows_reuse() const {
+  double sum = 0.0;
+  for (const Window &w : windows_) {
+    if (!counted_[w.arm]) {
+      continue;
+    }
+    const joule_t *p = produce_[w.arm].data();
+    const joule_t *c = consume_[w.arm].data();
+    for (second_t t = w.beg; t != w.end; ++t) {
+      sum += (p[t] > c[t] ? c[t] : p[t]);
+    }
+  }
+  return sum;
+}
+
+double Evaluator::apply(const Move &move) {
+  const LineModel &line = config_.line();
+  const size_t n = station_cnt_;
+  const size_t base = move.mission * n;
+  const second_t delta = move.delta;
+  if (delta == 0) {
+    return ratio();
+  }
+
+  // 受影响的窗口: pos及之后车站的用能窗口, pos之后车站的产能窗口,
+  // 各取平移前后两个位置
+  windows_.clear();
+  second_t end = 0;
+  for (size_t pos = move.pos; pos + 1 < n; ++pos) {
+    size_t arm = arm_at(move.mission, pos);
+    second_t de = arrive_[base + pos] + dwell_[base + pos];
+    windows_.push_back({arm, de, de + consume_len_});
+    windows_.push_back({arm, de + delta, de + delta + consume_len_});
+    end = std::max(end, de + delta + consume_len_);
+  }
+  for (size_t pos = move.pos + 1; pos < n; ++pos) {
+    size_t arm = arm_at(move.mission, pos);
+    second_t ar = arrive_[base + pos];
+    windows_.push_back({arm, ar - produce_len_, ar});
+    windows_.push_back({arm, ar + delta - produce_len_, ar + delta});
+    end = std::max(end, ar + delta);
+  }
+  // 合并同一供电臂上重叠的窗口, 每一秒只计一次
+  std::sort(windows_.begin(), windows_.end(),
+            [](const Window &a, const Window &b) {
+              return a.arm != b.arm ? a.arm < b.arm : a.beg < b.beg;
+            });
+  size_t merged = 0;
+  for (size_t i = 1; i < windows_.size(); ++i) {
+    Window &last = windows_[merged];
+    if (windows_[i].arm == last.arm && windows_[i].beg <= last.end) {
+      last.end = std::max(last.end, windows_[i].end);
+    } else {
+      windows_[++merged] = windows_[i];
+    }
+  }
+  windows_.resize(windows_.empty() ? 0 : merged + 1);
+  for (const Window &w : windows_) {
+    if (w.beg < 0) {
+      throw std::out_of_range("energy window starts before 0 s at " +
+                              std::to_string(w.beg));
+    }
+  }
+
+  ensure_horizon(end);
+  double before = windows_reuse();
+  for (size_t pos = move.pos; pos + 1 < n; ++pos) {
+    auto &curve = consume_[arm_at(move.mission, pos)];
+    second_t de = arrive_[base + pos] + dwell_[base + pos];
+    accumulate(curve, de, consume_len_, line.consume_vec(), -1.0);
+    accumulate(curve, de + delta, consume_len_, line.consume_vec(), 1.0);
+  }
+  for (size_t pos = move.pos + 1; pos < n; ++pos) {
+    auto &curve = produce_[arm_at(move.mission, pos)];
+    second_t ar = arrive_[base + pos];
+    accumulate(curve, ar - produce_len_, produce_len_, line.produce_vec(),
+               -1.0);
+    accumulate(curve, ar + delta - produce_len_, produce_len_,
+               line.produce_vec(), 1.0);
+  }
+  reuse_ += windows_reuse() - before;
+
+  // 更新时刻: 平移发车时刻时整条运行线平移, 否则从下一站开始平移
+  if (move.pos == 0) {
+    arrive_[base] += delta;
+  } else {
+    dwell_[base + move.pos] += delta;
+  }
+  for (size_t pos = move.pos + 1; pos < n; ++pos) {
+    arrive_[base + pos] += delta;
+  }
+  return ratio();
+}
+
+bool Evaluator::random_move(std::default_random_engine &e,
+                            Move &move) const {
+  const LineModel &line = config_.line();
+  const auto &stations = line.stations();
+  const size_t n = station_cnt_;
+  // 可移动的基因: 各方向首班车之外的发车时刻, 各运行线中间车站的停站时长
+  size_t down_de_cnt = down_cnt_ > 0 ? down_cnt_ - 1 : 0;
+  size_t up_cnt = mission_cnt_ - down_cnt_;
+  size_t de_cnt = down_de_cnt + (up_cnt > 0 ? up_cnt - 1 : 0);
+  size_t inner_cnt = n > 2 ? n - 2 : 0;
+  size_t dim = de_cnt + mission_cnt_ * inner_cnt;
+  if (dim == 0) {
+    return false;
+  }
+  size_t g = std::uniform_int_distribution<size_t>(0, dim - 1)(e);
+
+  if (g < de_cnt) {
+    size_t m = g < down_de_cnt ? g + 1 : down_cnt_ + 1 + (g - down_de_cnt);
+    second_t prev = departure(m - 1);
+    second_t lo =
+        prev + LineModel::find_departure_T(prev, line.departure_T_min());
+    second_t hi =
+        prev + LineModel::find_departure_T(prev, line.departure_T_max());
+    if (hi < lo) {
+      return false;
+    }
+    second_t de = std::uniform_int_distribution<second_t>(lo, hi)(e);
+    if (de == departure(m)) {
+      return false;
+    }
+    // 后车的追踪间隔仍须在新发车时刻的上下限之内
+    if (m + 1 != mission_cnt_ && is_down(m + 1) == is_down(m)) {
+      second_t T = departure(m + 1) - de;
+      if (T < LineModel::find_departure_T(de, line.departure_T_min()) ||
+          T > LineModel::find_departure_T(de, line.departure_T_max())) {
+        return false;
+      }
+    }
+    move.mission = m;
+    move.pos = 0;
+    move.delta = de - departure(m);
+    return move_keeps_windows(move);
+  }
+
+  size_t m = (g - de_cnt) / inner_cnt;
+  size_t pos = 1 + (g - de_cnt) % inner_cnt;
+  station_id_t id = is_down(m) ? stations[pos] : stations[n - 1 - pos];
+  second_t LB = line.stop_duration_min().find(id)->second;
+  second_t UB = line.stop_duration_max().find(id)->second;
+  second_t d = std::uniform_int_distribution<second_t>(LB, UB)(e);
+  if (d == dwell(m, pos)) {
+    return false;
+  }
+  move.mission = m;
+  move.pos = pos;
+  move.delta = d - dwell(m, pos);
+  return move_keeps_windows(move);
+}
+
+double Evaluator::GainTable::consume(size_t mission, size_t pos,
+                                    second_t delta) const {
+  size_t width = 2 * static_cast<size_t>(max_shift) + 1;
+  return gain[(mission * station_cnt + pos) * 2 * width +
+              static_cast<size_t>(delta + max_shift)];
+}
+
+double Evaluator::GainTable::produce(size_t mission, size_t pos,
+                                    second_t delta) const {
+  size_t width = 2 * static_cast<size_t>(max_shift) + 1;
+  return gain[((mission * station_cnt + pos) * 2 + 1) * width +
+              static_cast<size_t>(delta + max_shift)];
+}
+
+void Evaluator::event_gains(const joule_t *other, const joule_t *self,
+                            const P_curve_t &kernel, second_t len, second_t k,
+                            std::vector<double> &scratch, double *out) {
+  // 去掉该事件后本方曲线的取值
+  scratch.assign(self, self + len + 2 * k);
+  double *base = scratch.data();
+  for (second_t i = 0; i != len; ++i) {
+    base[k + i] -= kernel[i];
+  }
+  for (second_t x = 0; x <= 2 * k; ++x) {
+    const joule_t *o = other + x;
+    const double *b = base + x;
+    double f = 0.0;
+    for (second_t i = 0; i != len; ++i) {
+      double with = b[i] + kernel[i];
+      f += (o[i] > with ? with : o[i]) - (o[i] > b[i] ? b[i] : o[i]);
+    }
+    out[x] = f;
+  }
+  double f0 = out[k];
+  for (second_t x = 0; x <= 2 * k; ++x) {
+    out[x] -= f0;
+  }
+}
+
+Evaluator::GainTable Evaluator::gain_table(second_t k) const {
+  const LineModel &line = config_.line();
+  const size_t n = station_cnt_;
+  const size_t width = 2 * static_cast<size_t>(k) + 1;
+  GainTable table;
+  table.max_shift = k;
+  table.station_cnt = n;
+  table.gain.assign(mission_cnt_ * n * 2 * width, 0.0);
+
+  // 取曲线上[beg, beg + span)的一段, 超出曲线范围的部分为0
+  auto load = [](const std::vector<joule_t> &curve, second_t beg,
+                 second_t span, std::vector<joule_t> &out) {
+    out.assign(span, 0.0);
+    for (second_t t = std::max(0, -beg); t < span; ++t) {
+      if (static_cast<size_t>(beg + t) >= curve.size()) {
+        break;
+      }
+      out[t] = curve[beg + t];
+    }
+  };
+  std::vector<joule_t> other;
+  std::vector<joule_t> self;
+  std::vector<double> scratch;
+  for (size_t m = 0; m != mission_cnt_; ++m) {
+    for (size_t pos = 0; pos != n; ++pos) {
+      size_t arm = arm_at(m, pos);
+      if (!counted_[arm]) {
+        continue;
+      }
+      double *row = table.gain.data() + (m * n + pos) * 2 * width;
+      if (pos + 1 != n) {
+        second_t beg = arrive_[m * n + pos] + dwell_[m * n + pos] - k;
+        load(produce_[arm], beg, consume_len_ + 2 * k, other);
+        load(consume_[arm], beg, consume_len_ + 2 * k, self);
+        event_gains(other.data(), self.data(), line.consume_vec(),
+                    consume_len_, k, scratch, row);
+      }
+      if (pos != 0) {
+        second_t beg = arrive_[m * n + pos] - produce_len_ - k;
+        load(consume_[arm], beg, produce_len_ + 2 * k, other);
+        load(produce_[arm], beg, produce_len_ + 2 * k, self);
+        event_gains(other.data(), self.data(), line.produce_vec(),
+                    produce_len_, k, scratch, row + width);
+      }
+    }
+  }
+  for (double &g : table.gain) {
+    g /= produce_total_;
+  }
+  return table;
+}
+
+bool Evaluator::output_gain_table(const std::string &f_name,
+                                  second_t k) const {
+  CsvWriter output(f_name);
+  if (!output.is_open()) {
+    std::cout << "Failed to open [" << f_name << "] !" << std::endl;
+    return false;
+  }
+  GainTable table = gain_table(k);
+  const auto &stations = config_.stations();
+  const size_t n = station_cnt_;
+  output.field("mission")
+      .field("station")
+      .field("event")
+      .field("delta")
+      .field("gain")
+      .end_row();
+  for (size_t m = 0; m != mission_cnt_; ++m) {
+    for (size_t pos = 0; pos != n; ++pos) {
+      station_id_t id = is_down(m) ? stations[pos] : stations[n - 1 - pos];
+      for (second_t d = -k; pos + 1 != n && d <= k; ++d) {
+        output.field(static_cast<int64_t>(m))
+            .field(id)
+            .field("consume")
+            .field(d)
+            .field(table.consume(m, pos, d))
+            .end_row();
+      }
+      for (second_t d = -k; pos != 0 && d <= k; ++d) {
+        output.field(static_cast<int64_t>(m))
+            .field(id)
+            .field("produce")
+            .field(d)
+            .field(table.produce(m, pos, d))
+            .end_row();
+      }
+    }
+  }
+  if (!output.close()) {
+    std::cout << "Failed to write [" << f_name << "] !" << std::endl;
+    return false;
+  }
+  std::cout << "Save file [" << f_name << "] successful!" << std::endl;
+  return true;
+}
+
+std::vector<second_t> Evaluator::genome() const {
+  std::vector<second_t> ret(arrive_);
+  ret.insert(ret.end(), dwell_.begin(), dwell_.end());
+  return ret;
+}
+
+void Evaluator::set_genome(const std::vector<second_t> &genome) {
+  if (genome.size() != arrive_.size() + dwell_.size()) {
+    throw std::invalid_argument("genome size " +
+                                std::to_string(genome.size()) +
+                                " does not match the timetable");
+  }
+  check_windows(genome.data(), genome.data() + arrive_.size());
+  std::copy(genome.begin(), genome.begin() + arrive_.size(), arrive_.begin());
+  std::copy(genome.begin() + arrive_.size(), genome.end(), dwell_.begin());
+  resync();
+}
+
+} // namespace yaohui
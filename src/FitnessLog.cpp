@@ -0,0 +1,136 @@
+#include "FitnessLog.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <unistd.h>
+
+namespace yaohui {
+
+namespace {
+
+/**
+ * @brief 把已有的日志截断到第generation代为止
+ *
+ * 逐行扫描, 在第一个代数大于generation的行或不完整的行(上次运行中途退出时
+ * 可能只写了半行)处截断. 返回截断后是否还保留着表头.
+ */
+bool truncate_after(const std::string &f_name, size_t generation) {
+  std::ifstream in(f_name, std::ios::binary);
+  if (!in.is_open()) {
+    return false;
+  }
+  std::string line;
+  if (!std::getline(in, line) || in.eof() ||
+      line.compare(0, 11, "generation,") != 0) {
+    return false;
+  }
+  long long keep = static_cast<long long>(line.size()) + 1; // 保留的字节数
+  while (std::getline(in, line) && !in.eof()) {
+    char *end = nullptr;
+    unsigned long long g = std::strtoull(line.c_str(), &end, 10);
+    if (end == line.c_str() || *end != ',' || g > generation) {
+      break;
+    }
+    keep += static_cast<long long>(line.size()) + 1;
+  }
+  in.close();
+  return ::truncate(f_name.c_str(), static_cast<off_t>(keep)) == 0;
+}
+
+} // namespace
+
+FitnessLog::FitnessLog(const std::string &f_name, size_t fitness_cnt)
+    : resumed_(false), out_(f_name) {
+  if (out_.is_open()) {
+    write_header(fitness_cnt);
+    writer_ = std::thread(&FitnessLog::write_loop, this);
+  }
+}
+
+FitnessLog::FitnessLog(const std::string &f_name, size_t fitness_cnt,
+                       size_t generation)
+    : resumed_(truncate_after(f_name, generation)),
+      out_(f_name, 1 << 20, resumed_) {
+  if (out_.is_open()) {
+    if (!resumed_) {
+      write_header(fitness_cnt);
+    }
+    writer_ = std::thread(&FitnessLog::write_loop, this);
+  }
+}
+
+void FitnessLog::write_header(size_t fitness_cnt) {
+  out_.field("generation")
+      .field("best_fitness")
+      .field("worst_fitness")
+      .field("avg_fitness");
+  for (size_t i = 0; i != fitness_cnt; ++i) {
+    out_.field("fitness_" + std::to_string(i));
+  }
+  out_.end_row();
+}
+
+FitnessLog::~FitnessLog() { close(); }
+
+bool FitnessLog::is_open() const { return out_.is_open(); }
+
+bool FitnessLog::close() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  cv_.notify_one();
+  if (writer_.joinable()) {
+    writer_.join();
+  }
+  return out_.close();
+}
+
+void FitnessLog::append(size_t generation, std::vector<double> fitness) {
+  if (!out_.is_open()) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    queue_.push_back({generation, std::move(fitness)});
+  }
+  cv_.notify_one();
+}
+
+void FitnessLog::write_loop() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    cv_.wait(lock, [this] { return stop_ || !queue_.empty(); });
+    if (queue_.empty()) {
+      return; // stop_且已写完
+    }
+    std::deque<Record> batch;
+    batch.swap(queue_);
+    lock.unlock();
+    for (const Record &r : batch) {
+      double best = r.fitness.empty() ? 0.0 : r.fitness.front();
+      double worst = r.fitness.empty() ? 0.0 : r.fitness.front();
+      double avg = 0.0;
+      for (double f : r.fitness) {
+        best = std::max(best, f);
+        worst = std::min(worst, f);
+        avg += f;
+      }
+      if (!r.fitness.empty()) {
+        avg /= static_cast<double>(r.fitness.size());
+      }
+      out_.field(static_cast<int64_t>(r.generation))
+          .field(best)
+          .field(worst)
+          .field(avg);
+      for (double f : r.fitness) {
+        out_.field(f);
+      }
+      out_.end_row();
+    }
+    out_.flush(); // 每批记录写完后落盘
+    lock.lock();
+  }
+}
+
+} // namespace yaohui
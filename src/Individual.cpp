@@ -1,12 +1,18 @@
 #include "Individual.hpp"
+#include "PhaseTimer.hpp"
 #include "TimetableConfig.hpp"
-#include <chrono>
+#include "Tracer.hpp"
+#include <atomic>
 #include <random>
 
 using namespace std;
 
 namespace yaohui {
 
+namespace {
+std::atomic<uint64_t> g_evaluation_cnt(0); // 评价次数
+}
+
 double Individual::score() const { return score_; }
 double &Individual::score() { return score_; }
 const TimetableConfig &Individual::timetable_config() const {
@@ -14,115 +20,60 @@ const TimetableConfig &Individual::timetable_config() const {
 }
 TimetableConfig &Individual::timetable_config() { return timetable_config_; }
 void Individual::update_score() {
+  YAOHUI_PHASE_SCOPE(Phase::kEvaluation);
+  TraceScope trace("evaluation");
   score_ = Timetable(timetable_config_).total_reuse_ratio();
+  g_evaluation_cnt.fetch_add(1, std::memory_order_relaxed);
+}
+uint64_t Individual::evaluation_count() {
+  return g_evaluation_cnt.load(std::memory_order_relaxed);
 }
 
-Individual::Individual(TimetableConfig tb_config)
-    : timetable_config_(std::move(tb_config)) {
+Individual Individual::from_config(TimetableConfig tb_config) {
+  Individual ret;
+  ret.timetable_config_ = std::move(tb_config);
+  ret.update_score();
+  return ret;
+}
 
-  auto find_T = [](second_t t, const departure_T_t &dT) -> second_t {
-    // 寻找追踪间隔
-    second_t departure_T;
-    for (const auto &dt : dT) {
-      if (t >= dt.first.first && t < dt.first.second) {
-        departure_T = dt.second;
-        break;
-      }
-    }
-    return departure_T;
-  };
+Individual::Individual(TimetableConfig tb_config, std::default_random_engine &e)
+    : timetable_config_(std::move(tb_config)) {
+  randomize(e);
+}
 
+void Individual::randomize(std::default_random_engine &e) {
   TimetableConfig &config = timetable_config_;
-
-  // down departure
-  // 获取下行首站发车时刻序列
-  auto &down_de_vec = config.down_departure_time_vec();
-  for (size_t i = 0; i != down_de_vec.size(); ++i) {
-    if (i == 0) {
-      continue;
-    }
-    second_t di_1 = down_de_vec.at(i - 1);
-    second_t di = down_de_vec.at(i);
-    // 寻找i-1时刻的最小追踪间隔
-    second_t departure_T_min = find_T(di_1, config.departure_T_min());
-    second_t oft = di - di_1 - departure_T_min; // 更新oft
-    // 寻找i-1时刻的最大追踪间隔
-    second_t departure_T_max = find_T(di_1, config.departure_T_max());
-    second_t oyt = departure_T_max - (di - di_1); // 更新oyt
-
-    // 随机偏移量
-    auto tp_epoch = std::chrono::system_clock::now().time_since_epoch().count();
-    static std::default_random_engine down_departure_mutate_offset_e(tp_epoch);
-    static uniform_int_distribution<second_t> down_departure_mutate_offset_u(
-        -oft, oyt);
-    second_t r2 =
-        down_departure_mutate_offset_u(down_departure_mutate_offset_e);
-    // 更新di
-    down_de_vec.at(i) += r2;
-  }
-  // up departure
-  // 获取上行首站发车时刻序列
-  auto &up_de_vec = config.up_departure_time_vec();
-  for (size_t i = 0; i <= up_de_vec.size() - 1; ++i) {
-    if (i == 0) {
-      continue;
-    }
-    second_t di_1 = up_de_vec.at(i - 1);
-    second_t di = up_de_vec.at(i);
-    // 寻找i-1时刻的最小追踪间隔
-    second_t departure_T_min = find_T(di_1, config.departure_T_min());
-    second_t oft = di - di_1 - departure_T_min; // 更新oft
-    // 寻找i-1时刻的最大追踪间隔
-    second_t departure_T_max = find_T(di_1, config.departure_T_max());
-    second_t oyt = departure_T_max - (di - di_1); // 更新oyt
-
-    // 随机偏移量
-    auto tp_epoch = std::chrono::system_clock::now().time_since_epoch().count();
-    static std::default_random_engine up_departure_mutate_offset_e(tp_epoch);
-    static uniform_int_distribution<second_t> up_departure_mutate_offset_u(-oft,
-                                                                           oyt);
-    second_t r2 = up_departure_mutate_offset_u(up_departure_mutate_offset_e);
-    // 更新di
-    up_de_vec.at(i) += r2;
-  }
-
-  // down stop
-  for (auto &l : config.down_stop_duration_vec()) {
-    for (station_id_t r1 = config.stations().front();
-         r1 <= config.stations().back(); ++r1) {
-      if (r1 == config.stations().front() || r1 == config.stations().back()) {
-        continue;
-      }
-      second_t LB = config.stop_duration_min().at(r1);
-      second_t UB = config.stop_duration_max().at(r1);
-
-      auto tp_epoch =
-          std::chrono::system_clock::now().time_since_epoch().count();
-      static std::default_random_engine down_stop_mutate_offset_e(tp_epoch);
-      static uniform_int_distribution<second_t> down_stop_mutate_offset_u(LB,
-                                                                          UB);
-      second_t r2 = down_stop_mutate_offset_u(down_stop_mutate_offset_e);
-      l.at(r1) = r2;
+  const LineModel &line = config.line();
+
+  // 首站发车时刻: 依次在i-1时刻的最小/最大追踪间隔范围内平移di
+  for (auto *de_vec :
+       {&config.down_departure_time_vec(), &config.up_departure_time_vec()}) {
+    first_departure_time_t &de = *de_vec;
+    for (size_t i = 1; i < de.size(); ++i) {
+      second_t di_1 = de[i - 1];
+      second_t di = de[i];
+      // i-1时刻的最小追踪间隔对应oft, 最大追踪间隔对应oyt
+      second_t oft =
+          di - di_1 - LineModel::find_departure_T(di_1, line.departure_T_min());
+      second_t oyt =
+          LineModel::find_departure_T(di_1, line.departure_T_max()) -
+          (di - di_1);
+      // 随机偏移量
+      de[i] += uniform_int_distribution<second_t>(-oft, oyt)(e);
     }
   }
 
-  // up stop
-  for (auto &l : config.up_stop_duration_vec()) {
-    for (station_id_t r1 = config.stations().front();
-         r1 <= config.stations().back(); ++r1) {
-      if (r1 == config.stations().front() || r1 == config.stations().back()) {
-        continue;
+  // 停站时长: 首末站停站时长固定, 只随机中间车站
+  const auto &stations = config.stations();
+  for (auto *stop_vec :
+       {&config.down_stop_duration_vec(), &config.up_stop_duration_vec()}) {
+    for (auto &l : *stop_vec) {
+      for (size_t pos = 1; pos + 1 < stations.size(); ++pos) {
+        station_id_t r1 = stations[pos];
+        second_t LB = line.stop_duration_min().find(r1)->second;
+        second_t UB = line.stop_duration_max().find(r1)->second;
+        l.at(r1) = uniform_int_distribution<second_t>(LB, UB)(e);
       }
-
-      second_t LB = config.stop_duration_min().at(r1);
-      second_t UB = config.stop_duration_max().at(r1);
-
-      auto tp_epoch =
-          std::chrono::system_clock::now().time_since_epoch().count();
-      static std::default_random_engine up_stop_mutate_offset_e(tp_epoch);
-      static uniform_int_distribution<second_t> up_stop_mutate_offset_u(LB, UB);
-      second_t r2 = up_stop_mutate_offset_u(up_stop_mutate_offset_e);
-      l.at(r1) = r2;
     }
   }
 
@@ -130,126 +81,33 @@ Individual::Individual(TimetableConfig tb_config)
   this->update_score();
 }
 
-std::vector<double> Individual::random_walk(size_t k) {
+std::vector<double> Individual::random_walk(size_t k,
+                                            std::default_random_engine &e) {
   // 保存结果
   vector<double> ret;
-  auto find_T = [](second_t t, const departure_T_t &dT) -> second_t {
-    // 寻找追踪间隔
-    second_t departure_T;
-    for (const auto &dt : dT) {
-      if (t >= dt.first.first && t < dt.first.second) {
-        departure_T = dt.second;
-        break;
-      }
-    }
-    return departure_T;
-  };
+  ret.reserve(k);
+  random_walk(k, e,
+              [&ret](const Individual &ind) { ret.push_back(ind.score_); });
+  return ret;
+}
+
+void Individual::random_walk(
+    size_t k, std::default_random_engine &e,
+    const std::function<void(const Individual &)> &on_sample) {
+  // 标准运行图只构造一次. 每步只需恢复发车时刻, 中间站的停站时长每步都会被
+  // 重新抽取, 首末站的停站时长始终为标准值
+  const TimetableConfig baseline(timetable_config_.line_ptr());
+  timetable_config_ = baseline;
 
   // 随机漫步k次
   for (size_t t = 0; t != k; ++t) {
-    timetable_config_ = TimetableConfig();
-    TimetableConfig &config = timetable_config_;
-    // down departure
-    // 获取下行首站发车时刻序列
-    auto &down_de_vec = config.down_departure_time_vec();
-    for (size_t i = 0; i != down_de_vec.size(); ++i) {
-      if (i == 0) {
-        continue;
-      }
-      second_t di_1 = down_de_vec.at(i - 1);
-      second_t di = down_de_vec.at(i);
-      // 寻找i-1时刻的最小追踪间隔
-      second_t departure_T_min = find_T(di_1, config.departure_T_min());
-      second_t oft = di - di_1 - departure_T_min; // 更新oft
-      // 寻找i-1时刻的最大追踪间隔
-      second_t departure_T_max = find_T(di_1, config.departure_T_max());
-      second_t oyt = departure_T_max - (di - di_1); // 更新oyt
-
-      // 随机偏移量
-      auto tp_epoch =
-          std::chrono::system_clock::now().time_since_epoch().count();
-      static std::default_random_engine down_departure_mutate_offset_e(
-          tp_epoch);
-      static uniform_int_distribution<second_t> down_departure_mutate_offset_u(
-          -oft, oyt);
-      second_t r2 =
-          down_departure_mutate_offset_u(down_departure_mutate_offset_e);
-      // 更新di
-      down_de_vec.at(i) += r2;
-    }
-    // up departure
-    // 获取上行首站发车时刻序列
-    auto &up_de_vec = config.up_departure_time_vec();
-    for (size_t i = 0; i <= up_de_vec.size() - 1; ++i) {
-      if (i == 0) {
-        continue;
-      }
-      second_t di_1 = up_de_vec.at(i - 1);
-      second_t di = up_de_vec.at(i);
-      // 寻找i-1时刻的最小追踪间隔
-      second_t departure_T_min = find_T(di_1, config.departure_T_min());
-      second_t oft = di - di_1 - departure_T_min; // 更新oft
-      // 寻找i-1时刻的最大追踪间隔
-      second_t departure_T_max = find_T(di_1, config.departure_T_max());
-      second_t oyt = departure_T_max - (di - di_1); // 更新oyt
-
-      // 随机偏移量
-      auto tp_epoch =
-          std::chrono::system_clock::now().time_since_epoch().count();
-      static std::default_random_engine up_departure_mutate_offset_e(tp_epoch);
-      static uniform_int_distribution<second_t> up_departure_mutate_offset_u(
-          -oft, oyt);
-      second_t r2 = up_departure_mutate_offset_u(up_departure_mutate_offset_e);
-      // 更新di
-      up_de_vec.at(i) += r2;
-    }
-
-    // down stop
-    for (auto &l : config.down_stop_duration_vec()) {
-      for (station_id_t r1 = config.stations().front();
-           r1 <= config.stations().back(); ++r1) {
-        if (r1 == config.stations().front() || r1 == config.stations().back()) {
-          continue;
-        }
-        second_t LB = config.stop_duration_min().at(r1);
-        second_t UB = config.stop_duration_max().at(r1);
-
-        auto tp_epoch =
-            std::chrono::system_clock::now().time_since_epoch().count();
-        static std::default_random_engine down_stop_mutate_offset_e(tp_epoch);
-        static uniform_int_distribution<second_t> down_stop_mutate_offset_u(LB,
-                                                                            UB);
-        second_t r2 = down_stop_mutate_offset_u(down_stop_mutate_offset_e);
-        l.at(r1) = r2;
-      }
-    }
-
-    // up stop
-    for (auto &l : config.up_stop_duration_vec()) {
-      for (station_id_t r1 = config.stations().front();
-           r1 <= config.stations().back(); ++r1) {
-        if (r1 == config.stations().front() || r1 == config.stations().back()) {
-          continue;
-        }
-
-        second_t LB = config.stop_duration_min().at(r1);
-        second_t UB = config.stop_duration_max().at(r1);
-
-        auto tp_epoch =
-            std::chrono::system_clock::now().time_since_epoch().count();
-        static std::default_random_engine up_stop_mutate_offset_e(tp_epoch);
-        static uniform_int_distribution<second_t> up_stop_mutate_offset_u(LB,
-                                                                          UB);
-        second_t r2 = up_stop_mutate_offset_u(up_stop_mutate_offset_e);
-        l.at(r1) = r2;
-      }
-    }
-
-    // 更新score
-    this->update_score();
-    ret.push_back(score_);
+    timetable_config_.down_departure_time_vec() =
+        baseline.down_departure_time_vec();
+    timetable_config_.up_departure_time_vec() =
+        baseline.up_departure_time_vec();
+    randomize(e);
+    on_sample(*this);
   }
-  return std::move(ret);
 }
 
-} // namespace yaohui
\ No newline at end of file
+} // namespace yaohui
@@ -0,0 +1,132 @@
+#include "JsonWriter.hpp"
+#include <cstring>
+
+namespace yaohui {
+
+JsonWriter::JsonWriter(BufferedFile &out, int indent)
+    : out_(out), indent_(indent) {}
+
+void JsonWriter::before_value() {
+  if (after_key_) {
+    after_key_ = false;
+    return;
+  }
+  if (counts_.empty()) {
+    return;
+  }
+  if (counts_.back()++ != 0) {
+    out_.put(',');
+  }
+  newline_indent(counts_.size());
+}
+
+void JsonWriter::newline_indent(size_t depth) {
+  if (indent_ < 0) {
+    return;
+  }
+  size_t n = depth * static_cast<size_t>(indent_);
+  char *p = out_.reserve(n + 1);
+  p[0] = '\n';
+  std::memset(p + 1, ' ', n);
+  out_.commit(n + 1);
+}
+
+void JsonWriter::begin_object() {
+  before_value();
+  out_.put('{');
+  counts_.push_back(0);
+}
+
+void JsonWriter::end_object() { end_container('}'); }
+
+void JsonWriter::begin_array() {
+  before_value();
+  out_.put('[');
+  counts_.push_back(0);
+}
+
+void JsonWriter::end_array() { end_container(']'); }
+
+void JsonWriter::end_container(char c) {
+  size_t cnt = counts_.back();
+  counts_.pop_back();
+  // 空容器输出为{}或[]
+  if (cnt != 0) {
+    newline_indent(counts_.size());
+  }
+  out_.put(c);
+}
+
+void JsonWriter::key(const char *k) {
+  before_value();
+  write_string(k, std::strlen(k));
+  out_.put(':');
+  if (indent_ >= 0) {
+    out_.put(' ');
+  }
+  after_key_ = true;
+}
+
+void JsonWriter::value(int64_t v) {
+  before_value();
+  out_.write_int(v);
+}
+
+void JsonWriter::value(bool v) {
+  before_value();
+  if (v) {
+    out_.write("true", 4);
+  } else {
+    out_.write("false", 5);
+  }
+}
+
+void JsonWriter::value(double v) {
+  before_value();
+  out_.write_double(v);
+}
+
+void JsonWriter::value(const std::string &v) {
+  before_value();
+  write_string(v.data(), v.size());
+}
+
+void JsonWriter::null() {
+  before_value();
+  out_.write("null", 4);
+}
+
+void JsonWriter::write_string(const char *s, size_t n) {
+  static const char hex[] = "0123456789abcdef";
+  out_.put('"');
+  for (size_t i = 0; i != n; ++i) {
+    auto c = static_cast<unsigned char>(s[i]);
+    switch (c) {
+    case '"':
+      out_.write("\\\"", 2);
+      break;
+    case '\\':
+      out_.write("\\\\", 2);
+      break;
+    case '\n':
+      out_.write("\\n", 2);
+      break;
+    case '\r':
+      out_.write("\\r", 2);
+      break;
+    case '\t':
+      out_.write("\\t", 2);
+      break;
+    default:
+      if (c < 0x20) {
+        char esc[6] = {'\\', 'u', '0', '0', hex[c >> 4], hex[c & 0xF]};
+        out_.write(esc, 6);
+      } else {
+        out_.put(static_cast<char>(c));
+      }
+    }
+  }
+  out_.put('"');
+}
+
+} // namespace yaohui
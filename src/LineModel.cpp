@@ -0,0 +1,388 @@
+#include "LineModel.hpp"
+#include "BufferedFile.hpp"
+#include "JsonWriter.hpp"
+#include <fstream>
+#include <iostream>
+#include <json.hpp>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+
+using namespace std;
+using namespace nlohmann;
+
+namespace yaohui {
+
+namespace {
+
+// 当前线路模型
+shared_ptr<const LineModel> &current_model() {
+  static shared_ptr<const LineModel> model = LineModel::default_model();
+  return model;
+}
+
+// 64位FNV-1a
+class Fnv1a {
+private:
+  uint64_t h_ = 14695981039346656037ull;
+
+public:
+  void bytes(const void *p, size_t n) {
+    const unsigned char *c = static_cast<const unsigned char *>(p);
+    for (size_t i = 0; i != n; ++i) {
+      h_ = (h_ ^ c[i]) * 1099511628211ull;
+    }
+  }
+  void add(int32_t v) { bytes(&v, sizeof(v)); }
+  void add(uint64_t v) { bytes(&v, sizeof(v)); }
+  void add(double v) { bytes(&v, sizeof(v)); }
+  // 先写入元素个数, 避免相邻容器的边界不同而内容拼接相同
+  template <typename K, typename V> void add(const map<K, V> &m) {
+    add(static_cast<uint64_t>(m.size()));
+    for (const auto &kv : m) {
+      add(kv.first);
+      add(kv.second);
+    }
+  }
+  template <typename T> void add(const vector<T> &v) {
+    add(static_cast<uint64_t>(v.size()));
+    for (const auto &x : v) {
+      add(x);
+    }
+  }
+  template <typename A, typename B> void add(const pair<A, B> &p) {
+    add(p.first);
+    add(p.second);
+  }
+  uint64_t value() const { return h_; }
+};
+
+// 检查各时段的min <= std <= max, 并检查时段互不重叠且覆盖[beg, end)
+void validate_departure_T(const LineData &d, vector<string> &errors) {
+  for (const auto &dt : d.departure_T) {
+    auto finder_min = d.departure_T_min.find(dt.first);
+    auto finder_max = d.departure_T_max.find(dt.first);
+    ostringstream period;
+    period << "[" << dt.first.first << ", " << dt.first.second << ")";
+    if (dt.first.first >= dt.first.second) {
+      errors.push_back("headway period " + period.str() + " is empty");
+    }
+    if (finder_min == d.departure_T_min.end() ||
+        finder_max == d.departure_T_max.end()) {
+      errors.push_back("headway period " + period.str() +
+                       " has no min/max bound");
+      continue;
+    }
+    if (!(0 < finder_min->second && finder_min->second <= dt.second &&
+          dt.second <= finder_max->second)) {
+      errors.push_back("headway period " + period.str() +
+                       " violates 0 < min <= std <= max");
+    }
+  }
+  if (d.departure_T_min.size() != d.departure_T.size() ||
+      d.departure_T_max.size() != d.departure_T.size()) {
+    errors.push_back("headway min/max tables have periods without std value");
+  }
+  second_t covered = d.first_train_time;
+  for (const auto &dt : d.departure_T) {
+    if (dt.first.first > covered) {
+      break;
+    }
+    covered = std::max(covered, dt.first.second);
+  }
+  if (covered < d.last_train_time) {
+    errors.push_back("headway periods do not cover train window at " +
+                     to_string(covered));
+  }
+  second_t prev_end = INT32_MIN;
+  for (const auto &dt : d.departure_T) {
+    if (dt.first.first < prev_end) {
+      errors.push_back("headway periods overlap at " +
+                       to_string(dt.first.first));
+    }
+    prev_end = dt.first.second;
+  }
+}
+
+departure_T_t parse_headway(const json &j, const char *field) {
+  departure_T_t ret;
+  for (const auto &h : j) {
+    ret[{h.at("begin").get<second_t>(), h.at("end").get<second_t>()}] =
+        h.at(field).get<second_t>();
+  }
+  return ret;
+}
+
+} // namespace
+
+LineModel::LineModel(LineData data) : data_(std::move(data)) {
+  vector<string> errors = validate(data_);
+  if (!errors.empty()) {
+    string msg = "invalid line model:";
+    for (const auto &e : errors) {
+      msg += "\n  " + e;
+    }
+    throw std::invalid_argument(msg);
+  }
+  // 校验通过后生成稠密查找表
+  const auto &st = data_.stations;
+  arm_seq_.reserve(st.size());
+  for (station_id_t id : st) {
+    arm_seq_.push_back(data_.supply_arm.find(id)->second);
+  }
+  for (size_t i = 0; i + 1 < st.size(); ++i) {
+    down_travel_seq_.push_back(
+        data_.travel_duration.find({st[i], st[i + 1]})->second);
+    up_travel_seq_.push_back(
+        data_.travel_duration.find({st[i + 1], st[i]})->second);
+  }
+}
+
+vector<string> LineModel::validate(const LineData &d) {
+  vector<string> errors;
+  if (d.stations.size() < 2) {
+    errors.push_back("a line needs at least two stations");
+  }
+  set<station_id_t> seen;
+  for (size_t i = 0; i != d.stations.size(); ++i) {
+    station_id_t id = d.stations[i];
+    string s = "station " + to_string(id);
+    if (!seen.insert(id).second) {
+      errors.push_back(s + " appears more than once");
+    }
+    if (d.supply_arm.find(id) == d.supply_arm.end()) {
+      errors.push_back(s + " is not covered by any supply arm");
+    }
+    auto std_it = d.stop_duration.find(id);
+    auto min_it = d.stop_duration_min.find(id);
+    auto max_it = d.stop_duration_max.find(id);
+    if (std_it == d.stop_duration.end() ||
+        min_it == d.stop_duration_min.end() ||
+        max_it == d.stop_duration_max.end()) {
+      errors.push_back(s + " has no stop duration std/min/max");
+    } else if (!(0 <= min_it->second && min_it->second <= std_it->second &&
+                 std_it->second <= max_it->second)) {
+      errors.push_back(s + " stop duration violates 0 <= min <= std <= max");
+    }
+    if (i + 1 == d.stations.size()) {
+      continue;
+    }
+    station_id_t next = d.stations[i + 1];
+    for (const auto &iv : {make_pair(id, next), make_pair(next, id)}) {
+      auto finder = d.travel_duration.find(iv);
+      string iv_s = "interval (" + to_string(iv.first) + ", " +
+                    to_string(iv.second) + ")";
+      if (finder == d.travel_duration.end()) {
+        errors.push_back(iv_s + " has no travel duration");
+      } else if (finder->second <= 0) {
+        errors.push_back(iv_s + " travel duration must be positive");
+      }
+    }
+  }
+  if (d.produce_duration <= 0 || d.consume_duration <= 0) {
+    errors.push_back("produce/consume durations must be positive");
+  }
+  if (d.consume_vec.size() != static_cast<size_t>(d.consume_duration)) {
+    errors.push_back("consume curve length differs from consume_duration");
+  }
+  if (d.produce_vec.size() != static_cast<size_t>(d.produce_duration)) {
+    errors.push_back("produce curve length differs from produce_duration");
+  }
+  if (d.first_train_time < 0 || d.first_train_time >= d.last_train_time) {
+    errors.push_back("train window must satisfy 0 <= first < last");
+  }
+  // 曲线从0秒开始: 首班车到达第二个车站前的产能窗口最早, 停站时长取下限.
+  // 用能窗口从离站时刻开始, 不会早于first_train_time
+  if (d.stations.size() >= 2) {
+    const auto &st = d.stations;
+    for (const auto &iv : {make_pair(st[0], st[1]),
+                           make_pair(st.back(), st[st.size() - 2])}) {
+      auto stop_it = d.stop_duration_min.find(iv.first);
+      auto travel_it = d.travel_duration.find(iv);
+      if (stop_it == d.stop_duration_min.end() ||
+          travel_it == d.travel_duration.end()) {
+        continue; // 已在上面报告
+      }
+      int64_t beg = static_cast<int64_t>(d.first_train_time) +
+                    stop_it->second + travel_it->second - d.produce_duration;
+      if (beg < 0) {
+        errors.push_back("first produce window at station " +
+                         to_string(iv.second) + " starts before 0 s");
+      }
+    }
+  }
+  validate_departure_T(d, errors);
+  return errors;
+}
+
+second_t LineModel::find_departure_T(second_t t, const departure_T_t &dT) {
+  for (const auto &dt : dT) {
+    if (t >= dt.first.first && t < dt.first.second) {
+      return dt.second;
+    }
+  }
+  return 0;
+}
+
+shared_ptr<const LineModel> LineModel::default_model() {
+  static shared_ptr<const LineModel> model =
+      std::make_shared<const LineModel>(LineData());
+  return model;
+}
+
+shared_ptr<const LineModel> LineModel::load_from_file(const string &f) {
+  ifstream in(f);
+  if (!in.is_open()) {
+    throw std::runtime_error("Failed to open [" + f + "] !");
+  }
+  LineData d;
+  try {
+    json j = json::parse(in);
+    d.stations.clear();
+    d.supply_arm.clear();
+    d.stop_duration.clear();
+    d.stop_duration_min.clear();
+    d.stop_duration_max.clear();
+    for (const auto &s : j.at("stations")) {
+      auto id = s.at("id").get<station_id_t>();
+      d.stations.push_back(id);
+      d.supply_arm[id] = s.at("supply_arm").get<supply_arm_id_t>();
+      d.stop_duration[id] = s.at("stop_duration").get<second_t>();
+      d.stop_duration_min[id] = s.at("stop_duration_min").get<second_t>();
+      d.stop_duration_max[id] = s.at("stop_duration_max").get<second_t>();
+    }
+    d.travel_duration.clear();
+    for (const auto &t : j.at("travel_duration")) {
+      d.travel_duration[{t.at("from").get<station_id_t>(),
+                         t.at("to").get<station_id_t>()}] =
+          t.at("duration").get<second_t>();
+    }
+    d.produce_duration = j.at("produce_duration").get<second_t>();
+    d.consume_duration = j.at("consume_duration").get<second_t>();
+    d.departure_T = parse_headway(j.at("headway"), "std");
+    d.departure_T_min = parse_headway(j.at("headway"), "min");
+    d.departure_T_max = parse_headway(j.at("headway"), "max");
+    d.first_train_time = j.at("first_train_time").get<second_t>();
+    d.last_train_time = j.at("last_train_time").get<second_t>();
+    d.consume_vec = j.at("consume_curve").get<P_curve_t>();
+    d.produce_vec = j.at("produce_curve").get<P_curve_t>();
+  } catch (const json::exception &e) {
+    throw std::runtime_error("Failed to parse [" + f + "] : " + e.what());
+  }
+  return std::make_shared<const LineModel>(std::move(d));
+}
+
+shared_ptr<const LineModel> LineModel::current() {
+  return std::atomic_load(&current_model());
+}
+
+void LineModel::set_current(shared_ptr<const LineModel> model) {
+  std::atomic_store(&current_model(), std::move(model));
+}
+
+uint64_t LineModel::hash() const {
+  Fnv1a h;
+  h.add(data_.stations);
+  h.add(data_.supply_arm);
+  h.add(data_.travel_duration);
+  h.add(data_.produce_duration);
+  h.add(data_.consume_duration);
+  h.add(data_.stop_duration);
+  h.add(data_.stop_duration_min);
+  h.add(data_.stop_duration_max);
+  h.add(data_.departure_T);
+  h.add(data_.departure_T_min);
+  h.add(data_.departure_T_max);
+  h.add(data_.first_train_time);
+  h.add(data_.last_train_time);
+  h.add(data_.consume_vec);
+  h.add(data_.produce_vec);
+  return h.value();
+}
+
+bool LineModel::write_to_file(const string &f) const {
+  BufferedFile of(f);
+  if (!of.is_open()) {
+    std::cout << "Failed to open [" << f << "] !" << std::endl;
+    return false;
+  }
+  JsonWriter w(of);
+  w.begin_object();
+  w.key("stations");
+  w.begin_array();
+  for (station_id_t id : data_.stations) {
+    w.begin_object();
+    w.key("id");
+    w.value(id);
+    w.key("supply_arm");
+    w.value(data_.supply_arm.find(id)->second);
+    w.key("stop_duration");
+    w.value(data_.stop_duration.find(id)->second);
+    w.key("stop_duration_min");
+    w.value(data_.stop_duration_min.find(id)->second);
+    w.key("stop_duration_max");
+    w.value(data_.stop_duration_max.find(id)->second);
+    w.end_object();
+  }
+  w.end_array();
+  w.key("travel_duration");
+  w.begin_array();
+  for (const auto &t : data_.travel_duration) {
+    w.begin_object();
+    w.key("from");
+    w.value(t.first.first);
+    w.key("to");
+    w.value(t.first.second);
+    w.key("duration");
+    w.value(t.second);
+    w.end_object();
+  }
+  w.end_array();
+  w.key("produce_duration");
+  w.value(data_.produce_duration);
+  w.key("consume_duration");
+  w.value(data_.consume_duration);
+  w.key("headway");
+  w.begin_array();
+  for (const auto &dt : data_.departure_T) {
+    w.begin_object();
+    w.key("begin");
+    w.value(dt.first.first);
+    w.key("end");
+    w.value(dt.first.second);
+    w.key("std");
+    w.value(dt.second);
+    w.key("min");
+    w.value(data_.departure_T_min.find(dt.first)->second);
+    w.key("max");
+    w.value(data_.departure_T_max.find(dt.first)->second);
+    w.end_object();
+  }
+  w.end_array();
+  w.key("first_train_time");
+  w.value(data_.first_train_time);
+  w.key("last_train_time");
+  w.value(data_.last_train_time);
+  w.key("consume_curve");
+  w.begin_array();
+  for (double p : data_.consume_vec) {
+    w.value(p);
+  }
+  w.end_array();
+  w.key("produce_curve");
+  w.begin_array();
+  for (double p : data_.produce_vec) {
+    w.value(p);
+  }
+  w.end_array();
+  w.end_object();
+  of.put('\n');
+  if (!of.close()) {
+    std::cout << "Failed to write [" << f << "] !" << std::endl;
+    return false;
+  }
+  std::cout << "Save file [" << f << "] successful!" << std::endl;
+  return true;
+}
+
+} // namespace yaohui
@@ -0,0 +1,72 @@
+#include "MetropolisChain.hpp"
+#include "PhaseTimer.hpp"
+#include <cmath>
+
+namespace yaohui {
+
+MetropolisChain::MetropolisChain(Evaluator *ev, size_t resync_every)
+    : ev_(ev), current_(ev->ratio()), best_(current_),
+      best_genome_(ev->genome()), resync_every_(resync_every) {}
+
+bool MetropolisChain::step(std::default_random_engine &e, double T) {
+  YAOHUI_PHASE_SCOPE(Phase::kMove);
+  bool accepted = false;
+  Evaluator::Move move;
+  if (ev_->random_move(e, move)) {
+    double next = ev_->apply(move);
+    double gain = next - current_;
+    if (gain >= 0.0 ||
+        (T > 0.0 && std::uniform_real_distribution<double>(0.0, 1.0)(e) <
+                        std::exp(gain / T))) {
+      if (next > best_) {
+        best_ = next;
+        at_best_ = true;
+      } else if (at_best_ && gain < 0.0) {
+        // 撤销后保存最好解, 再重新执行这次移动
+        move.delta = -move.delta;
+        ev_->apply(move);
+        best_genome_ = ev_->genome();
+        move.delta = -move.delta;
+        ev_->apply(move);
+        at_best_ = false;
+      }
+      current_ = next;
+      accepted = true;
+    } else {
+      move.delta = -move.delta;
+      current_ = ev_->apply(move);
+    }
+  }
+  if (++since_resync_ == resync_every_) {
+    ev_->resync();
+    current_ = ev_->ratio();
+    since_resync_ = 0;
+  }
+  return accepted;
+}
+
+void MetropolisChain::reset(Evaluator *ev) {
+  ev_ = ev;
+  current_ = ev_->ratio();
+  at_best_ = false;
+  if (current_ > best_) {
+    best_ = current_;
+    at_best_ = true;
+  }
+}
+
+void MetropolisChain::save_best() {
+  if (at_best_) {
+    best_genome_ = ev_->genome();
+    at_best_ = false;
+  }
+}
+
+Evaluator *MetropolisChain::state() const { return ev_; }
+double MetropolisChain::current() const { return current_; }
+double MetropolisChain::best() const { return best_; }
+const std::vector<second_t> &MetropolisChain::best_genome() const {
+  return best_genome_;
+}
+
+} // namespace yaohui
@@ -0,0 +1,192 @@
+#include "ParallelTempering.hpp"
+#include "CsvWriter.hpp"
+#include "MetropolisChain.hpp"
+#include "ThreadPool.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <future>
+#include <iostream>
+#include <random>
+#include <thread>
+
+namespace yaohui {
+
+ParallelTempering::ParallelTempering(size_t steps, size_t replica_cnt,
+                                     double t_min, double t_max,
+                                     size_t exchange_every,
+                                     const TimetableConfig &start_config)
+    : ParallelTempering(
+          steps, replica_cnt, t_min, t_max, exchange_every, start_config,
+          static_cast<unsigned>(
+              std::chrono::system_clock::now().time_since_epoch().count())) {}
+
+ParallelTempering::ParallelTempering(size_t steps, size_t replica_cnt,
+                                     double t_min, double t_max,
+                                     size_t exchange_every,
+                                     const TimetableConfig &start_config,
+                                     unsigned seed)
+    : steps_(steps), replica_cnt_(replica_cnt), t_min_(t_min), t_max_(t_max),
+      exchange_every_(std::max<size_t>(1, exchange_every)), seed_(seed),
+      first_individual_(Individual::from_config(start_config)),
+      best_individual_(first_individual_) {
+  if (replica_cnt_ == 0) {
+    replica_cnt_ = std::max(1u, std::thread::hardware_concurrency());
+  }
+  // 温度按等比数列排列, 第0层最冷
+  for (size_t k = 0; k != replica_cnt_; ++k) {
+    double x = replica_cnt_ < 2 ? 0.0
+                                : static_cast<double>(k) /
+                                      static_cast<double>(replica_cnt_ - 1);
+    temperatures_.push_back(t_min_ * std::pow(t_max_ / t_min_, x));
+  }
+}
+
+const Individual &ParallelTempering::individual_before_optimize() const {
+  return first_individual_;
+}
+
+const Individual &ParallelTempering::individual_after_optimize() const {
+  return best_individual_;
+}
+
+void ParallelTempering::do_optimization() {
+  std::cout << "Parallel tempering with " << replica_cnt_ << " replicas..."
+            << std::endl;
+  Evaluator start(first_individual_.timetable_config());
+  states_.clear();
+  for (size_t k = 0; k != replica_cnt_; ++k) {
+    states_.emplace_back(new Evaluator(start));
+  }
+  slots_.reset(new ExchangeSlot[replica_cnt_]);
+
+  std::seed_seq seeds{seed_};
+  std::vector<unsigned> level_seeds(replica_cnt_);
+  seeds.generate(level_seeds.begin(), level_seeds.end());
+
+  // 相邻层在交换时互相等待, 每层必须独占一个线程
+  results_.clear();
+  {
+    ThreadPool pool(replica_cnt_);
+    std::vector<std::future<LevelResult>> fut_vec;
+    for (size_t k = 0; k != replica_cnt_; ++k) {
+      unsigned seed = level_seeds[k];
+      fut_vec.push_back(
+          pool.submit([this, k, seed] { return run_level(k, seed); }));
+    }
+    for (auto &fut : fut_vec) {
+      results_.push_back(fut.get());
+    }
+  }
+
+  // 各层经过的最好解中取最好的, 以Timetable重新评分
+  size_t best_level = 0;
+  for (size_t k = 1; k != results_.size(); ++k) {
+    if (results_[k].best > results_[best_level].best) {
+      best_level = k;
+    }
+  }
+  for (size_t k = 0; k != results_.size(); ++k) {
+    std::cout << "Level: " << k << "\tTemperature: " << temperatures_[k]
+              << "\tCurrent: " << results_[k].current
+              << "\tBest: " << results_[k].best << std::endl;
+  }
+  Evaluator &ev = *states_.front();
+  ev.set_genome(results_[best_level].genome);
+  best_individual_ = Individual::from_config(ev.config());
+  if (best_individual_.score() < first_individual_.score()) {
+    best_individual_ = first_individual_;
+  }
+  std::cout << "optimization finished!" << std::endl;
+}
+
+ParallelTempering::LevelResult ParallelTempering::run_level(size_t level,
+                                                            unsigned seed) {
+  std::default_random_engine e(seed);
+  std::uniform_real_distribution<double> u(0.0, 1.0);
+  const double T = temperatures_[level];
+  MetropolisChain chain(states_[level].get());
+  LevelResult result;
+
+  for (size_t step = 0; step != steps_; ++step) {
+    chain.step(e, T);
+    if ((step + 1) % exchange_every_ != 0) {
+      continue;
+    }
+    const int64_t r = static_cast<int64_t>((step + 1) / exchange_every_);
+    // 第r轮中k与r同奇偶的层k与k+1交换, 本层作为上层或下层, 或者轮空
+    if (level != 0 && (level - 1) % 2 == static_cast<size_t>(r % 2)) {
+      ExchangeSlot &slot = slots_[level - 1];
+      chain.save_best();
+      slot.upper_ratio = chain.current();
+      slot.upper_state = chain.state();
+      slot.posted.store(r, std::memory_order_release);
+      while (slot.replied.load(std::memory_order_acquire) != r) {
+        std::this_thread::yield();
+      }
+      if (slot.swapped) {
+        chain.reset(slot.lower_state);
+      }
+    } else if (level + 1 != replica_cnt_ &&
+               level % 2 == static_cast<size_t>(r % 2)) {
+      ExchangeSlot &slot = slots_[level];
+      while (slot.posted.load(std::memory_order_acquire) != r) {
+        std::this_thread::yield();
+      }
+      double beta_diff = 1.0 / T - 1.0 / temperatures_[level + 1];
+      double x = beta_diff * (slot.upper_ratio - chain.current());
+      ++result.swap_attempts;
+      slot.swapped = x >= 0.0 || u(e) < std::exp(x);
+      if (slot.swapped) {
+        ++result.swap_accepted;
+        chain.save_best();
+        slot.lower_state = chain.state();
+        chain.reset(slot.upper_state);
+      }
+      slot.replied.store(r, std::memory_order_release);
+    }
+  }
+  chain.save_best();
+  result.current = chain.current();
+  result.best = chain.best();
+  result.genome = chain.best_genome();
+  return result;
+}
+
+bool ParallelTempering::output_optimization_result(
+    const std::string &f_name) const {
+  CsvWriter output(f_name);
+  if (!output.is_open()) {
+    std::cout << "Failed to open [" << f_name << "] !" << std::endl;
+    return false;
+  }
+  output.field("level")
+      .field("temperature")
+      .field("current_fitness")
+      .field("best_fitness")
+      .field("swap_attempts")
+      .field("swap_accept_rate")
+      .end_row();
+  for (size_t k = 0; k != results_.size(); ++k) {
+    const LevelResult &r = results_[k];
+    double rate = r.swap_attempts == 0
+                      ? 0.0
+                      : static_cast<double>(r.swap_accepted) /
+                            static_cast<double>(r.swap_attempts);
+    output.field(static_cast<int64_t>(k))
+        .field(temperatures_[k])
+        .field(r.current)
+        .field(r.best)
+        .field(static_cast<int64_t>(r.swap_attempts))
+        .field(rate)
+        .end_row();
+  }
+  if (!output.close()) {
+    std::cout << "Failed to write [" << f_name << "] !" << std::endl;
+    return false;
+  }
+  std::cout << "Save file [" << f_name << "] successful!" << std::endl;
+  return true;
+}
+
+} // namespace yaohui
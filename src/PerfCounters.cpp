@@ -0,0 +1,96 @@
+#include "PerfCounters.hpp"
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#endif
+
+namespace yaohui {
+
+const char *perf_event_name(PerfEvent event) {
+  switch (event) {
+  case PerfEvent::kCycles:
+    return "cycles";
+  case PerfEvent::kInstructions:
+    return "instructions";
+  case PerfEvent::kCacheMisses:
+    return "cache_misses";
+  case PerfEvent::kBranchMisses:
+    return "branch_misses";
+  default:
+    return "unknown";
+  }
+}
+
+PerfCounters::PerfCounters() {
+  fds_.fill(-1);
+  slots_.fill(0);
+#ifdef __linux__
+  const uint64_t configs[kPerfEventCnt] = {
+      PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+      PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES};
+  for (size_t i = 0; i != kPerfEventCnt; ++i) {
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = configs[i];
+    attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED |
+                       PERF_FORMAT_TOTAL_TIME_RUNNING;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    // pid = 0, cpu = -1: 调用线程, 在任意CPU上
+    int fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1,
+                                      leader_, PERF_FLAG_FD_CLOEXEC));
+    if (fd < 0) {
+      if (error_.empty()) {
+        error_ = std::string(perf_event_name(static_cast<PerfEvent>(i))) +
+                 ": " + std::strerror(errno);
+      }
+      continue;
+    }
+    if (leader_ < 0) {
+      leader_ = fd;
+    }
+    fds_[i] = fd;
+    slots_[i] = member_cnt_++;
+  }
+#else
+  error_ = "perf_event_open is only available on Linux";
+#endif
+}
+
+PerfCounters::~PerfCounters() {
+  for (int fd : fds_) {
+    if (fd >= 0) {
+      ::close(fd);
+    }
+  }
+}
+
+bool PerfCounters::available(PerfEvent event) const {
+  return fds_[static_cast<size_t>(event)] >= 0;
+}
+
+bool PerfCounters::read(PerfReading &reading) const {
+  if (member_cnt_ == 0) {
+    return false;
+  }
+  // 组读数的格式: 事件数, 启用时间, 计数时间, 之后按打开顺序排列各事件的数值
+  uint64_t buf[3 + kPerfEventCnt];
+  size_t expected = (3 + member_cnt_) * sizeof(uint64_t);
+  ssize_t n = ::read(leader_, buf, sizeof(buf));
+  if (n != static_cast<ssize_t>(expected) || buf[0] != member_cnt_) {
+    return false;
+  }
+  reading.time_enabled = buf[1];
+  reading.time_running = buf[2];
+  for (size_t i = 0; i != kPerfEventCnt; ++i) {
+    reading.values[i] = fds_[i] >= 0 ? buf[3 + slots_[i]] : 0;
+  }
+  return true;
+}
+
+} // namespace yaohui
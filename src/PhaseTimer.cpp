@@ -0,0 +1,364 @@
+#include "PhaseTimer.hpp"
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace yaohui {
+
+namespace {
+
+// 一个线程的计数器. 只有所属线程写入, 因此用load + store代替读改写
+struct ThreadCounters {
+  std::array<std::atomic<uint64_t>, kPhaseCnt> ns;
+  std::array<std::atomic<uint64_t>, kPhaseCnt> calls;
+  std::array<std::atomic<uint64_t>, kPhaseCnt + 1> alloc_cnt;
+  std::array<std::atomic<uint64_t>, kPhaseCnt + 1> alloc_bytes;
+  std::array<std::array<std::atomic<uint64_t>, kPerfEventCnt>, kPhaseCnt> perf;
+  std::atomic<bool> in_use;
+  PhaseTotals reported; // 上次collect时的数值, 只由collect访问
+
+  ThreadCounters() : in_use(true), reported() {
+    for (size_t i = 0; i != kPhaseCnt; ++i) {
+      ns[i].store(0, std::memory_order_relaxed);
+      calls[i].store(0, std::memory_order_relaxed);
+      for (auto &v : perf[i]) {
+        v.store(0, std::memory_order_relaxed);
+      }
+    }
+    for (size_t i = 0; i != kPhaseCnt + 1; ++i) {
+      alloc_cnt[i].store(0, std::memory_order_relaxed);
+      alloc_bytes[i].store(0, std::memory_order_relaxed);
+    }
+  }
+};
+
+void add(std::atomic<uint64_t> &counter, uint64_t v) {
+  counter.store(counter.load(std::memory_order_relaxed) + v,
+                std::memory_order_relaxed);
+}
+
+std::mutex &registry_mutex() {
+  static std::mutex m;
+  return m;
+}
+
+// 所有线程的计数器, deque保证元素地址不变
+std::deque<ThreadCounters> &registry() {
+  static std::deque<ThreadCounters> counters;
+  return counters;
+}
+
+// 尚未取得计数器的线程的分配, 多个线程共用
+std::atomic<uint64_t> g_orphan_alloc_cnt(0);
+std::atomic<uint64_t> g_orphan_alloc_bytes(0);
+uint64_t g_orphan_reported_cnt = 0;   // 只由collect访问
+uint64_t g_orphan_reported_bytes = 0; // 只由collect访问
+
+// 硬件计数器. g_perf_available只在启用时写入一次
+std::atomic<bool> g_perf_enabled(false);
+std::array<bool, kPerfEventCnt> g_perf_available = {};
+std::atomic<bool> g_perf_scaled(false);     // 有时段的计数按比例放大过
+std::atomic<bool> g_perf_unmeasured(false); // 有时段完全没有计数
+
+// 本线程的计时状态. 均为常量初始化, 分配钩子中访问时不会触发动态初始化
+thread_local ThreadCounters *t_counters = nullptr;
+thread_local Phase t_current = Phase::kCount; // 当前所在的最内层阶段
+thread_local std::chrono::steady_clock::time_point t_since;
+thread_local PerfCounters *t_perf = nullptr; // 未启用或打开失败时为空
+thread_local PerfReading t_perf_since;       // 上次读到的硬件计数
+
+// 线程退出时归还计数器, 只在取得计数器时访问
+struct CountersReleaser {
+  ~CountersReleaser() {
+    if (t_counters != nullptr) {
+      t_counters->in_use.store(false, std::memory_order_release);
+      t_counters = nullptr; // 之后的分配计入公共计数器
+    }
+    delete t_perf;
+    t_perf = nullptr;
+  }
+};
+thread_local CountersReleaser t_releaser;
+
+ThreadCounters &thread_counters() {
+  if (t_counters == nullptr) {
+    std::lock_guard<std::mutex> lock(registry_mutex());
+    ThreadCounters *free_slot = nullptr;
+    for (auto &c : registry()) {
+      if (!c.in_use.load(std::memory_order_acquire)) {
+        c.in_use.store(true, std::memory_order_relaxed);
+        free_slot = &c;
+        break;
+      }
+    }
+    if (free_slot == nullptr) {
+      registry().emplace_back();
+      free_slot = &registry().back();
+    }
+    static_cast<void>(&t_releaser); // 注册线程退出时的析构
+    if (g_perf_enabled.load(std::memory_order_acquire)) {
+      std::unique_ptr<PerfCounters> perf(new PerfCounters());
+      if (perf->read(t_perf_since)) {
+        t_perf = perf.release();
+      }
+    }
+    t_counters = free_slot;
+  }
+  return *t_counters;
+}
+
+uint64_t elapsed_ns(std::chrono::steady_clock::time_point beg,
+                    std::chrono::steady_clock::time_point end) {
+  return static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(end - beg).count());
+}
+
+// 把本线程自上次读数以来的硬件计数计入phase, phase为kCount时只更新读数
+// 组与其他事件分时复用PMU时, 按enabled / running把计数放大为整个时段的估计
+void charge_perf(ThreadCounters &c, Phase phase) {
+  PerfReading now;
+  if (!t_perf->read(now)) {
+    return;
+  }
+  if (phase != Phase::kCount) {
+    uint64_t enabled = now.time_enabled - t_perf_since.time_enabled;
+    uint64_t running = now.time_running - t_perf_since.time_running;
+    double scale = 1.0;
+    if (running < enabled) {
+      if (running == 0) {
+        g_perf_unmeasured.store(true, std::memory_order_relaxed);
+      } else {
+        g_perf_scaled.store(true, std::memory_order_relaxed);
+        scale = static_cast<double>(enabled) / static_cast<double>(running);
+      }
+    }
+    auto &perf = c.perf[static_cast<size_t>(phase)];
+    for (size_t i = 0; i != kPerfEventCnt; ++i) {
+      uint64_t d = now.values[i] - t_perf_since.values[i];
+      if (scale != 1.0) {
+        d = static_cast<uint64_t>(std::llround(static_cast<double>(d) * scale));
+      }
+      add(perf[i], d);
+    }
+  }
+  t_perf_since = now;
+}
+
+} // namespace
+
+const char *phase_name(Phase phase) {
+  switch (phase) {
+  case Phase::kBirth:
+    return "birth";
+  case Phase::kSelection:
+    return "selection";
+  case Phase::kCrossover:
+    return "crossover";
+  case Phase::kEvaluation:
+    return "evaluation";
+  case Phase::kMove:
+    return "move";
+  case Phase::kMutation:
+    return "mutation";
+  case Phase::kSort:
+    return "sort";
+  case Phase::kLocalSearch:
+    return "local_search";
+  case Phase::kStatistics:
+    return "statistics";
+  case Phase::kLogging:
+    return "logging";
+  case Phase::kCheckpoint:
+    return "checkpoint";
+  default:
+    return "other";
+  }
+}
+
+ScopedPhase::ScopedPhase(Phase phase) : phase_(phase) {
+  ThreadCounters &c = thread_counters();
+  parent_ = t_current;
+  if (t_perf != nullptr) {
+    charge_perf(c, parent_);
+  }
+  auto now = std::chrono::steady_clock::now();
+  if (parent_ != Phase::kCount) {
+    add(c.ns[static_cast<size_t>(parent_)], elapsed_ns(t_since, now));
+  }
+  add(c.calls[static_cast<size_t>(phase_)], 1);
+  t_current = phase_;
+  t_since = now;
+}
+
+ScopedPhase::~ScopedPhase() {
+  auto now = std::chrono::steady_clock::now();
+  add(t_counters->ns[static_cast<size_t>(phase_)], elapsed_ns(t_since, now));
+  if (t_perf != nullptr) {
+    charge_perf(*t_counters, phase_);
+  }
+  t_current = parent_;
+  t_since = now;
+}
+
+void ScopedPhase::note_allocation(size_t bytes) {
+  ThreadCounters *c = t_counters;
+  if (c == nullptr) {
+    g_orphan_alloc_cnt.fetch_add(1, std::memory_order_relaxed);
+    g_orphan_alloc_bytes.fetch_add(bytes, std::memory_order_relaxed);
+    return;
+  }
+  size_t i = static_cast<size_t>(t_current); // 不在任何阶段时为kPhaseCnt
+  add(c->alloc_cnt[i], 1);
+  add(c->alloc_bytes[i], bytes);
+}
+
+PhaseTotals ScopedPhase::collect() {
+  PhaseTotals ret = PhaseTotals();
+  std::lock_guard<std::mutex> lock(registry_mutex());
+  // 与上次的数值相减, 不写入其他线程的计数器
+  auto diff = [](uint64_t now, uint64_t &reported) {
+    uint64_t d = now - reported;
+    reported = now;
+    return d;
+  };
+  for (auto &c : registry()) {
+    for (size_t i = 0; i != kPhaseCnt; ++i) {
+      ret.ns[i] +=
+          diff(c.ns[i].load(std::memory_order_relaxed), c.reported.ns[i]);
+      ret.calls[i] +=
+          diff(c.calls[i].load(std::memory_order_relaxed), c.reported.calls[i]);
+      for (size_t j = 0; j != kPerfEventCnt; ++j) {
+        ret.perf[i][j] += diff(c.perf[i][j].load(std::memory_order_relaxed),
+                               c.reported.perf[i][j]);
+      }
+    }
+    for (size_t i = 0; i != kPhaseCnt + 1; ++i) {
+      ret.alloc_cnt[i] += diff(c.alloc_cnt[i].load(std::memory_order_relaxed),
+                               c.reported.alloc_cnt[i]);
+      ret.alloc_bytes[i] +=
+          diff(c.alloc_bytes[i].load(std::memory_order_relaxed),
+               c.reported.alloc_bytes[i]);
+    }
+  }
+  ret.alloc_cnt[kPhaseCnt] +=
+      diff(g_orphan_alloc_cnt.load(std::memory_order_relaxed),
+           g_orphan_reported_cnt);
+  ret.alloc_bytes[kPhaseCnt] +=
+      diff(g_orphan_alloc_bytes.load(std::memory_order_relaxed),
+           g_orphan_reported_bytes);
+  return ret;
+}
+
+bool ScopedPhase::allocation_tracking() {
+#if defined(YAOHUI_ALLOC_TRACKING) && defined(YAOHUI_PHASE_TIMERS)
+  return true;
+#else
+  return false;
+#endif
+}
+
+bool ScopedPhase::enable_perf_counters() {
+#ifndef YAOHUI_PHASE_TIMERS
+  std::cout << "Hardware performance counters need YAOHUI_PHASE_TIMERS"
+            << std::endl;
+  return false;
+#else
+  PerfCounters probe;
+  for (size_t i = 0; i != kPerfEventCnt; ++i) {
+    g_perf_available[i] = probe.available(static_cast<PerfEvent>(i));
+  }
+  if (!probe.any_available()) {
+    std::cout << "Hardware performance counters are unavailable ("
+              << probe.error() << ")" << std::endl;
+    return false;
+  }
+  if (!probe.error().empty()) {
+    std::cout << "Some hardware performance counters are unavailable ("
+              << probe.error() << ")" << std::endl;
+  }
+  g_perf_enabled.store(true, std::memory_order_release);
+  return true;
+#endif
+}
+
+bool ScopedPhase::perf_counters_enabled() {
+  return g_perf_enabled.load(std::memory_order_acquire);
+}
+
+bool ScopedPhase::perf_event_available(PerfEvent event) {
+  return perf_counters_enabled() &&
+         g_perf_available[static_cast<size_t>(event)];
+}
+
+bool ScopedPhase::perf_counts_scaled() {
+  return g_perf_scaled.load(std::memory_order_relaxed);
+}
+
+bool ScopedPhase::perf_counts_unmeasured() {
+  return g_perf_unmeasured.load(std::memory_order_relaxed);
+}
+
+void print_perf_summary(const std::array<perf_values_t, kPhaseCnt> &perf) {
+  if (!ScopedPhase::perf_counters_enabled()) {
+    return;
+  }
+  // 不可用的事件显示为n/a. 有时段完全没有计数时各阶段的计数都偏低,
+  // 全部显示为n/a
+  const bool unmeasured = ScopedPhase::perf_counts_unmeasured();
+  if (unmeasured) {
+    std::printf("Hardware counters were multiplexed and some intervals were "
+                "never counted, counts are n/a\n");
+  } else if (ScopedPhase::perf_counts_scaled()) {
+    std::printf("Hardware counters were multiplexed, counts are scaled by "
+                "time_enabled / time_running\n");
+  }
+  auto cell = [](bool available, double v, const char *fmt) {
+    if (!available) {
+      return std::string("n/a");
+    }
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), fmt, v);
+    return std::string(buf);
+  };
+  auto available = [unmeasured](PerfEvent event) {
+    return !unmeasured && ScopedPhase::perf_event_available(event);
+  };
+  std::printf("%-14s %16s %16s %8s %12s %12s\n", "phase", "cycles",
+              "instructions", "IPC", "cache MPKI", "branch MPKI");
+  for (size_t i = 0; i != kPhaseCnt; ++i) {
+    auto get = [&](PerfEvent event) {
+      return static_cast<double>(perf[i][static_cast<size_t>(event)]);
+    };
+    double cycles = get(PerfEvent::kCycles);
+    double instructions = get(PerfEvent::kInstructions);
+    // 每千条指令的事件数
+    auto per_kilo = [&](PerfEvent event) {
+      return instructions > 0.0 ? get(event) * 1000.0 / instructions : 0.0;
+    };
+    bool has_ipc = available(PerfEvent::kCycles) &&
+                   available(PerfEvent::kInstructions);
+    bool has_mpki = available(PerfEvent::kInstructions);
+    std::printf(
+        "%-14s %16s %16s %8s %12s %12s\n", phase_name(static_cast<Phase>(i)),
+        cell(available(PerfEvent::kCycles), cycles, "%.0f").c_str(),
+        cell(available(PerfEvent::kInstructions), instructions, "%.0f")
+            .c_str(),
+        cell(has_ipc, cycles > 0.0 ? instructions / cycles : 0.0, "%.3f")
+            .c_str(),
+        cell(has_mpki && available(PerfEvent::kCacheMisses),
+             per_kilo(PerfEvent::kCacheMisses), "%.3f")
+            .c_str(),
+        cell(has_mpki && available(PerfEvent::kBranchMisses),
+             per_kilo(PerfEvent::kBranchMisses), "%.3f")
+            .c_str());
+  }
+  std::fflush(stdout);
+}
+
+} // namespace yaohui
@@ -0,0 +1,261 @@
+#include "QuasiRandomSampler.hpp"
+#include <algorithm>
+#include <future>
+#include <numeric>
+
+namespace yaohui {
+
+namespace {
+
+// GF(2)上的多项式乘法取模, 多项式以二进制位表示, mod的次数为degree
+uint64_t gf2_mul_mod(uint64_t a, uint64_t b, uint64_t mod, unsigned degree) {
+  uint64_t ret = 0;
+  while (b != 0) {
+    if (b & 1) {
+      ret ^= a;
+    }
+    b >>= 1;
+    a <<= 1;
+    if (a >> degree & 1) {
+      a ^= mod;
+    }
+  }
+  return ret;
+}
+
+// x^e mod p
+uint64_t gf2_pow_x(uint64_t e, uint64_t mod, unsigned degree) {
+  uint64_t ret = 1;
+  uint64_t base = degree == 1 ? (2 ^ mod) : 2;
+  while (e != 0) {
+    if (e & 1) {
+      ret = gf2_mul_mod(ret, base, mod, degree);
+    }
+    base = gf2_mul_mod(base, base, mod, degree);
+    e >>= 1;
+  }
+  return ret;
+}
+
+// x在GF(2)[x]/p中的阶为2^degree-1时p为本原多项式
+bool is_primitive(uint64_t p, unsigned degree) {
+  const uint64_t order = (uint64_t(1) << degree) - 1;
+  if (gf2_pow_x(order, p, degree) != 1) {
+    return false;
+  }
+  uint64_t n = order;
+  for (uint64_t f = 2; f * f <= n; ++f) {
+    if (n % f != 0) {
+      continue;
+    }
+    while (n % f == 0) {
+      n /= f;
+    }
+    if (gf2_pow_x(order / f, p, degree) == 1) {
+      return false;
+    }
+  }
+  if (n > 1 && n != order && gf2_pow_x(order / n, p, degree) == 1) {
+    return false;
+  }
+  return true;
+}
+
+// 按次数由低到高生成cnt个本原多项式
+std::vector<uint64_t> primitive_polynomials(size_t cnt) {
+  std::vector<uint64_t> ret;
+  for (unsigned degree = 1; ret.size() < cnt && degree < 32; ++degree) {
+    // 常数项必须为1
+    for (uint64_t p = (uint64_t(1) << degree) | 1;
+         p < (uint64_t(1) << (degree + 1)) && ret.size() < cnt; p += 2) {
+      if (is_primitive(p, degree)) {
+        ret.push_back(p);
+      }
+    }
+  }
+  return ret;
+}
+
+unsigned degree_of(uint64_t p) {
+  unsigned d = 0;
+  while (p >> (d + 1)) {
+    ++d;
+  }
+  return d;
+}
+
+// [lo, hi]中的整数, u位于[0, 1)
+second_t scale(double u, second_t lo, second_t hi) {
+  if (hi <= lo) {
+    return lo;
+  }
+  auto span = static_cast<second_t>(u * (hi - lo + 1));
+  return lo + std::min(span, hi - lo);
+}
+
+} // namespace
+
+bool parse_sampling_method(const std::string &name, SamplingMethod &method) {
+  if (name == "sobol") {
+    method = SamplingMethod::kSobol;
+    return true;
+  }
+  if (name == "lhs") {
+    method = SamplingMethod::kLatinHypercube;
+    return true;
+  }
+  return false;
+}
+
+DesignSpace::DesignSpace(TimetableConfig base) : base_(std::move(base)) {
+  size_t st_cnt = base_.stations().size();
+  inner_cnt_ = st_cnt > 2 ? st_cnt - 2 : 0;
+}
+
+size_t DesignSpace::dimension() const {
+  size_t de_cnt = 0;
+  for (const auto *de :
+       {&base_.down_departure_time_vec(), &base_.up_departure_time_vec()}) {
+    de_cnt += de->empty() ? 0 : de->size() - 1;
+  }
+  return de_cnt + base_.missions_cnt() * inner_cnt_;
+}
+
+TimetableConfig DesignSpace::decode(const double *u) const {
+  TimetableConfig config = base_;
+  const LineModel &line = config.line();
+  for (auto *de_vec :
+       {&config.down_departure_time_vec(), &config.up_departure_time_vec()}) {
+    first_departure_time_t &de = *de_vec;
+    for (size_t i = 1; i < de.size(); ++i) {
+      second_t prev = de[i - 1];
+      de[i] = prev +
+              scale(*u++,
+                    LineModel::find_departure_T(prev, line.departure_T_min()),
+                    LineModel::find_departure_T(prev, line.departure_T_max()));
+    }
+  }
+  const auto &stations = config.stations();
+  for (auto *stop_vec :
+       {&config.down_stop_duration_vec(), &config.up_stop_duration_vec()}) {
+    for (auto &l : *stop_vec) {
+      for (size_t pos = 1; pos + 1 < stations.size(); ++pos) {
+        station_id_t id = stations[pos];
+        l.at(id) = scale(*u++, line.stop_duration_min().find(id)->second,
+                         line.stop_duration_max().find(id)->second);
+      }
+    }
+  }
+  return config;
+}
+
+SobolSequence::SobolSequence(size_t dimension, unsigned seed)
+    : dimension_(dimension), directions_(dimension * 32),
+      shift_(dimension), state_(dimension, 0) {
+  std::default_random_engine e(seed);
+  std::uniform_int_distribution<uint32_t> u32;
+  // 第0维为van der Corput序列
+  for (unsigned k = 0; k != 32; ++k) {
+    directions_[k] = uint32_t(1) << (31 - k);
+  }
+  std::vector<uint64_t> polys =
+      primitive_polynomials(dimension > 1 ? dimension - 1 : 0);
+  for (size_t j = 1; j < dimension; ++j) {
+    uint64_t p = polys[j - 1];
+    unsigned s = degree_of(p);
+    // m_k为小于2^k的奇数, 前s个随机选取, 其余由递推式生成
+    std::vector<uint64_t> m(33, 0);
+    for (unsigned k = 1; k <= s && k <= 32; ++k) {
+      m[k] = (u32(e) % (uint64_t(1) << k)) | 1;
+    }
+    for (unsigned k = s + 1; k <= 32; ++k) {
+      m[k] = m[k - s] ^ (m[k - s] << s);
+      for (unsigned i = 1; i < s; ++i) {
+        if (p >> (s - i) & 1) {
+          m[k] ^= m[k - i] << i;
+        }
+      }
+    }
+    for (unsigned k = 1; k <= 32; ++k) {
+      directions_[j * 32 + k - 1] = static_cast<uint32_t>(m[k] << (32 - k));
+    }
+  }
+  for (auto &s : shift_) {
+    s = u32(e);
+  }
+}
+
+size_t SobolSequence::dimension() const { return dimension_; }
+
+void SobolSequence::next(double *out) {
+  const double inv = 1.0 / 4294967296.0;
+  for (size_t j = 0; j != dimension_; ++j) {
+    out[j] = static_cast<double>(state_[j] ^ shift_[j]) * inv;
+  }
+  // 格雷码顺序: 翻转index_最低的0位对应的方向数
+  unsigned c = 0;
+  while (index_ >> c & 1) {
+    ++c;
+  }
+  ++index_;
+  if (c < 32) {
+    for (size_t j = 0; j != dimension_; ++j) {
+      state_[j] ^= directions_[j * 32 + c];
+    }
+  }
+}
+
+QuasiRandomSampler::QuasiRandomSampler(SamplingMethod method,
+                                       TimetableConfig base, unsigned seed,
+                                       size_t thread_cnt)
+    : method_(method), space_(std::move(base)), e_(seed),
+      pool_(new ThreadPool(thread_cnt)) {
+  if (method_ == SamplingMethod::kSobol) {
+    sobol_.reset(new SobolSequence(space_.dimension(), seed));
+  }
+}
+
+size_t QuasiRandomSampler::dimension() const { return space_.dimension(); }
+
+std::vector<double> QuasiRandomSampler::next_points(size_t cnt) {
+  const size_t dim = space_.dimension();
+  std::vector<double> points(cnt * dim);
+  if (method_ == SamplingMethod::kSobol) {
+    for (size_t i = 0; i != cnt; ++i) {
+      sobol_->next(points.data() + i * dim);
+    }
+    return points;
+  }
+  // 拉丁超立方: 每一维把[0, 1)等分为cnt层, 每层恰好取一个点
+  std::uniform_real_distribution<double> jitter(0.0, 1.0);
+  std::vector<size_t> perm(cnt);
+  const double layer = 1.0 / static_cast<double>(cnt);
+  for (size_t j = 0; j != dim; ++j) {
+    std::iota(perm.begin(), perm.end(), 0);
+    std::shuffle(perm.begin(), perm.end(), e_);
+    for (size_t i = 0; i != cnt; ++i) {
+      points[i * dim + j] = (static_cast<double>(perm[i]) + jitter(e_)) * layer;
+    }
+  }
+  return points;
+}
+
+std::vector<Individual> QuasiRandomSampler::next_batch(size_t cnt) {
+  const size_t dim = space_.dimension();
+  auto points = std::make_shared<std::vector<double>>(next_points(cnt));
+  std::vector<std::future<Individual>> fut_vec;
+  fut_vec.reserve(cnt);
+  for (size_t i = 0; i != cnt; ++i) {
+    fut_vec.push_back(pool_->submit([this, points, i, dim] {
+      return Individual::from_config(space_.decode(points->data() + i * dim));
+    }));
+  }
+  std::vector<Individual> ret;
+  ret.reserve(cnt);
+  for (auto &fut : fut_vec) {
+    ret.push_back(fut.get());
+  }
+  return ret;
+}
+
+} // namespace yaohui
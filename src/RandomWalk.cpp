@@ -1,18 +1,129 @@
 #include "RandomWalk.hpp"
+#include "CsvWriter.hpp"
+#include "QuasiRandomSampler.hpp"
+#include "ThreadPool.hpp"
+#include <algorithm>
+#include <future>
+#include <memory>
 
 namespace yaohui {
 
-RandomWalk::RandomWalk(size_t pop_cnt, size_t walk_times)
-    : pop_cnt_(pop_cnt), walk_times_(walk_times) {
-  init_pop();
+namespace {
+
+// 适应度(复用率)位于[0, 1]之间
+constexpr double kHistogramLo = 0.0;
+constexpr double kHistogramHi = 1.0;
+constexpr size_t kHistogramBins = 1000;
+// 每个个体攒够这么多样本后写入一次溢出文件
+constexpr size_t kSpillBlock = 4096;
+
+// 单个个体的在线统计结果, 全部个体完成后再合并
+struct WalkSummary {
+  RunningStats stats;
+  TDigest digest;
+  Histogram histogram;
+  std::vector<Individual> best; // 按适应度由大到小排列
+};
+
+// 把individual插入有序的best中, best最多保留k个
+void keep_best(std::vector<Individual> &best, const Individual &individual,
+               size_t k) {
+  if (k == 0 ||
+      (best.size() == k && individual.score() <= best.back().score())) {
+    return;
+  }
+  auto pos = std::upper_bound(
+      best.begin(), best.end(), individual,
+      [](const Individual &a, const Individual &b) {
+        return a.score() > b.score();
+      });
+  best.insert(pos, individual);
+  if (best.size() > k) {
+    best.pop_back();
+  }
+}
+
+std::shared_ptr<SampleSpill> open_spill(const std::string &name) {
+  if (name.empty()) {
+    return nullptr;
+  }
+  auto spill = std::make_shared<SampleSpill>(name);
+  if (!spill->is_open()) {
+    std::cout << "failed to open [" << name << "] !" << std::endl;
+    return nullptr;
+  }
+  return spill;
+}
+
+bool close_spill(SampleSpill &spill, const std::string &name) {
+  if (!spill.close()) {
+    std::cout << "failed to write [" << name << "] !" << std::endl;
+    return false;
+  }
+  std::cout << "Save file [" << name << "] successful!" << std::endl;
+  return true;
+}
+
+} // namespace
+
+RandomWalk::RandomWalk(size_t pop_cnt, size_t walk_times, size_t thread_cnt)
+    : pop_cnt_(pop_cnt), walk_times_(walk_times), thread_cnt_(thread_cnt),
+      histogram_(kHistogramLo, kHistogramHi, kHistogramBins) {
+  init_pop(static_cast<unsigned>(
+      std::chrono::system_clock::now().time_since_epoch().count()));
+}
+
+RandomWalk::RandomWalk(size_t pop_cnt, size_t walk_times, size_t thread_cnt,
+                       unsigned seed)
+    : pop_cnt_(pop_cnt), walk_times_(walk_times), thread_cnt_(thread_cnt),
+      histogram_(kHistogramLo, kHistogramHi, kHistogramBins) {
+  init_pop(seed);
+}
+
+void RandomWalk::set_online(size_t best_k, const std::string &spill_name) {
+  online_ = true;
+  best_k_ = best_k;
+  spill_name_ = spill_name;
+}
+
+void RandomWalk::set_sampling(SamplingMethod method) {
+  sampled_ = true;
+  sampling_method_ = method;
 }
 
 void RandomWalk::do_random_walk() {
   std::cout << "Random walking..." << std::endl;
+  if (sampled_) {
+    do_sampled_walk();
+    return;
+  }
+  if (online_) {
+    do_online_walk();
+    return;
+  }
+  // 各个体互不相关, 每个个体作为一个任务交给线程池
+  ThreadPool pool(thread_cnt_);
+  std::vector<std::future<std::vector<double>>> fut_vec;
+  fut_vec.reserve(pop_.size());
   for (size_t t = 0; t != pop_.size(); ++t) {
-    rw_result_.emplace_back(pop_.at(t).random_walk(walk_times_));
+    fut_vec.push_back(pool.submit([this, t] {
+      return pop_.at(t).random_walk(walk_times_, engines_.at(t));
+    }));
+  }
+  rw_result_.clear();
+  rw_result_.reserve(pop_.size());
+  for (auto &fut : fut_vec) {
+    rw_result_.push_back(fut.get());
   }
+  pick_best_individual();
+}
 
+void RandomWalk::pick_best_individual() {
+  if (online_) {
+    best_individual_ =
+        best_individuals_.empty() ? pop_.front() : best_individuals_.front();
+    return;
+  }
   // 线性查找最优个体
   best_individual_ = pop_.front();
   for (size_t i = 1; i != pop_.size(); ++i) {
@@ -22,28 +133,194 @@ void RandomWalk::do_random_walk() {
   }
 }
 
-void RandomWalk::output_process_result(const std::string &s) const {
-  // output to file
-  std::ofstream rwf;
-  rwf.open(s, std::ios::out);
-  if (!rwf.is_open()) {
-    std::cout << "failed to open [" << s << "] !" << std::endl;
+void RandomWalk::reset_online() {
+  stats_ = RunningStats();
+  digest_ = TDigest();
+  histogram_ = Histogram(kHistogramLo, kHistogramHi, kHistogramBins);
+  best_individuals_.clear();
+}
+
+void RandomWalk::do_online_walk() {
+  std::shared_ptr<SampleSpill> spill = open_spill(spill_name_);
+  ThreadPool pool(thread_cnt_);
+  std::vector<std::future<WalkSummary>> fut_vec;
+  fut_vec.reserve(pop_.size());
+  for (size_t t = 0; t != pop_.size(); ++t) {
+    fut_vec.push_back(pool.submit([this, t, spill] {
+      WalkSummary sum{RunningStats(), TDigest(), histogram_, {}};
+      std::vector<double> block;
+      uint64_t first_index = 0;
+      auto on_sample = [&](const Individual &individual) {
+        double s = individual.score();
+        sum.stats.add(s);
+        sum.digest.add(s);
+        sum.histogram.add(s);
+        keep_best(sum.best, individual, best_k_);
+        if (spill) {
+          block.push_back(s);
+          if (block.size() == kSpillBlock) {
+            spill->append(static_cast<uint32_t>(t), first_index, block.data(),
+                          block.size());
+            first_index += block.size();
+            block.clear();
+          }
+        }
+      };
+      pop_.at(t).random_walk(walk_times_, engines_.at(t), on_sample);
+      if (spill && !block.empty()) {
+        spill->append(static_cast<uint32_t>(t), first_index, block.data(),
+                      block.size());
+      }
+      return sum;
+    }));
   }
-  for (size_t i = 0; i != rw_result_.size(); ++i) {
-    for (size_t j = 0; j != rw_result_.at(i).size(); ++j) {
-      if (j == rw_result_.at(i).size() - 1) {
-        rwf << std::to_string(rw_result_.at(i).at(j));
+  // 按个体顺序合并, 结果与线程调度无关
+  reset_online();
+  for (auto &fut : fut_vec) {
+    WalkSummary sum = fut.get();
+    stats_.merge(sum.stats);
+    digest_.merge(sum.digest);
+    histogram_.merge(sum.histogram);
+    for (const auto &individual : sum.best) {
+      keep_best(best_individuals_, individual, best_k_);
+    }
+  }
+  spill_written_ = spill && close_spill(*spill, spill_name_);
+  pick_best_individual();
+}
+
+// 每一步由低差异序列生成一批pop_cnt_个样本, 第i个样本视为第i个个体的这一步
+void RandomWalk::do_sampled_walk() {
+  if (pop_.empty()) {
+    return;
+  }
+  QuasiRandomSampler sampler(sampling_method_, TimetableConfig(),
+                             static_cast<unsigned>(engines_.front()()),
+                             thread_cnt_);
+  std::shared_ptr<SampleSpill> spill = online_ ? open_spill(spill_name_)
+                                               : nullptr;
+  reset_online();
+  rw_result_.assign(online_ ? 0 : pop_.size(), {});
+  // 第i个块缓存第i个个体的样本, 块内序号从first_index开始
+  std::vector<std::vector<double>> blocks(spill ? pop_.size() : 0);
+  uint64_t first_index = 0;
+  auto flush_blocks = [&] {
+    for (size_t i = 0; i != blocks.size(); ++i) {
+      spill->append(static_cast<uint32_t>(i), first_index, blocks[i].data(),
+                    blocks[i].size());
+      blocks[i].clear();
+    }
+  };
+  for (size_t t = 0; t != walk_times_; ++t) {
+    std::vector<Individual> batch = sampler.next_batch(pop_.size());
+    for (size_t i = 0; i != batch.size(); ++i) {
+      double s = batch[i].score();
+      if (spill) {
+        blocks[i].push_back(s);
+      }
+      if (online_) {
+        stats_.add(s);
+        digest_.add(s);
+        histogram_.add(s);
+        keep_best(best_individuals_, batch[i], best_k_);
       } else {
-        rwf << std::to_string(rw_result_.at(i).at(j)) << ",";
+        rw_result_[i].push_back(s);
       }
+      pop_[i] = std::move(batch[i]);
+    }
+    if (spill && blocks.front().size() == kSpillBlock) {
+      flush_blocks();
+      first_index += kSpillBlock;
     }
-    rwf << "\n";
   }
-  rwf.close();
+  if (spill && !blocks.front().empty()) {
+    flush_blocks();
+  }
+  spill_written_ = spill && close_spill(*spill, spill_name_);
+  pick_best_individual();
+}
+
+bool RandomWalk::output_process_result(const std::string &s) const {
+  if (online_) {
+    std::cout << "Samples of random walk are not kept in online mode, skip ["
+              << s << "]" << std::endl;
+    return false;
+  }
+  // output to file
+  CsvWriter rwf(s);
+  if (!rwf.is_open()) {
+    std::cout << "failed to open [" << s << "] !" << std::endl;
+    return false;
+  }
+  for (const auto &r : rw_result_) {
+    rwf.row(r);
+  }
+  if (!rwf.close()) {
+    std::cout << "failed to write [" << s << "] !" << std::endl;
+    return false;
+  }
+  return true;
 }
 
-void RandomWalk::output_plot_data(const std::string &s) const {
+bool RandomWalk::output_plot_data(const std::string &s) const {
   Timetable best_solution = Timetable(best_individual_.timetable_config());
-  best_solution.output_plot_data(s);
+  return best_solution.output_plot_data(s);
 }
-} // namespace yaohui
\ No newline at end of file
+
+bool RandomWalk::output_statistics(const std::string &s) const {
+  CsvWriter f(s);
+  if (!f.is_open()) {
+    std::cout << "failed to open [" << s << "] !" << std::endl;
+    return false;
+  }
+  f.field("statistic").field("value").end_row();
+  f.field("count").field(static_cast<int64_t>(stats_.count())).end_row();
+  f.field("mean").field(stats_.mean()).end_row();
+  f.field("stddev").field(stats_.stddev()).end_row();
+  f.field("min").field(stats_.min()).end_row();
+  f.field("max").field(stats_.max()).end_row();
+  for (int p : {1, 5, 25, 50, 75, 95, 99}) {
+    f.field("p" + std::to_string(p))
+        .field(digest_.quantile(p / 100.0))
+        .end_row();
+  }
+  f.field("underflow")
+      .field(static_cast<int64_t>(histogram_.underflow()))
+      .end_row();
+  f.field("overflow")
+      .field(static_cast<int64_t>(histogram_.overflow()))
+      .end_row();
+  if (!f.close()) {
+    std::cout << "failed to write [" << s << "] !" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool RandomWalk::output_histogram(const std::string &s) const {
+  CsvWriter f(s);
+  if (!f.is_open()) {
+    std::cout << "failed to open [" << s << "] !" << std::endl;
+    return false;
+  }
+  f.field("bin_begin").field("bin_end").field("count").end_row();
+  for (size_t i = 0; i != histogram_.bin_cnt(); ++i) {
+    f.field(histogram_.bin_begin(i))
+        .field(histogram_.bin_end(i))
+        .field(static_cast<int64_t>(histogram_.count(i)))
+        .end_row();
+  }
+  if (!f.close()) {
+    std::cout << "failed to write [" << s << "] !" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool RandomWalk::spill_written() const { return spill_written_; }
+
+const std::vector<Individual> &RandomWalk::best_individuals() const {
+  return best_individuals_;
+}
+
+} // namespace yaohui
@@ -0,0 +1,274 @@
+#include "Evaluator.hpp"
+#include "Individual.hpp"
+#include "RandomWalk.hpp"
+#include "Solver.hpp"
+#include "Timetable.hpp"
+#include "TimetableConfig.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace yaohui;
+
+namespace {
+
+// 所有用例使用固定种子和内置线路, 每次运行的输入相同
+const unsigned kSeed = 20230101;
+
+// 适应度与金标准值的相对误差上限. 同一编译器下结果应逐位相同,
+// 留出的余量只为容忍不同编译器对浮点求和的细微差别
+const double kFitnessTolerance = 1e-9;
+
+// 增量评价在多次移动后与完整评价的误差上限, 误差来自曲线的增量累加
+const double kDriftTolerance = 1e-9;
+
+// 参考负载: 对同一个运行图重复完整评价的次数
+const size_t kReferenceCalls = 50;
+
+// 参考负载和各用例的重复次数, CPU时间取其中最短的一次以减少噪声
+const size_t kTimingRepeats = 3;
+
+struct RegressionCase {
+  string name;         // 用例名
+  double golden;       // 金标准适应度
+  double budget_ratio; // CPU时间预算, 以参考负载的CPU时间为单位
+  function<double()> run;
+};
+
+double cpu_seconds() {
+  return static_cast<double>(clock()) / static_cast<double>(CLOCKS_PER_SEC);
+}
+
+bool same_fitness(double value, double golden) {
+  return fabs(value - golden) <= kFitnessTolerance * max(1.0, fabs(golden));
+}
+
+/**
+ * @brief 参考负载的CPU时间(秒)
+ *
+ * 在同一进程中对固定的运行图调用kReferenceCalls次
+ * Timetable::total_reuse_ratio, 取kTimingRepeats次中最短的一次. 各用例的
+ * 时间预算以它为单位, 因此与机器的快慢无关.
+ */
+double reference_seconds() {
+  default_random_engine e(kSeed + 2);
+  Individual individual(TimetableConfig(), e);
+  double best = 0.0;
+  for (size_t round = 0; round != kTimingRepeats; ++round) {
+    double beg = cpu_seconds();
+    double sum = 0.0;
+    for (size_t i = 0; i != kReferenceCalls; ++i) {
+      sum += Timetable(individual.timetable_config()).total_reuse_ratio();
+    }
+    double sec = cpu_seconds() - beg;
+    if (sum <= 0.0) {
+      printf("[WARN] reference workload returned %.17g\n", sum);
+    }
+    best = round == 0 ? sec : min(best, sec);
+  }
+  return best;
+}
+
+// 评价器: 随机个体上执行一串随机移动, 返回最终的复用率
+double evaluator_moves() {
+  default_random_engine e(kSeed);
+  Individual individual(TimetableConfig(), e);
+  Evaluator ev(individual.timetable_config());
+  double ratio = ev.ratio();
+  for (size_t i = 0; i != 20000; ++i) {
+    Evaluator::Move move;
+    if (ev.random_move(e, move)) {
+      ratio = ev.apply(move);
+    }
+  }
+  return ratio;
+}
+
+double ga_best() {
+  SolverOptions options;
+  options.gene_cnt = 3;
+  options.population_cnt = 20;
+  options.cross_p = 0.8;
+  options.mutate_p = 0.05;
+  options.alpha = 0.015;
+  options.thread_cnt = 2;
+  options.has_seed = true;
+  options.seed = kSeed;
+  Solver solver(options);
+  solver.do_optimization();
+  return solver.individual_after_optimize().score();
+}
+
+double random_walk_best() {
+  RandomWalk rw(10, 5, 2, kSeed);
+  rw.set_online(1);
+  rw.do_random_walk();
+  return rw.best_individuals().front().score();
+}
+
+/**
+ * @brief 核对Evaluator与参考实现Timetable::total_reuse_ratio
+ *
+ * 刚构造和resync之后两者应逐位相等; 多次增量移动之后误差不超过
+ * kDriftTolerance. 返回不一致的次数.
+ */
+size_t check_evaluator_equivalence() {
+  size_t failures = 0;
+  default_random_engine e(kSeed + 1);
+  for (size_t sample = 0; sample != 5; ++sample) {
+    Individual individual(TimetableConfig(), e);
+    Evaluator ev(individual.timetable_config());
+    double reference = Timetable(ev.config()).total_reuse_ratio();
+    if (ev.ratio() != reference) {
+      printf("[FAIL] sample %zu: Evaluator %.17g != Timetable %.17g\n", sample,
+             ev.ratio(), reference);
+      ++failures;
+    }
+    for (size_t round = 0; round != 3; ++round) {
+      for (size_t i = 0; i != 500; ++i) {
+        Evaluator::Move move;
+        if (ev.random_move(e, move)) {
+          ev.apply(move);
+        }
+      }
+      reference = Timetable(ev.config()).total_reuse_ratio();
+      if (fabs(ev.ratio() - reference) > kDriftTolerance) {
+        printf("[FAIL] sample %zu round %zu: incremental %.17g vs Timetable "
+               "%.17g\n",
+               sample, round, ev.ratio(), reference);
+        ++failures;
+      }
+      ev.resync();
+      if (ev.ratio() != reference) {
+        printf("[FAIL] sample %zu round %zu: resync %.17g != Timetable "
+               "%.17g\n",
+               sample, round, ev.ratio(), reference);
+        ++failures;
+      }
+    }
+  }
+  return failures;
+}
+
+void print_usage() {
+  printf("Usage: regression [--update] [--time-tolerance=<factor>] "
+         "[--skip-timing]\n");
+}
+
+// 解析--time-tolerance的取值, 须为有限的正数
+bool parse_tolerance(const string &text, double &value) {
+  const char *beg = text.c_str();
+  char *end = nullptr;
+  double v = strtod(beg, &end);
+  if (text.empty() || *end != '\0' || !std::isfinite(v) || v <= 0.0) {
+    return false;
+  }
+  value = v;
+  return true;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  bool update = false;         // 只输出当前值, 用于更新金标准
+  bool check_timing = true;    // 是否核对CPU时间预算
+  double time_tolerance = 1.0; // 预算的放宽倍数, 用于噪声较大的机器
+  for (int i = 1; i < argc; ++i) {
+    string arg = argv[i];
+    if (arg == "--update") {
+      update = true;
+    } else if (arg.compare(0, 17, "--time-tolerance=") == 0) {
+      if (!parse_tolerance(arg.substr(17), time_tolerance)) {
+        printf("Invalid value: %s\n", arg.c_str());
+        print_usage();
+        return 1;
+      }
+    } else if (arg == "--skip-timing") {
+      check_timing = false;
+    } else {
+      print_usage();
+      return 1;
+    }
+  }
+#ifndef NDEBUG
+  // 未优化的构建不核对时间预算
+  check_timing = false;
+#endif
+
+  // 金标准值由--update在Release构建下生成. 修改评价、选择、交叉或变异的
+  // 数值行为时需要重新生成; 仅改变速度的优化不应改变这些值.
+  // 时间预算约为--update输出的相对时间的1.3倍
+  vector<RegressionCase> cases = {
+      {"Evaluator/random_moves", 0.70743692456881191, 0.33, evaluator_moves},
+      {"Solver/ga_3x20", 0.73865312409516992, 3.2, ga_best},
+      {"RandomWalk/10x5", 0.73308722814755001, 1.55, random_walk_best},
+  };
+
+  double reference = reference_seconds();
+  printf("Reference workload: %zu Timetable evaluations, cpu %.3f s\n",
+         kReferenceCalls, reference);
+  if (reference <= 0.0) {
+    // clock()的精度不足, 无法换算相对时间
+    check_timing = false;
+  }
+
+  size_t failures = 0;
+  for (const auto &c : cases) {
+    double value = 0.0;
+    double sec = 0.0;
+    bool deterministic = true; // 各次运行的适应度是否相同
+    for (size_t round = 0; round != kTimingRepeats; ++round) {
+      double beg = cpu_seconds();
+      double v = c.run();
+      double round_sec = cpu_seconds() - beg;
+      if (round == 0) {
+        value = v;
+        sec = round_sec;
+      } else {
+        deterministic = deterministic && v == value;
+        sec = min(sec, round_sec);
+      }
+    }
+    double ratio = reference > 0.0 ? sec / reference : 0.0;
+    if (update) {
+      printf("%-24s golden %.17g cpu %.3f s (%.3f x reference)\n",
+             c.name.c_str(), value, sec, ratio);
+      continue;
+    }
+    bool fitness_ok = deterministic && same_fitness(value, c.golden);
+    bool timing_ok = !check_timing || ratio <= c.budget_ratio * time_tolerance;
+    printf("[%s] %-24s fitness %.17g (golden %.17g) cpu %.3f s = %.3f x "
+           "reference (budget %.3f x)\n",
+           fitness_ok && timing_ok ? "PASS" : "FAIL", c.name.c_str(), value,
+           c.golden, sec, ratio, c.budget_ratio);
+    if (!deterministic) {
+      printf("       %s returned different fitness on repeated runs\n",
+             c.name.c_str());
+    }
+    if (!fitness_ok || !timing_ok) {
+      ++failures;
+    }
+  }
+  if (update) {
+    return 0;
+  }
+
+  size_t mismatches = check_evaluator_equivalence();
+  printf("[%s] Evaluator/equals_timetable\n",
+         mismatches == 0 ? "PASS" : "FAIL");
+  failures += mismatches;
+
+  if (failures != 0) {
+    printf("%zu regression check(s) failed\n", failures);
+    return 1;
+  }
+  printf("All regression checks passed\n");
+  return 0;
+}
@@ -0,0 +1,155 @@
+#include "RunReport.hpp"
+#include "BufferedFile.hpp"
+#include "Individual.hpp"
+#include "JsonWriter.hpp"
+#include "LineModel.hpp"
+#include <cstdio>
+#include <iostream>
+#include <sys/resource.h>
+
+namespace yaohui {
+
+namespace {
+
+// 本进程所有线程的用户态与内核态CPU时间(秒)
+double process_cpu_seconds() {
+  rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0) {
+    return 0.0;
+  }
+  auto seconds = [](const timeval &tv) {
+    return static_cast<double>(tv.tv_sec) +
+           static_cast<double>(tv.tv_usec) * 1e-6;
+  };
+  return seconds(usage.ru_utime) + seconds(usage.ru_stime);
+}
+
+// 本进程的峰值常驻内存(字节)
+int64_t peak_rss_bytes() {
+  rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0) {
+    return 0;
+  }
+#ifdef __APPLE__
+  return static_cast<int64_t>(usage.ru_maxrss); // macOS上单位为字节
+#else
+  return static_cast<int64_t>(usage.ru_maxrss) * 1024; // Linux上单位为KB
+#endif
+}
+
+} // namespace
+
+RunReport::RunReport(size_t gene_cnt, size_t population_cnt, double cross_p,
+                     double mutate_p, double alpha, size_t thread_cnt,
+                     unsigned seed)
+    : gene_cnt_(gene_cnt), population_cnt_(population_cnt), cross_p_(cross_p),
+      mutate_p_(mutate_p), alpha_(alpha), thread_cnt_(thread_cnt),
+      seed_(seed) {}
+
+void RunReport::begin_engine(const std::string &name) {
+  running_ = name;
+  wall_beg_ = std::chrono::steady_clock::now();
+  cpu_beg_ = process_cpu_seconds();
+  eval_beg_ = Individual::evaluation_count();
+}
+
+double RunReport::end_engine() {
+  EngineRun run;
+  run.name = running_;
+  run.wall_seconds = std::chrono::duration<double>(
+                         std::chrono::steady_clock::now() - wall_beg_)
+                         .count();
+  run.cpu_seconds = process_cpu_seconds() - cpu_beg_;
+  run.evaluations = Individual::evaluation_count() - eval_beg_;
+  engines_.push_back(run);
+  running_.clear();
+  return run.wall_seconds;
+}
+
+void RunReport::set_reuse_ratio(double best, double default_ratio) {
+  best_reuse_ratio_ = best;
+  default_reuse_ratio_ = default_ratio;
+}
+
+void RunReport::clear_seed() { has_seed_ = false; }
+
+void RunReport::add_output(const std::string &f_name) {
+  outputs_.push_back(f_name);
+}
+
+bool RunReport::write_to_file(const std::string &json_name) const {
+  BufferedFile of(json_name);
+  if (!of.is_open()) {
+    std::cout << "Failed to open [" << json_name << "] !" << std::endl;
+    return false;
+  }
+  char hash[17];
+  std::snprintf(hash, sizeof(hash), "%016llx",
+                static_cast<unsigned long long>(LineModel::current()->hash()));
+  JsonWriter w(of);
+  w.begin_object();
+  w.key("parameters");
+  w.begin_object();
+  w.key("gene_cnt");
+  w.value(static_cast<int64_t>(gene_cnt_));
+  w.key("population_cnt");
+  w.value(static_cast<int64_t>(population_cnt_));
+  w.key("cross_p");
+  w.value(cross_p_);
+  w.key("mutate_p");
+  w.value(mutate_p_);
+  w.key("alpha");
+  w.value(alpha_);
+  w.key("thread_cnt");
+  w.value(static_cast<int64_t>(thread_cnt_));
+  w.end_object();
+  w.key("seed");
+  if (has_seed_) {
+    w.value(static_cast<int64_t>(seed_));
+  } else {
+    w.null();
+  }
+  w.key("line_model_hash");
+  w.value(std::string(hash));
+  w.key("engines");
+  w.begin_array();
+  for (const auto &e : engines_) {
+    w.begin_object();
+    w.key("name");
+    w.value(e.name);
+    w.key("wall_seconds");
+    w.value(e.wall_seconds);
+    w.key("cpu_seconds");
+    w.value(e.cpu_seconds);
+    w.key("evaluations");
+    w.value(static_cast<int64_t>(e.evaluations));
+    w.key("evaluations_per_second");
+    w.value(e.wall_seconds > 0.0
+                ? static_cast<double>(e.evaluations) / e.wall_seconds
+                : 0.0);
+    w.end_object();
+  }
+  w.end_array();
+  w.key("peak_rss_bytes");
+  w.value(peak_rss_bytes());
+  w.key("best_reuse_ratio");
+  w.value(best_reuse_ratio_);
+  w.key("default_reuse_ratio");
+  w.value(default_reuse_ratio_);
+  w.key("outputs");
+  w.begin_array();
+  for (const auto &f : outputs_) {
+    w.value(f);
+  }
+  w.end_array();
+  w.end_object();
+  of.put('\n');
+  if (!of.close()) {
+    std::cout << "Failed to write [" << json_name << "] !" << std::endl;
+    return false;
+  }
+  std::cout << "Save file [" << json_name << "] successful!" << std::endl;
+  return true;
+}
+
+} // namespace yaohui
@@ -0,0 +1,225 @@
+#include "SampleStats.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+namespace yaohui {
+
+void RunningStats::add(double x) {
+  if (count_ == 0) {
+    min_ = x;
+    max_ = x;
+  } else {
+    min_ = std::min(min_, x);
+    max_ = std::max(max_, x);
+  }
+  ++count_;
+  double delta = x - mean_;
+  mean_ += delta / static_cast<double>(count_);
+  m2_ += delta * (x - mean_);
+}
+
+void RunningStats::merge(const RunningStats &other) {
+  if (other.count_ == 0) {
+    return;
+  }
+  if (count_ == 0) {
+    *this = other;
+    return;
+  }
+  double n_a = static_cast<double>(count_);
+  double n_b = static_cast<double>(other.count_);
+  double n = n_a + n_b;
+  double delta = other.mean_ - mean_;
+  mean_ += delta * n_b / n;
+  m2_ += other.m2_ + delta * delta * n_a * n_b / n;
+  count_ += other.count_;
+  min_ = std::min(min_, other.min_);
+  max_ = std::max(max_, other.max_);
+}
+
+uint64_t RunningStats::count() const { return count_; }
+double RunningStats::mean() const { return mean_; }
+double RunningStats::variance() const {
+  return count_ < 2 ? 0.0 : m2_ / static_cast<double>(count_ - 1);
+}
+double RunningStats::stddev() const { return std::sqrt(variance()); }
+double RunningStats::min() const { return min_; }
+double RunningStats::max() const { return max_; }
+
+TDigest::TDigest(double compression) : compression_(compression) {
+  buffer_.reserve(static_cast<size_t>(compression_) * 8);
+}
+
+void TDigest::add(double x, double weight) {
+  if (total_weight_ == 0.0 && buffer_.empty()) {
+    min_ = x;
+    max_ = x;
+  } else {
+    min_ = std::min(min_, x);
+    max_ = std::max(max_, x);
+  }
+  buffer_.push_back({x, weight});
+  if (buffer_.size() >= static_cast<size_t>(compression_) * 8) {
+    compress();
+  }
+}
+
+void TDigest::merge(const TDigest &other) {
+  if (other.total_weight_ == 0.0 && other.buffer_.empty()) {
+    return;
+  }
+  bool empty = total_weight_ == 0.0 && buffer_.empty();
+  min_ = empty ? other.min_ : std::min(min_, other.min_);
+  max_ = empty ? other.max_ : std::max(max_, other.max_);
+  buffer_.insert(buffer_.end(), other.centroids_.begin(),
+                 other.centroids_.end());
+  buffer_.insert(buffer_.end(), other.buffer_.begin(), other.buffer_.end());
+  compress();
+}
+
+void TDigest::compress() {
+  if (buffer_.empty()) {
+    return;
+  }
+  std::vector<Centroid> all;
+  all.reserve(centroids_.size() + buffer_.size());
+  all.insert(all.end(), centroids_.begin(), centroids_.end());
+  all.insert(all.end(), buffer_.begin(), buffer_.end());
+  buffer_.clear();
+  std::sort(all.begin(), all.end(), [](const Centroid &a, const Centroid &b) {
+    return a.mean < b.mean;
+  });
+  double total = 0.0;
+  for (const auto &c : all) {
+    total += c.weight;
+  }
+  // k1尺度函数, 相邻质心的k值之差不超过1
+  const double pi = 3.14159265358979323846;
+  auto k = [this, pi](double q) {
+    return compression_ / (2.0 * pi) * std::asin(2.0 * q - 1.0);
+  };
+  centroids_.clear();
+  Centroid cur = all.front();
+  double weight_so_far = 0.0;
+  for (size_t i = 1; i != all.size(); ++i) {
+    const Centroid &x = all[i];
+    double q0 = weight_so_far / total;
+    double q2 = std::min(1.0, (weight_so_far + cur.weight + x.weight) / total);
+    if (k(q2) - k(q0) <= 1.0) {
+      cur.weight += x.weight;
+      cur.mean += (x.mean - cur.mean) * x.weight / cur.weight;
+    } else {
+      weight_so_far += cur.weight;
+      centroids_.push_back(cur);
+      cur = x;
+    }
+  }
+  centroids_.push_back(cur);
+  total_weight_ = total;
+}
+
+double TDigest::quantile(double q) const {
+  if (!buffer_.empty()) {
+    TDigest merged = *this;
+    merged.compress();
+    return merged.quantile(q);
+  }
+  if (centroids_.empty()) {
+    return std::numeric_limits<double>::quiet_NaN();
+  }
+  q = std::min(1.0, std::max(0.0, q));
+  if (centroids_.size() == 1) {
+    return centroids_.front().mean;
+  }
+  // 在相邻质心的中心之间线性插值, 两端向min/max插值
+  double index = q * total_weight_;
+  const Centroid &first = centroids_.front();
+  if (index < first.weight / 2.0) {
+    return min_ + (first.mean - min_) * index / (first.weight / 2.0);
+  }
+  double cum = first.weight / 2.0;
+  for (size_t i = 0; i + 1 < centroids_.size(); ++i) {
+    double dw = (centroids_[i].weight + centroids_[i + 1].weight) / 2.0;
+    if (cum + dw > index) {
+      double t = (index - cum) / dw;
+      return centroids_[i].mean +
+             t * (centroids_[i + 1].mean - centroids_[i].mean);
+    }
+    cum += dw;
+  }
+  const Centroid &last = centroids_.back();
+  double z = std::min(index - cum, last.weight / 2.0);
+  return last.mean + (max_ - last.mean) * z / (last.weight / 2.0);
+}
+
+size_t TDigest::centroid_cnt() const {
+  return centroids_.size() + buffer_.size();
+}
+
+Histogram::Histogram(double lo, double hi, size_t bin_cnt)
+    : lo_(lo), hi_(hi), counts_(bin_cnt, 0) {
+  assert(lo < hi && bin_cnt > 0);
+}
+
+void Histogram::add(double x) {
+  if (x < lo_) {
+    ++underflow_;
+  } else if (x >= hi_) {
+    ++overflow_;
+  } else {
+    size_t i = static_cast<size_t>((x - lo_) / (hi_ - lo_) *
+                                   static_cast<double>(counts_.size()));
+    ++counts_[std::min(i, counts_.size() - 1)];
+  }
+}
+
+void Histogram::merge(const Histogram &other) {
+  assert(lo_ == other.lo_ && hi_ == other.hi_ &&
+         counts_.size() == other.counts_.size());
+  for (size_t i = 0; i != counts_.size(); ++i) {
+    counts_[i] += other.counts_[i];
+  }
+  underflow_ += other.underflow_;
+  overflow_ += other.overflow_;
+}
+
+size_t Histogram::bin_cnt() const { return counts_.size(); }
+double Histogram::bin_begin(size_t i) const {
+  return lo_ + (hi_ - lo_) * static_cast<double>(i) /
+                   static_cast<double>(counts_.size());
+}
+double Histogram::bin_end(size_t i) const { return bin_begin(i + 1); }
+uint64_t Histogram::count(size_t i) const { return counts_.at(i); }
+uint64_t Histogram::underflow() const { return underflow_; }
+uint64_t Histogram::overflow() const { return overflow_; }
+
+SampleSpill::SampleSpill(const std::string &f_name) : file_(f_name) {
+  if (file_.is_open()) {
+    const char magic[8] = {'Y', 'H', 'S', 'A', 'M', 'P', 'L', 'E'};
+    const uint32_t version_reserved[2] = {1, 0};
+    file_.write(magic, sizeof(magic));
+    file_.write(reinterpret_cast<const char *>(version_reserved),
+                sizeof(version_reserved));
+  }
+}
+
+bool SampleSpill::is_open() const { return file_.is_open(); }
+
+void SampleSpill::append(uint32_t source, uint64_t first_index,
+                         const double *values, size_t cnt) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  const uint32_t head[2] = {source, static_cast<uint32_t>(cnt)};
+  file_.write(reinterpret_cast<const char *>(head), sizeof(head));
+  file_.write(reinterpret_cast<const char *>(&first_index),
+              sizeof(first_index));
+  file_.write(reinterpret_cast<const char *>(values), sizeof(double) * cnt);
+}
+
+bool SampleSpill::close() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return file_.close();
+}
+
+} // namespace yaohui
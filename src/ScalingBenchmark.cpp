@@ -0,0 +1,163 @@
+#include "ScalingBenchmark.hpp"
+#include "BufferedFile.hpp"
+#include "Individual.hpp"
+#include "JsonWriter.hpp"
+#include "RandomWalk.hpp"
+#include "Solver.hpp"
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+
+namespace yaohui {
+
+ScalingBenchmark::ScalingBenchmark(size_t gene_cnt, size_t population_cnt,
+                                   double cross_p, double mutate_p,
+                                   double alpha, size_t walk_times,
+                                   unsigned seed)
+    : gene_cnt_(gene_cnt), population_cnt_(population_cnt), cross_p_(cross_p),
+      mutate_p_(mutate_p), alpha_(alpha), walk_times_(walk_times),
+      seed_(seed) {}
+
+void ScalingBenchmark::run(size_t max_threads) {
+  points_.clear();
+  for (size_t n = 1; n <= max_threads; ++n) {
+    std::cout << "Benchmarking with " << n << " threads..." << std::endl;
+    ScalingPoint p;
+    p.thread_cnt = n;
+
+    // 只计进化过程, 初始种群的生成与线程数无关
+    SolverOptions options;
+    options.gene_cnt = gene_cnt_;
+    options.population_cnt = population_cnt_;
+    options.cross_p = cross_p_;
+    options.mutate_p = mutate_p_;
+    options.alpha = alpha_;
+    options.thread_cnt = n;
+    options.verbose = false; // 每代的日志输出不计入计时
+    options.has_seed = true;
+    options.seed = seed_;
+    Solver solver(options);
+    uint64_t eval_beg = Individual::evaluation_count();
+    auto beg = std::chrono::steady_clock::now();
+    solver.do_optimization();
+    p.ga_seconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - beg)
+            .count();
+    p.ga_evaluations = Individual::evaluation_count() - eval_beg;
+    p.best_fitness = solver.individual_after_optimize().score();
+
+    RandomWalk rw(population_cnt_, walk_times_, n, seed_);
+    eval_beg = Individual::evaluation_count();
+    beg = std::chrono::steady_clock::now();
+    rw.do_random_walk();
+    p.walk_seconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - beg)
+            .count();
+    p.walk_evaluations = Individual::evaluation_count() - eval_beg;
+
+    p.ga_evals_per_second =
+        p.ga_seconds > 0.0
+            ? static_cast<double>(p.ga_evaluations) / p.ga_seconds
+            : 0.0;
+    p.walk_evals_per_second =
+        p.walk_seconds > 0.0
+            ? static_cast<double>(p.walk_evaluations) / p.walk_seconds
+            : 0.0;
+    // 以单线程的吞吐率为基准
+    const ScalingPoint &base = points_.empty() ? p : points_.front();
+    if (base.ga_evals_per_second > 0.0) {
+      p.ga_speedup = p.ga_evals_per_second / base.ga_evals_per_second;
+      p.ga_efficiency = p.ga_speedup / static_cast<double>(n);
+    }
+    if (base.walk_evals_per_second > 0.0) {
+      p.walk_speedup = p.walk_evals_per_second / base.walk_evals_per_second;
+      p.walk_efficiency = p.walk_speedup / static_cast<double>(n);
+    }
+    points_.push_back(p);
+  }
+}
+
+void ScalingBenchmark::print_summary() const {
+  std::printf("%8s %14s %12s %10s %10s %12s %10s %10s\n", "threads",
+              "s/generation", "GA evals/s", "speedup", "efficiency",
+              "walk evals/s", "speedup", "efficiency");
+  for (const auto &p : points_) {
+    std::printf("%8zu %14.4f %12.1f %10.3f %10.3f %12.1f %10.3f %10.3f\n",
+                p.thread_cnt,
+                gene_cnt_ == 0 ? 0.0
+                               : p.ga_seconds / static_cast<double>(gene_cnt_),
+                p.ga_evals_per_second, p.ga_speedup, p.ga_efficiency,
+                p.walk_evals_per_second, p.walk_speedup, p.walk_efficiency);
+  }
+  std::fflush(stdout);
+}
+
+bool ScalingBenchmark::write_to_file(const std::string &json_name) const {
+  BufferedFile of(json_name);
+  if (!of.is_open()) {
+    std::cout << "Failed to open [" << json_name << "] !" << std::endl;
+    return false;
+  }
+  JsonWriter w(of);
+  w.begin_object();
+  w.key("parameters");
+  w.begin_object();
+  w.key("gene_cnt");
+  w.value(static_cast<int64_t>(gene_cnt_));
+  w.key("population_cnt");
+  w.value(static_cast<int64_t>(population_cnt_));
+  w.key("cross_p");
+  w.value(cross_p_);
+  w.key("mutate_p");
+  w.value(mutate_p_);
+  w.key("alpha");
+  w.value(alpha_);
+  w.key("walk_times");
+  w.value(static_cast<int64_t>(walk_times_));
+  w.key("seed");
+  w.value(static_cast<int64_t>(seed_));
+  w.end_object();
+  w.key("results");
+  w.begin_array();
+  for (const auto &p : points_) {
+    w.begin_object();
+    w.key("thread_cnt");
+    w.value(static_cast<int64_t>(p.thread_cnt));
+    w.key("ga_seconds");
+    w.value(p.ga_seconds);
+    w.key("ga_seconds_per_generation");
+    w.value(gene_cnt_ == 0 ? 0.0
+                           : p.ga_seconds / static_cast<double>(gene_cnt_));
+    w.key("ga_evaluations");
+    w.value(static_cast<int64_t>(p.ga_evaluations));
+    w.key("ga_evals_per_second");
+    w.value(p.ga_evals_per_second);
+    w.key("ga_speedup");
+    w.value(p.ga_speedup);
+    w.key("ga_parallel_efficiency");
+    w.value(p.ga_efficiency);
+    w.key("best_fitness");
+    w.value(p.best_fitness);
+    w.key("walk_seconds");
+    w.value(p.walk_seconds);
+    w.key("walk_evaluations");
+    w.value(static_cast<int64_t>(p.walk_evaluations));
+    w.key("walk_evals_per_second");
+    w.value(p.walk_evals_per_second);
+    w.key("walk_speedup");
+    w.value(p.walk_speedup);
+    w.key("walk_parallel_efficiency");
+    w.value(p.walk_efficiency);
+    w.end_object();
+  }
+  w.end_array();
+  w.end_object();
+  if (!of.close()) {
+    std::cout << "Failed to write [" << json_name << "] !" << std::endl;
+    return false;
+  }
+  std::cout << "Save file [" << json_name << "] successful!" << std::endl;
+  return true;
+}
+
+} // namespace yaohui
@@ -0,0 +1,142 @@
+#include "SimulatedAnnealing.hpp"
+#include "CsvWriter.hpp"
+#include "MetropolisChain.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+namespace yaohui {
+
+bool parse_cooling_schedule(const std::string &name,
+                            CoolingSchedule &schedule) {
+  if (name == "geometric") {
+    schedule = CoolingSchedule::kGeometric;
+    return true;
+  }
+  if (name == "linear") {
+    schedule = CoolingSchedule::kLinear;
+    return true;
+  }
+  return false;
+}
+
+SimulatedAnnealing::SimulatedAnnealing(size_t steps, size_t restarts,
+                                       double t_begin, double t_end,
+                                       CoolingSchedule schedule)
+    : SimulatedAnnealing(steps, restarts, t_begin, t_end, schedule,
+                         TimetableConfig()) {}
+
+SimulatedAnnealing::SimulatedAnnealing(size_t steps, size_t restarts,
+                                       double t_begin, double t_end,
+                                       CoolingSchedule schedule,
+                                       const TimetableConfig &start_config)
+    : SimulatedAnnealing(
+          steps, restarts, t_begin, t_end, schedule, start_config,
+          static_cast<unsigned>(
+              std::chrono::system_clock::now().time_since_epoch().count())) {}
+
+SimulatedAnnealing::SimulatedAnnealing(size_t steps, size_t restarts,
+                                       double t_begin, double t_end,
+                                       CoolingSchedule schedule,
+                                       const TimetableConfig &start_config,
+                                       unsigned seed)
+    : steps_(steps), restarts_(restarts), t_begin_(t_begin), t_end_(t_end),
+      schedule_(schedule), rng_(seed),
+      first_individual_(Individual::from_config(start_config)),
+      best_individual_(first_individual_) {}
+
+const Individual &SimulatedAnnealing::individual_before_optimize() const {
+  return first_individual_;
+}
+
+const Individual &SimulatedAnnealing::individual_after_optimize() const {
+  return best_individual_;
+}
+
+double SimulatedAnnealing::temperature(size_t step) const {
+  if (steps_ < 2) {
+    return t_begin_;
+  }
+  double x = static_cast<double>(step) / static_cast<double>(steps_ - 1);
+  if (schedule_ == CoolingSchedule::kLinear) {
+    return t_begin_ + (t_end_ - t_begin_) * x;
+  }
+  return t_begin_ * std::pow(t_end_ / t_begin_, x);
+}
+
+void SimulatedAnnealing::do_optimization() {
+  std::cout << "Annealing..." << std::endl;
+  Evaluator ev(first_individual_.timetable_config());
+  MetropolisChain chain(&ev, resync_every_);
+  size_t record_every = std::max<size_t>(1, steps_ / record_cnt_);
+  records_.clear();
+
+  for (size_t run = 0; run != restarts_; ++run) {
+    if (run != 0) {
+      chain.save_best();
+      ev.set_genome(chain.best_genome());
+      chain.reset(&ev);
+    }
+    size_t accepted = 0; // 上次记录以来接受的移动数
+    size_t tried = 0;    // 上次记录以来的步数
+    for (size_t step = 0; step != steps_; ++step) {
+      double T = temperature(step);
+      ++tried;
+      if (chain.step(rng_, T)) {
+        ++accepted;
+      }
+      if ((step + 1) % record_every == 0 || step + 1 == steps_) {
+        records_.push_back({run, step + 1, T, chain.current(), chain.best(),
+                            static_cast<double>(accepted) /
+                                static_cast<double>(tried)});
+        accepted = 0;
+        tried = 0;
+      }
+    }
+    std::cout << "Annealing run: " << run << "\tCurrent: " << chain.current()
+              << "\tBest: " << chain.best() << std::endl;
+  }
+
+  // 最好解以Timetable重新评分, 消除增量评价的累计误差
+  chain.save_best();
+  ev.set_genome(chain.best_genome());
+  best_individual_ = Individual::from_config(ev.config());
+  if (best_individual_.score() < first_individual_.score()) {
+    best_individual_ = first_individual_;
+  }
+  std::cout << "optimization finished!" << std::endl;
+}
+
+bool SimulatedAnnealing::output_optimization_result(
+    const std::string &f_name) const {
+  CsvWriter output(f_name);
+  if (!output.is_open()) {
+    std::cout << "Failed to open [" << f_name << "] !" << std::endl;
+    return false;
+  }
+  output.field("run")
+      .field("step")
+      .field("temperature")
+      .field("current_fitness")
+      .field("best_fitness")
+      .field("accept_rate")
+      .end_row();
+  for (const Record &r : records_) {
+    output.field(static_cast<int64_t>(r.run))
+        .field(static_cast<int64_t>(r.step))
+        .field(r.temperature)
+        .field(r.current)
+        .field(r.best)
+        .field(r.accepted)
+        .end_row();
+  }
+  if (!output.close()) {
+    std::cout << "Failed to write [" << f_name << "] !" << std::endl;
+    return false;
+  }
+  std::cout << "Save file [" << f_name << "] successful!" << std::endl;
+  return true;
+}
+
+} // namespace yaohui
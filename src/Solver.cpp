@@ -1,21 +1,119 @@
 #include "Solver.hpp"
+#include "BufferedFile.hpp"
+#include "CsvWriter.hpp"
+#include "Evaluator.hpp"
+#include "PhaseTimer.hpp"
+#include "SolverCheckpoint.hpp"
+#include "ThreadPool.hpp"
+#include "Tracer.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
 
 namespace yaohui {
 
-Solver::Solver(size_t gene_cnt, size_t population_cnt, double cross_p,
-               double mutate_p, double alpha, size_t thread_cnt)
-    : gene_cnt_(gene_cnt), population_cnt_(population_cnt), cross_p_(cross_p),
-      mutate_p_(mutate_p), alpha_(alpha), thread_cnt_(thread_cnt) {
-  init_weights();    // 初始化权重vec
-  init_population(); // 生成初始种群并按适应度由大到小排列
+namespace {
+
+// 未指定种子时取时钟
+unsigned clock_seed() {
+  return static_cast<unsigned>(
+      std::chrono::system_clock::now().time_since_epoch().count());
+}
+
+} // namespace
+
+Solver::Solver(const SolverOptions &options)
+    : gene_cnt_(options.gene_cnt), population_cnt_(options.population_cnt),
+      cross_p_(options.cross_p), mutate_p_(options.mutate_p),
+      alpha_(options.alpha), thread_cnt_(options.thread_cnt),
+      verbose_(options.verbose),
+      rng_(options.has_seed ? options.seed : clock_seed()) {
+  init_weights(); // 初始化权重vec
+  // 生成初始种群并按适应度由大到小排列
+  if (options.warm_start != nullptr) {
+    init_population(*options.warm_start); // 种子个体及其邻域
+  } else if (options.sampled_init) {
+    init_population(options.init_method); // 低差异序列初始种群
+  } else {
+    init_population();
+  }
+  record_first_generation();
+}
+
+Solver::Solver(const std::string &checkpoint_name, size_t thread_cnt)
+    : thread_cnt_(thread_cnt) {
+  std::ifstream in(checkpoint_name, std::ios::binary);
+  if (!in.is_open()) {
+    throw std::runtime_error("Failed to open [" + checkpoint_name + "] !");
+  }
+  std::vector<char> data((std::istreambuf_iterator<char>(in)),
+                         std::istreambuf_iterator<char>());
+  try {
+    restore_checkpoint(data);
+  } catch (const std::runtime_error &e) {
+    throw std::runtime_error("Failed to resume from [" + checkpoint_name +
+                             "] : " + e.what());
+  }
+  init_weights();
+  std::cout << "Resume from [" << checkpoint_name << "] at generation "
+            << generation_ << std::endl;
+}
+
+void Solver::record_first_generation() {
   first_best_individual_ = population_.front();
   last_best_individual_ = population_.front();
 
   // 把第一代适应度添加到fitness_vec
-  fitness_vec_.emplace_back(std::vector<double>(population_.size(), 0.0));
+  record_generation_fitness(0);
+}
+
+void Solver::record_generation_fitness(size_t generation) {
+  std::vector<double> fitness(population_.size(), 0.0);
   for (size_t i = 0; i != population_.size(); ++i) {
-    fitness_vec_.back().at(i) = population_.at(i).score();
+    fitness.at(i) = population_.at(i).score();
+  }
+  if (fitness_log_) {
+    fitness_log_->append(generation, std::move(fitness));
+  } else {
+    fitness_vec_.push_back(std::move(fitness));
+  }
+}
+
+bool Solver::set_fitness_log(const std::string &f_name) {
+  if (fitness_vec_.empty() && generation_ != 0) {
+    // 检查点由启用了流式日志的运行写出, 不含已完成各代的适应度,
+    // 续写原有的日志
+    fitness_log_.reset(new FitnessLog(f_name, population_cnt_, generation_));
+  } else {
+    fitness_log_.reset(new FitnessLog(f_name, population_cnt_));
+  }
+  if (!fitness_log_->is_open()) {
+    std::cout << "Failed to open [" << f_name << "] !" << std::endl;
+    fitness_log_.reset();
+    return false;
   }
+  fitness_log_name_ = f_name;
+  // 已经保存在内存中的代转入日志
+  for (size_t i = 0; i != fitness_vec_.size(); ++i) {
+    fitness_log_->append(i, std::move(fitness_vec_[i]));
+  }
+  fitness_vec_.clear();
+  fitness_vec_.shrink_to_fit();
+  return true;
+}
+
+void Solver::set_checkpoint(const std::string &f_name, size_t every) {
+  checkpoint_name_ = f_name;
+  checkpoint_every_ = every;
+}
+
+bool Solver::checkpoint_written() const { return checkpoint_written_; }
+
+void Solver::set_local_search(size_t k, size_t budget) {
+  local_search_k_ = k;
+  local_search_budget_ = budget;
 }
 
 const Individual &Solver::individual_before_optimize() const {
@@ -37,93 +135,263 @@ void Solver::init_weights() {
 }
 
 void Solver::do_optimization() {
-  std::cout << "The number of missions: "
-            << population_.front().timetable_config().missions_cnt()
-            << std::endl;
-  std::cout << "The number of down direction missions: "
-            << population_.front().timetable_config().down_missions_cnt()
-            << std::endl;
-  std::cout << "The number of up direction missions: "
-            << population_.front().timetable_config().up_missions_cnt()
-            << std::endl;
+  if (verbose_) {
+    const TimetableConfig &config = population_.front().timetable_config();
+    std::cout << "The number of missions: " << config.missions_cnt()
+              << std::endl;
+    std::cout << "The number of down direction missions: "
+              << config.down_missions_cnt() << std::endl;
+    std::cout << "The number of up direction missions: "
+              << config.up_missions_cnt() << std::endl;
+  }
   {
-    for (size_t loop_times = 0; loop_times != gene_cnt_; ++loop_times) {
+    ScopedPhase::collect(); // 丢弃初始种群等之前的计数
+    while (generation_ < gene_cnt_) {
+      auto generation_beg = std::chrono::steady_clock::now();
+      TraceScope trace("generation", "generation",
+                       static_cast<int64_t>(generation_));
+      size_t loop_times = generation_;
       // 按照适应度选择个体并进行交叉生成子代
-      population_ = birth_multi_threading();
+      std::vector<Individual> children;
+      {
+        YAOHUI_PHASE_SCOPE(Phase::kBirth);
+        children = birth_multi_threading();
+      }
+      // 后台检查点仍在读取上一代种群时等待
+      if (population_released_.valid()) {
+        population_released_.get();
+      }
+      population_ = std::move(children);
       // 变异
       for (auto &item : population_) {
         child_mutate(item);
       }
       // 排序
-      std::sort(population_.begin(), population_.end(), is_better);
-      max_fitness_vec_.push_back(population_.front().score());
-      min_fitness_vec_.push_back(population_.back().score());
-      // 保存平均值
-      double avg_fitness = 0.0; // 输出当前代的平均适应度
-      for (const auto &individual : population_) {
-        avg_fitness += individual.score();
+      {
+        YAOHUI_PHASE_SCOPE(Phase::kSort);
+        std::sort(population_.begin(), population_.end(), is_better);
+      }
+      // 局部搜索
+      if (local_search_k_ != 0) {
+        local_search();
       }
-      avg_fitness = avg_fitness / static_cast<double>(population_.size());
-      avg_fitness_vec_.push_back(avg_fitness);
+      {
+        YAOHUI_PHASE_SCOPE(Phase::kStatistics);
+        max_fitness_vec_.push_back(population_.front().score());
+        min_fitness_vec_.push_back(population_.back().score());
+        // 保存平均值
+        double avg_fitness = 0.0; // 输出当前代的平均适应度
+        for (const auto &individual : population_) {
+          avg_fitness += individual.score();
+        }
+        avg_fitness = avg_fitness / static_cast<double>(population_.size());
+        avg_fitness_vec_.push_back(avg_fitness);
 
-      // 保存最优解
-      last_best_individual_ = population_.front();
+        // 保存最优解
+        last_best_individual_ = population_.front();
 
-      fitness_vec_.emplace_back(std::vector<double>(population_.size(), 0.0));
-      for (size_t i = 0; i != population_.size(); ++i) {
-        fitness_vec_.back().at(i) = population_.at(i).score();
+        ++generation_;
+        record_generation_fitness(generation_);
       }
       // 输出
-      std::cout << "Iteration number: " << loop_times
-                << "\tBest: " << max_fitness_vec_.back()
-                << "\tWorst: " << min_fitness_vec_.back()
-                << "\tAverage: " << avg_fitness_vec_.back() << std::endl;
+      if (verbose_) {
+        YAOHUI_PHASE_SCOPE(Phase::kLogging);
+        std::cout << "Iteration number: " << loop_times
+                  << "\tBest: " << max_fitness_vec_.back()
+                  << "\tWorst: " << min_fitness_vec_.back()
+                  << "\tAverage: " << avg_fitness_vec_.back() << std::endl;
+      }
+      // 检查点
+      if (checkpoint_every_ != 0 && (generation_ % checkpoint_every_ == 0 ||
+                                     generation_ == gene_cnt_)) {
+        save_checkpoint();
+      }
+      // 本代各阶段的计时
+      generation_seconds_.push_back(
+          std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                        generation_beg)
+              .count());
+      phase_totals_.push_back(ScopedPhase::collect());
+    }
+    if (pending_checkpoint_.valid()) {
+      checkpoint_written_ = pending_checkpoint_.get();
+      if (checkpoint_written_) {
+        std::cout << "Save file [" << checkpoint_name_ << "] successful!"
+                  << std::endl;
+      } else {
+        std::cout << "Failed to write [" << checkpoint_name_ << "] !"
+                  << std::endl;
+      }
     }
 
-    std::cout << "optimization finished!" << std::endl;
+    if (verbose_) {
+      std::cout << "optimization finished!" << std::endl;
+    }
   }
 }
 
-void Solver::output_optimization_result(std::string f_name) {
-  std::vector<std::string> lines = {
-      "generation,best_fitness,worst_fitness,avg_fitness\n"};
-  for (size_t i = 0; i != gene_cnt_; ++i) {
-    lines.push_back(std::to_string(i + 1) + "," +
-                    std::to_string(max_fitness_vec_.at(i)) + "," +
-                    std::to_string(min_fitness_vec_.at(i)) + "," +
-                    std::to_string(avg_fitness_vec_.at(i)) + "\n");
-  }
-
+bool Solver::output_optimization_result(std::string f_name) {
   // 进化过程画图用迭代数据写入文件(只有最好的个体的版本)
-  std::ofstream plot_data_output;
+  bool ok = true; // 两个文件均写入成功
   std::string old_s = "only-best-" + f_name;
-  plot_data_output.open(old_s, std::ios::out);
+  CsvWriter plot_data_output(old_s);
   if (!plot_data_output.is_open()) {
     std::cout << "Failed to open [" << old_s << "] !" << std::endl;
+    ok = false;
+  } else {
+    plot_data_output.field("generation")
+        .field("best_fitness")
+        .field("worst_fitness")
+        .field("avg_fitness")
+        .end_row();
+    for (size_t i = 0; i != max_fitness_vec_.size(); ++i) {
+      plot_data_output.field(static_cast<int64_t>(i + 1))
+          .field(max_fitness_vec_.at(i))
+          .field(min_fitness_vec_.at(i))
+          .field(avg_fitness_vec_.at(i))
+          .end_row();
+    }
+    if (plot_data_output.close()) {
+      std::cout << "Save file [" << old_s << "] successful!" << std::endl;
+    } else {
+      std::cout << "Failed to write [" << old_s << "] !" << std::endl;
+      ok = false;
+    }
   }
-  for (const auto &line : lines) {
-    plot_data_output << line;
-  }
-  plot_data_output.close();
-  std::cout << "Save file [" << old_s << "] successful!" << std::endl;
 
   // 进化过程画图用迭代数据写入文件(完整版本)
-  std::ofstream iter_data;
-  iter_data.open(f_name, std::ios::out);
+  if (fitness_log_) {
+    // 关闭日志, 等待写线程写完剩余的代
+    if (!fitness_log_->close()) {
+      std::cout << "Failed to write [" << fitness_log_name_ << "] !"
+                << std::endl;
+      return false;
+    }
+    std::cout << "Fitness of every generation is in [" << fitness_log_name_
+              << "]" << std::endl;
+    return ok;
+  }
+  CsvWriter iter_data(f_name);
   if (!iter_data.is_open()) {
     std::cout << "Failed to open [" << f_name << "] !" << std::endl;
+    return false;
   }
   for (const auto &r : fitness_vec_) {
-    for (size_t j = 0; j != r.size(); ++j) {
-      iter_data << std::to_string(r.at(j));
-      if (j != r.size() - 1) {
-        iter_data << ",";
+    iter_data.row(r);
+  }
+  if (!iter_data.close()) {
+    std::cout << "Failed to write [" << f_name << "] !" << std::endl;
+    return false;
+  }
+  std::cout << "Save file [" << f_name << "] successful!" << std::endl;
+  return ok;
+}
+
+bool Solver::output_phase_profile(const std::string &f_name) const {
+  CsvWriter output(f_name);
+  if (!output.is_open()) {
+    std::cout << "Failed to open [" << f_name << "] !" << std::endl;
+    return false;
+  }
+  const bool allocs = ScopedPhase::allocation_tracking();
+  const bool perf = ScopedPhase::perf_counters_enabled();
+  // 有时段完全没有计数时硬件计数不可用, 见print_perf_summary
+  const bool perf_unmeasured = ScopedPhase::perf_counts_unmeasured();
+  output.field("generation").field("wall_seconds");
+  for (size_t i = 0; i != kPhaseCnt; ++i) {
+    output.field(std::string(phase_name(static_cast<Phase>(i))) + "_seconds");
+  }
+  output.field("evaluations");
+  if (allocs) {
+    // 各阶段的分配次数和字节数, 最后一项为不在任何阶段内的分配
+    for (size_t i = 0; i != kPhaseCnt + 1; ++i) {
+      std::string name = phase_name(static_cast<Phase>(i));
+      output.field(name + "_allocs").field(name + "_bytes");
+    }
+    output.field("allocs")
+        .field("bytes")
+        .field("allocs_per_evaluation")
+        .field("bytes_per_evaluation");
+  }
+  if (perf) {
+    for (size_t i = 0; i != kPhaseCnt; ++i) {
+      for (size_t j = 0; j != kPerfEventCnt; ++j) {
+        output.field(std::string(phase_name(static_cast<Phase>(i))) + "_" +
+                     perf_event_name(static_cast<PerfEvent>(j)));
+      }
+    }
+  }
+  output.end_row();
+  // 断点续算时只有恢复之后的代有计时
+  size_t first = generation_ - phase_totals_.size();
+  const size_t eval = static_cast<size_t>(Phase::kEvaluation);
+  uint64_t all_evaluations = 0;
+  uint64_t all_eval_allocs = 0;
+  uint64_t all_eval_bytes = 0;
+  for (size_t g = 0; g != phase_totals_.size(); ++g) {
+    const PhaseTotals &t = phase_totals_[g];
+    output.field(static_cast<int64_t>(first + g + 1))
+        .field(generation_seconds_[g]);
+    for (size_t i = 0; i != kPhaseCnt; ++i) {
+      output.field(static_cast<double>(t.ns[i]) * 1e-9);
+    }
+    output.field(static_cast<int64_t>(t.calls[eval]));
+    all_evaluations += t.calls[eval];
+    all_eval_allocs += t.alloc_cnt[eval];
+    all_eval_bytes += t.alloc_bytes[eval];
+    if (allocs) {
+      uint64_t cnt = 0;
+      uint64_t bytes = 0;
+      for (size_t i = 0; i != kPhaseCnt + 1; ++i) {
+        output.field(static_cast<int64_t>(t.alloc_cnt[i]))
+            .field(static_cast<int64_t>(t.alloc_bytes[i]));
+        cnt += t.alloc_cnt[i];
+        bytes += t.alloc_bytes[i];
+      }
+      double evals = std::max(1.0, static_cast<double>(t.calls[eval]));
+      output.field(static_cast<int64_t>(cnt))
+          .field(static_cast<int64_t>(bytes))
+          .field(static_cast<double>(t.alloc_cnt[eval]) / evals)
+          .field(static_cast<double>(t.alloc_bytes[eval]) / evals);
+    }
+    if (perf) {
+      for (size_t i = 0; i != kPhaseCnt; ++i) {
+        for (size_t j = 0; j != kPerfEventCnt; ++j) {
+          if (perf_unmeasured) {
+            output.field("n/a");
+          } else {
+            output.field(static_cast<int64_t>(t.perf[i][j]));
+          }
+        }
       }
     }
-    iter_data << "\n";
+    output.end_row();
+  }
+  if (!output.close()) {
+    std::cout << "Failed to write [" << f_name << "] !" << std::endl;
+    return false;
   }
-  iter_data.close();
   std::cout << "Save file [" << f_name << "] successful!" << std::endl;
+  if (allocs && all_evaluations != 0) {
+    double evals = static_cast<double>(all_evaluations);
+    std::cout << "Allocations per evaluation: "
+              << static_cast<double>(all_eval_allocs) / evals << " ("
+              << static_cast<double>(all_eval_bytes) / evals << " bytes)"
+              << std::endl;
+  }
+  return true;
+}
+
+void Solver::print_perf_summary() const {
+  std::array<perf_values_t, kPhaseCnt> sum = {};
+  for (const auto &t : phase_totals_) {
+    for (size_t i = 0; i != kPhaseCnt; ++i) {
+      for (size_t j = 0; j != kPerfEventCnt; ++j) {
+        sum[i][j] += t.perf[i][j];
+      }
+    }
+  }
+  yaohui::print_perf_summary(sum);
 }
 
 // 生成初始种群
@@ -131,15 +399,90 @@ void Solver::init_population() {
   population_.reserve(population_cnt_);
   for (size_t i = 0; i < population_cnt_; ++i) {
     TimetableConfig default_config;
-    Individual default_individual(std::move(default_config));
+    Individual default_individual(std::move(default_config), rng_);
     population_.push_back(std::move(default_individual));
   }
   // 将个体按照适应度由大到小排序
   std::sort(population_.begin(), population_.end(), is_better);
 }
 
+// 以种子运行图热启动生成初始种群: 种子本身及其邻域个体
+void Solver::init_population(const TimetableConfig &seed_config) {
+  population_.reserve(population_cnt_);
+  population_.push_back(Individual::from_config(seed_config));
+  while (population_.size() < population_cnt_) {
+    population_.push_back(perturbed_neighbour(population_.front(), rng_));
+  }
+  std::sort(population_.begin(), population_.end(), is_better);
+}
+
+// 在设计空间中按低差异序列生成初始种群, 并行评分
+void Solver::init_population(SamplingMethod method) {
+  QuasiRandomSampler sampler(method, TimetableConfig(),
+                             static_cast<unsigned>(rng_()), thread_cnt_);
+  population_ = sampler.next_batch(population_cnt_);
+  std::sort(population_.begin(), population_.end(), is_better);
+}
+
+// 随机扰动种子个体约2%的基因: 发车时刻在追踪间隔范围内平移,
+// 停站时长在上下限范围内重新抽取
+Individual Solver::perturbed_neighbour(const Individual &seed,
+                                       std::default_random_engine &e) {
+  TimetableConfig config = seed.timetable_config();
+  const LineModel &line = config.line();
+  std::vector<first_departure_time_t *> de_vecs = {
+      &config.down_departure_time_vec(), &config.up_departure_time_vec()};
+  std::vector<each_stop_duration_t *> stop_vecs = {
+      &config.down_stop_duration_vec(), &config.up_stop_duration_vec()};
+  const size_t inner_cnt =
+      line.stations().size() > 2 ? line.stations().size() - 2 : 0;
+  const size_t de_genes = de_vecs[0]->size() + de_vecs[1]->size();
+  const size_t total_genes = de_genes + config.missions_cnt() * inner_cnt;
+  if (total_genes == 0) {
+    return seed;
+  }
+  std::uniform_int_distribution<size_t> gene_u(0, total_genes - 1);
+  size_t k = std::max<size_t>(1, total_genes / 50);
+  for (size_t t = 0; t != k; ++t) {
+    size_t g = gene_u(e);
+    if (g < de_genes) {
+      // 发车时刻基因
+      first_departure_time_t &de = *de_vecs[g < de_vecs[0]->size() ? 0 : 1];
+      size_t i = g < de_vecs[0]->size() ? g : g - de_vecs[0]->size();
+      if (i == 0) {
+        continue; // 首班车发车时刻不变
+      }
+      second_t di_1 = de[i - 1];
+      second_t di = de[i];
+      second_t oft =
+          di - di_1 - LineModel::find_departure_T(di_1, line.departure_T_min());
+      second_t oyt =
+          LineModel::find_departure_T(di_1, line.departure_T_max()) -
+          (di - di_1);
+      if (oft < 0 || oyt < 0) {
+        continue;
+      }
+      de[i] += std::uniform_int_distribution<second_t>(-oft, oyt)(e);
+    } else {
+      // 停站时长基因
+      g -= de_genes;
+      size_t m = g / inner_cnt;
+      station_id_t id = line.stations()[1 + g % inner_cnt];
+      each_stop_duration_t &stops =
+          *stop_vecs[m < stop_vecs[0]->size() ? 0 : 1];
+      size_t mi = m < stop_vecs[0]->size() ? m : m - stop_vecs[0]->size();
+      stops[mi][id] = std::uniform_int_distribution<second_t>(
+          line.stop_duration_min().find(id)->second,
+          line.stop_duration_max().find(id)->second)(e);
+    }
+  }
+  return Individual::from_config(std::move(config));
+}
+
 Individual Solver::random_choose(const std::vector<Individual> &population,
-                                 const std::vector<double> &weight) {
+                                 const std::vector<double> &weight,
+                                 std::default_random_engine &e) {
+  YAOHUI_PHASE_SCOPE(Phase::kSelection);
   assert(population.size() == weight.size());
   // 首先计算累计概率
   double weight_cum = 0.0;
@@ -151,10 +494,8 @@ Individual Solver::random_choose(const std::vector<Individual> &population,
   }
 
   // 根据累计概率随机抽取元素
-  auto tp_epoch = std::chrono::system_clock::now().time_since_epoch().count();
-  static std::default_random_engine rand_choose_e(tp_epoch);
-  static std::uniform_real_distribution<double> rand_choose_u(0, weight_cum);
-  double temp = rand_choose_u(rand_choose_e); // 进行1次抽取
+  std::uniform_real_distribution<double> rand_choose_u(0, weight_cum);
+  double temp = rand_choose_u(e); // 进行1次抽取
   for (size_t i = 0; i != weight_cum_vec.size(); ++i) {
     if (weight_cum_vec.at(i) >= temp) {
       // 选取第i个脚标对应的元素
@@ -164,11 +505,13 @@ Individual Solver::random_choose(const std::vector<Individual> &population,
   return population.back();
 }
 
-void Solver::parents_cross(Individual &father, Individual &mother) {
-  auto tp_epoch = std::chrono::system_clock::now().time_since_epoch().count();
-  static std::default_random_engine cross_down_index_e(tp_epoch);
+void Solver::parents_cross(Individual &father, Individual &mother,
+                           std::default_random_engine &e) {
+  YAOHUI_PHASE_SCOPE(Phase::kCrossover);
+  TraceScope trace("crossover");
   TimetableConfig &father_tb_config = father.timetable_config();
   TimetableConfig &mother_tb_config = mother.timetable_config();
+  const auto &stations = father_tb_config.stations();
 
   auto &father_down_de = father_tb_config.down_departure_time_vec();
   auto &father_down_stop = father_tb_config.down_stop_duration_vec();
@@ -178,21 +521,21 @@ void Solver::parents_cross(Individual &father, Individual &mother) {
   assert(father_down_de.size() == mother_down_de.size());
   assert(father_down_de.size() == mother_down_stop.size());
 
-  static std::uniform_int_distribution<size_t> random_down_i(
-      0, father_down_de.size());
-  size_t rdi = random_down_i(cross_down_index_e);
+  std::uniform_int_distribution<size_t> random_down_i(0,
+                                                      father_down_de.size());
+  size_t rdi = random_down_i(e);
   for (size_t i = 0; i != rdi; ++i) {
     std::swap(father_down_de.at(i), mother_down_de.at(i));
   }
-  rdi = random_down_i(cross_down_index_e);
+  rdi = random_down_i(e);
   for (size_t i = 0; i != rdi; ++i) {
     std::swap(father_down_stop.at(i), mother_down_stop.at(i));
-    tp_epoch = std::chrono::system_clock::now().time_since_epoch().count();
-    static std::default_random_engine cross_index_j_e(tp_epoch);
-    static std::uniform_int_distribution<size_t> random_down_j(
+    std::uniform_int_distribution<size_t> random_down_j(
         0, father_down_stop.front().size() - 1);
-    for (station_id_t j = 0; j < random_down_j(cross_index_j_e); ++j) {
-      std::swap(father_down_stop.at(i).at(j), mother_down_stop.at(i).at(j));
+    size_t rdj = random_down_j(e); // 交叉点只抽取一次
+    for (size_t j = 0; j != rdj; ++j) {
+      std::swap(father_down_stop.at(i).at(stations[j]),
+                mother_down_stop.at(i).at(stations[j]));
     }
   }
 
@@ -204,23 +547,20 @@ void Solver::parents_cross(Individual &father, Individual &mother) {
   assert(father_up_de.size() == mother_up_de.size());
   assert(father_up_de.size() == mother_up_stop.size());
 
-  tp_epoch = std::chrono::system_clock::now().time_since_epoch().count();
-  static std::default_random_engine cross_up_index_e(tp_epoch);
-  static std::uniform_int_distribution<size_t> random_up_i(0,
-                                                           father_up_de.size());
-  rdi = random_up_i(cross_up_index_e);
+  std::uniform_int_distribution<size_t> random_up_i(0, father_up_de.size());
+  rdi = random_up_i(e);
   for (size_t i = 0; i != rdi; ++i) {
     std::swap(father_up_de.at(i), mother_up_de.at(i));
   }
-  rdi = random_up_i(cross_up_index_e);
+  rdi = random_up_i(e);
   for (size_t i = 0; i != rdi; ++i) {
     std::swap(father_up_stop.at(i), mother_up_stop.at(i));
-    tp_epoch = std::chrono::system_clock::now().time_since_epoch().count();
-    static std::default_random_engine cross_index_up_j_e(tp_epoch);
-    static std::uniform_int_distribution<size_t> random_up_j(
-        0, father_down_stop.front().size() - 1);
-    for (station_id_t j = 0; j < random_up_j(cross_index_up_j_e); ++j) {
-      std::swap(father_down_stop.at(i).at(j), mother_down_stop.at(i).at(j));
+    std::uniform_int_distribution<size_t> random_up_j(
+        0, father_up_stop.front().size() - 1);
+    size_t ruj = random_up_j(e); // 交叉点只抽取一次
+    for (size_t j = 0; j != ruj; ++j) {
+      std::swap(father_up_stop.at(i).at(stations[j]),
+                mother_up_stop.at(i).at(stations[j]));
     }
   }
   father.update_score();
@@ -230,18 +570,20 @@ void Solver::parents_cross(Individual &father, Individual &mother) {
 std::vector<Individual>
 Solver::birth_single_threading(const std::vector<Individual> &population,
                                const std::vector<double> &weights,
-                               double cross_p, size_t child_cnt) {
+                               double cross_p, size_t child_cnt,
+                               unsigned seed) {
+  TraceScope trace("birth_task", "children", static_cast<int64_t>(child_cnt));
+  // 每个任务使用独立的随机数引擎, 种子由主引擎抽取
+  std::default_random_engine e(seed);
+  std::uniform_real_distribution<double> cross_u(0, 1.0);
   std::vector<Individual> ret;
   for (int i = 0; i < child_cnt; ++i) {
-    auto tp_epoch = std::chrono::system_clock::now().time_since_epoch().count();
-    static std::default_random_engine cross_e(tp_epoch);
-    static std::uniform_real_distribution<double> cross_u(0, 1.0);
     // 根据权重选出父母
-    Individual father = random_choose(population, weights);
-    Individual mother = random_choose(population, weights);
+    Individual father = random_choose(population, weights, e);
+    Individual mother = random_choose(population, weights, e);
     // 父母交叉获得子代
-    if (cross_u(cross_e) < cross_p) {
-      parents_cross(father, mother);
+    if (cross_u(e) < cross_p) {
+      parents_cross(father, mother, e);
     }
     // 选择适应度大的作为子代
     Individual &child = father.score() > mother.score() ? father : mother;
@@ -250,7 +592,7 @@ Solver::birth_single_threading(const std::vector<Individual> &population,
   return std::move(ret);
 }
 
-std::vector<Individual> Solver::birth_multi_threading() const {
+std::vector<Individual> Solver::birth_multi_threading() {
   // 多线程
   int sz = static_cast<int>(population_cnt_);
   int th_cnt = static_cast<int>(thread_cnt_);
@@ -262,11 +604,13 @@ std::vector<Individual> Solver::birth_multi_threading() const {
   fut_vec.reserve(th_cnt);
   for (int i = 0; i < th_cnt - 1; ++i) {
     fut_vec.emplace_back(std::async(birth_single_threading, population_,
-                                    weights_, cross_p_, avg_task_cnt));
+                                    weights_, cross_p_, avg_task_cnt,
+                                    static_cast<unsigned>(rng_())));
   }
   // 最后一个线程
   fut_vec.emplace_back(std::async(birth_single_threading, population_, weights_,
-                                  cross_p_, last_task_cnt));
+                                  cross_p_, last_task_cnt,
+                                  static_cast<unsigned>(rng_())));
 
   // 最终结果
   std::vector<Individual> result;
@@ -278,38 +622,25 @@ std::vector<Individual> Solver::birth_multi_threading() const {
   return std::move(result);
 }
 
-void Solver::child_mutate(Individual &child) const {
-  auto tp_epoch = std::chrono::system_clock::now().time_since_epoch().count();
-  static std::default_random_engine mutate_e(tp_epoch);
-  static std::uniform_real_distribution<double> mutate_u(0, 1.0);
+void Solver::child_mutate(Individual &child) {
+  YAOHUI_PHASE_SCOPE(Phase::kMutation);
+  std::uniform_real_distribution<double> mutate_u(0, 1.0);
 
-  if (mutate_u(mutate_e) >= mutate_p_) {
+  if (mutate_u(rng_) >= mutate_p_) {
     return;
   }
-
-  auto find_T = [](second_t t, const departure_T_t &dT) -> second_t {
-    // 寻找追踪间隔
-    second_t departure_T;
-    for (const auto &dt : dT) {
-      if (t >= dt.first.first && t < dt.first.second) {
-        departure_T = dt.second;
-        break;
-      }
-    }
-    return departure_T;
-  };
+  TraceScope trace("mutation");
 
   TimetableConfig &config = child.timetable_config();
+  const LineModel &line = config.line();
 
   // down departure
   // 获取下行首站发车时刻序列
   auto &down_de_vec = config.down_departure_time_vec();
 
-  tp_epoch = std::chrono::system_clock::now().time_since_epoch().count();
-  static std::default_random_engine down_departure_mutate_index_e(tp_epoch);
-  static std::uniform_int_distribution<size_t> down_departure_mutate_index_u(
+  std::uniform_int_distribution<size_t> down_departure_mutate_index_u(
       0, down_de_vec.size() - 1);
-  size_t r = down_departure_mutate_index_u(down_departure_mutate_index_e);
+  size_t r = down_departure_mutate_index_u(rng_);
   for (size_t i = r; i <= down_de_vec.size() - 1; ++i) {
     if (i == 0) {
       continue;
@@ -317,19 +648,21 @@ void Solver::child_mutate(Individual &child) const {
     second_t di_1 = down_de_vec.at(i - 1);
     second_t di = down_de_vec.at(i);
     // 寻找i-1时刻的最小追踪间隔
-    second_t departure_T_min = find_T(di_1, config.departure_T_min());
+    second_t departure_T_min =
+        LineModel::find_departure_T(di_1, line.departure_T_min());
     second_t oft = di - di_1 - departure_T_min; // 更新oft
     // 寻找i-1时刻的最大追踪间隔
-    second_t departure_T_max = find_T(di_1, config.departure_T_max());
+    second_t departure_T_max =
+        LineModel::find_departure_T(di_1, line.departure_T_max());
     second_t oyt = departure_T_max - (di - di_1); // 更新oyt
+    if (-oft > oyt) {
+      continue; // 偏移量的取值范围为空
+    }
 
     // 随机偏移量
-    tp_epoch = std::chrono::system_clock::now().time_since_epoch().count();
-    static std::default_random_engine down_departure_mutate_offset_e(tp_epoch);
-    static std::uniform_int_distribution<second_t>
-        down_departure_mutate_offset_u(-oft, oyt);
-    second_t r2 =
-        down_departure_mutate_offset_u(down_departure_mutate_offset_e);
+    std::uniform_int_distribution<second_t> down_departure_mutate_offset_u(
+        -oft, oyt);
+    second_t r2 = down_departure_mutate_offset_u(rng_);
     // 更新di
     down_de_vec.at(i) += r2;
   }
@@ -337,11 +670,9 @@ void Solver::child_mutate(Individual &child) const {
   // 获取上行首站发车时刻序列
   auto &up_de_vec = config.up_departure_time_vec();
 
-  tp_epoch = std::chrono::system_clock::now().time_since_epoch().count();
-  static std::default_random_engine up_departure_mutate_index_e(tp_epoch);
-  static std::uniform_int_distribution<size_t> up_departure_mutate_index_u(
+  std::uniform_int_distribution<size_t> up_departure_mutate_index_u(
       0, up_de_vec.size() - 1);
-  r = up_departure_mutate_index_u(up_departure_mutate_index_e);
+  r = up_departure_mutate_index_u(rng_);
   for (size_t i = r; i <= up_de_vec.size() - 1; ++i) {
     if (i == 0) {
       continue;
@@ -349,67 +680,352 @@ void Solver::child_mutate(Individual &child) const {
     second_t di_1 = up_de_vec.at(i - 1);
     second_t di = up_de_vec.at(i);
     // 寻找i-1时刻的最小追踪间隔
-    second_t departure_T_min = find_T(di_1, config.departure_T_min());
+    second_t departure_T_min =
+        LineModel::find_departure_T(di_1, line.departure_T_min());
     second_t oft = di - di_1 - departure_T_min; // 更新oft
     // 寻找i-1时刻的最大追踪间隔
-    second_t departure_T_max = find_T(di_1, config.departure_T_max());
+    second_t departure_T_max =
+        LineModel::find_departure_T(di_1, line.departure_T_max());
     second_t oyt = departure_T_max - (di - di_1); // 更新oyt
+    if (-oft > oyt) {
+      continue; // 偏移量的取值范围为空
+    }
 
     // 随机偏移量
-    tp_epoch = std::chrono::system_clock::now().time_since_epoch().count();
-    static std::default_random_engine up_departure_mutate_offset_e(tp_epoch);
-    static std::uniform_int_distribution<second_t> up_departure_mutate_offset_u(
+    std::uniform_int_distribution<second_t> up_departure_mutate_offset_u(
         -oft, oyt);
-    second_t r2 = up_departure_mutate_offset_u(up_departure_mutate_offset_e);
+    second_t r2 = up_departure_mutate_offset_u(rng_);
     // 更新di
     up_de_vec.at(i) += r2;
   }
 
   // down stop
   for (auto &l : config.down_stop_duration_vec()) {
-    tp_epoch = std::chrono::system_clock::now().time_since_epoch().count();
-    static std::default_random_engine down_stop_mutate_index_e(tp_epoch);
-    static std::uniform_int_distribution<station_id_t> down_stop_mutate_index_u(
-        config.stations().front(), config.stations().back());
-    station_id_t r1 = down_stop_mutate_index_u(down_stop_mutate_index_e);
-    if (r1 == config.stations().front() || r1 == config.stations().back()) {
+    std::uniform_int_distribution<size_t> down_stop_mutate_index_u(
+        0, config.stations().size() - 1);
+    size_t pos = down_stop_mutate_index_u(rng_);
+    // 首末站停站时长固定
+    if (pos == 0 || pos + 1 == config.stations().size()) {
       continue;
     }
+    station_id_t r1 = config.stations()[pos];
 
     second_t LB = config.stop_duration_min().at(r1);
     second_t UB = config.stop_duration_max().at(r1);
 
-    tp_epoch = std::chrono::system_clock::now().time_since_epoch().count();
-    static std::default_random_engine down_stop_mutate_offset_e(tp_epoch);
-    static std::uniform_int_distribution<second_t> down_stop_mutate_offset_u(
-        LB, UB);
-    second_t r2 = down_stop_mutate_offset_u(down_stop_mutate_offset_e);
+    std::uniform_int_distribution<second_t> down_stop_mutate_offset_u(LB, UB);
+    second_t r2 = down_stop_mutate_offset_u(rng_);
     l.at(r1) = r2;
   }
 
   // up stop
   for (auto &l : config.up_stop_duration_vec()) {
-    tp_epoch = std::chrono::system_clock::now().time_since_epoch().count();
-    static std::default_random_engine up_stop_mutate_index_e(tp_epoch);
-    static std::uniform_int_distribution<station_id_t> up_stop_mutate_index_u(
-        config.stations().front(), config.stations().back());
-    station_id_t r1 = up_stop_mutate_index_u(up_stop_mutate_index_e);
-    if (r1 == config.stations().front() || r1 == config.stations().back()) {
+    std::uniform_int_distribution<size_t> up_stop_mutate_index_u(
+        0, config.stations().size() - 1);
+    size_t pos = up_stop_mutate_index_u(rng_);
+    // 首末站停站时长固定
+    if (pos == 0 || pos + 1 == config.stations().size()) {
       continue;
     }
+    station_id_t r1 = config.stations()[pos];
 
     second_t LB = config.stop_duration_min().at(r1);
     second_t UB = config.stop_duration_max().at(r1);
 
-    tp_epoch = std::chrono::system_clock::now().time_since_epoch().count();
-    static std::default_random_engine up_stop_mutate_offset_e(tp_epoch);
-    static std::uniform_int_distribution<second_t> up_stop_mutate_offset_u(LB,
-                                                                           UB);
-    second_t r2 = up_stop_mutate_offset_u(up_stop_mutate_offset_e);
+    std::uniform_int_distribution<second_t> up_stop_mutate_offset_u(LB, UB);
+    second_t r2 = up_stop_mutate_offset_u(rng_);
     l.at(r1) = r2;
   }
   // 更新score
   child.update_score();
 }
 
-} // namespace yaohui
\ No newline at end of file
+Individual Solver::hill_climb(const Individual &start, size_t budget,
+                             unsigned seed) {
+  YAOHUI_PHASE_SCOPE(Phase::kLocalSearch);
+  std::default_random_engine e(seed);
+  Evaluator ev(start.timetable_config());
+  double current = ev.ratio();
+  bool improved = false;
+  Evaluator::Move move;
+  for (size_t i = 0; i != budget; ++i) {
+    YAOHUI_PHASE_SCOPE(Phase::kMove);
+    if (!ev.random_move(e, move)) {
+      continue;
+    }
+    double next = ev.apply(move);
+    if (next > current) {
+      current = next;
+      improved = true;
+    } else {
+      move.delta = -move.delta;
+      ev.apply(move);
+    }
+  }
+  if (!improved) {
+    return start;
+  }
+  // 以Timetable重新评分
+  Individual ret = Individual::from_config(ev.config());
+  return ret.score() > start.score() ? ret : start;
+}
+
+// 对最好的local_search_k_个个体并行局部搜索, 之后重新排序.
+// 线程数不超过thread_cnt_, 多于线程数的个体在池中排队
+void Solver::local_search() {
+  size_t k = std::min(local_search_k_, population_.size());
+  if (k == 0) {
+    return;
+  }
+  ThreadPool pool(std::min(thread_cnt_, k));
+  std::vector<std::future<Individual>> fut_vec;
+  fut_vec.reserve(k);
+  for (size_t i = 0; i != k; ++i) {
+    const Individual &individual = population_[i];
+    size_t budget = local_search_budget_;
+    auto seed = static_cast<unsigned>(rng_());
+    fut_vec.push_back(pool.submit([&individual, budget, seed] {
+      return hill_climb(individual, budget, seed);
+    }));
+  }
+  for (size_t i = 0; i != k; ++i) {
+    population_[i] = fut_vec[i].get();
+  }
+  YAOHUI_PHASE_SCOPE(Phase::kSort);
+  std::sort(population_.begin(), population_.end(), is_better);
+}
+
+namespace {
+
+// 检查点编码时按顺序写入数据, 空间须事先分配好
+struct CheckpointWriter {
+  char *p;
+  void put(const void *data, size_t n) {
+    std::memcpy(p, data, n);
+    p += n;
+  }
+  template <typename T> void put(const T &v) { put(&v, sizeof(T)); }
+};
+
+// 检查点解码时按顺序读出数据, 越界时抛出异常
+struct CheckpointReader {
+  const char *p;
+  const char *end;
+  void get(void *data, size_t n) {
+    if (static_cast<size_t>(end - p) < n) {
+      throw std::runtime_error("checkpoint is truncated");
+    }
+    std::memcpy(data, p, n);
+    p += n;
+  }
+  template <typename T> T get() {
+    T v;
+    get(&v, sizeof(T));
+    return v;
+  }
+};
+
+// 一条染色体记录的字节数
+size_t genome_size(const SolverCheckpointHeader &h) {
+  size_t missions = h.down_missions_cnt + h.up_missions_cnt;
+  return sizeof(double) + sizeof(second_t) * missions * (1 + h.station_cnt);
+}
+
+void put_genome(CheckpointWriter &w, const Individual &individual) {
+  const TimetableConfig &c = individual.timetable_config();
+  w.put(individual.score());
+  w.put(c.down_departure_time_vec().data(),
+        sizeof(second_t) * c.down_departure_time_vec().size());
+  w.put(c.up_departure_time_vec().data(),
+        sizeof(second_t) * c.up_departure_time_vec().size());
+  for (const auto *stops :
+       {&c.down_stop_duration_vec(), &c.up_stop_duration_vec()}) {
+    for (const auto &m : *stops) {
+      assert(m.size() == c.stations().size());
+      for (const auto &kv : m) {
+        w.put(kv.second);
+      }
+    }
+  }
+}
+
+// 按记录还原染色体, 适应度直接取保存值而不重新评分.
+// sorted_stations为升序排列的车站id
+Individual get_genome(CheckpointReader &r, const SolverCheckpointHeader &h,
+                      const std::vector<station_id_t> &sorted_stations) {
+  Individual individual;
+  TimetableConfig &c = individual.timetable_config();
+  individual.score() = r.get<double>();
+  auto &down_de = c.down_departure_time_vec();
+  auto &up_de = c.up_departure_time_vec();
+  down_de.resize(h.down_missions_cnt);
+  up_de.resize(h.up_missions_cnt);
+  r.get(down_de.data(), sizeof(second_t) * down_de.size());
+  r.get(up_de.data(), sizeof(second_t) * up_de.size());
+  c.down_stop_duration_vec().resize(h.down_missions_cnt);
+  c.up_stop_duration_vec().resize(h.up_missions_cnt);
+  for (auto *stops : {&c.down_stop_duration_vec(), &c.up_stop_duration_vec()}) {
+    for (auto &m : *stops) {
+      m.clear();
+      for (station_id_t id : sorted_stations) {
+        m.emplace_hint(m.end(), id, r.get<second_t>());
+      }
+    }
+  }
+  return individual;
+}
+
+// 在后台线程中编码种群并写入检查点. 先写入临时文件再改名, 中途被杀死时
+// 原有的检查点保持完整; 种群记录写完后通过released通知主线程可以修改种群
+bool write_checkpoint_file(const std::string &f_name,
+                           const std::vector<char> &head,
+                           const std::vector<Individual> &population,
+                           size_t genome_bytes, std::promise<void> released) {
+  std::string tmp_name = f_name + ".tmp";
+  BufferedFile of(tmp_name, 1 << 20);
+  if (of.is_open()) {
+    of.write(head.data(), head.size());
+    for (const auto &individual : population) {
+      CheckpointWriter w{of.reserve(genome_bytes)};
+      put_genome(w, individual);
+      of.commit(genome_bytes);
+    }
+  }
+  released.set_value();
+  if (!of.is_open()) {
+    return false;
+  }
+  if (!of.close()) {
+    std::remove(tmp_name.c_str());
+    return false;
+  }
+  return std::rename(tmp_name.c_str(), f_name.c_str()) == 0;
+}
+
+} // namespace
+
+// 编码检查点中当前种群之前的部分
+std::vector<char> Solver::encode_checkpoint_head() const {
+  const TimetableConfig &config = population_.front().timetable_config();
+  SolverCheckpointHeader h;
+  std::memset(&h, 0, sizeof(h));
+  std::memcpy(h.magic, kSolverCheckpointMagic, sizeof(h.magic));
+  h.version = kSolverCheckpointVersion;
+  h.station_cnt = static_cast<uint32_t>(config.stations().size());
+  h.generation = generation_;
+  h.gene_cnt = gene_cnt_;
+  h.population_cnt = population_.size();
+  h.down_missions_cnt = static_cast<uint32_t>(config.down_missions_cnt());
+  h.up_missions_cnt = static_cast<uint32_t>(config.up_missions_cnt());
+  h.cross_p = cross_p_;
+  h.mutate_p = mutate_p_;
+  h.alpha = alpha_;
+  std::ostringstream rng_state;
+  rng_state << rng_;
+  const std::string rng_s = rng_state.str();
+  h.rng_state_size = rng_s.size();
+  h.fitness_row_cnt = fitness_vec_.size();
+  h.line_model_hash = config.line().hash();
+
+  size_t total = sizeof(h) + sizeof(station_id_t) * h.station_cnt +
+                 rng_s.size() + sizeof(double) * 3 * max_fitness_vec_.size() +
+                 sizeof(double) * h.fitness_row_cnt * h.population_cnt +
+                 genome_size(h) * 2;
+  std::vector<char> data(total);
+  CheckpointWriter w{data.data()};
+  w.put(h);
+  w.put(config.stations().data(), sizeof(station_id_t) * h.station_cnt);
+  w.put(rng_s.data(), rng_s.size());
+  for (const auto *vec :
+       {&max_fitness_vec_, &min_fitness_vec_, &avg_fitness_vec_}) {
+    w.put(vec->data(), sizeof(double) * vec->size());
+  }
+  for (const auto &row : fitness_vec_) {
+    assert(row.size() == h.population_cnt);
+    w.put(row.data(), sizeof(double) * row.size());
+  }
+  put_genome(w, first_best_individual_);
+  put_genome(w, last_best_individual_);
+  assert(w.p == data.data() + data.size());
+  return data;
+}
+
+void Solver::restore_checkpoint(const std::vector<char> &data) {
+  CheckpointReader r{data.data(), data.data() + data.size()};
+  auto h = r.get<SolverCheckpointHeader>();
+  if (std::memcmp(h.magic, kSolverCheckpointMagic, sizeof(h.magic)) != 0) {
+    throw std::runtime_error("not a solver checkpoint");
+  }
+  if (h.version != kSolverCheckpointVersion) {
+    throw std::runtime_error("unsupported checkpoint version " +
+                             std::to_string(h.version));
+  }
+  std::vector<station_id_t> stations(h.station_cnt);
+  r.get(stations.data(), sizeof(station_id_t) * stations.size());
+  if (stations != LineModel::current()->stations() ||
+      h.line_model_hash != LineModel::current()->hash()) {
+    throw std::runtime_error("checkpoint was written for a different line");
+  }
+  if (h.population_cnt == 0 || h.generation > h.gene_cnt) {
+    throw std::runtime_error("inconsistent checkpoint header");
+  }
+  gene_cnt_ = h.gene_cnt;
+  population_cnt_ = h.population_cnt;
+  cross_p_ = h.cross_p;
+  mutate_p_ = h.mutate_p;
+  alpha_ = h.alpha;
+  generation_ = h.generation;
+
+  std::string rng_s(h.rng_state_size, '\0');
+  r.get(&rng_s[0], rng_s.size());
+  std::istringstream rng_state(rng_s);
+  rng_state >> rng_;
+  if (rng_state.fail()) {
+    throw std::runtime_error("corrupt random engine state");
+  }
+  for (auto *vec : {&max_fitness_vec_, &min_fitness_vec_, &avg_fitness_vec_}) {
+    vec->resize(generation_);
+    r.get(vec->data(), sizeof(double) * vec->size());
+  }
+  fitness_vec_.assign(h.fitness_row_cnt,
+                      std::vector<double>(population_cnt_, 0.0));
+  for (auto &row : fitness_vec_) {
+    r.get(row.data(), sizeof(double) * row.size());
+  }
+  if (static_cast<size_t>(r.end - r.p) !=
+      genome_size(h) * (2 + population_cnt_)) {
+    throw std::runtime_error("unexpected size of genome records");
+  }
+  std::sort(stations.begin(), stations.end());
+  first_best_individual_ = get_genome(r, h, stations);
+  last_best_individual_ = get_genome(r, h, stations);
+  population_.clear();
+  population_.reserve(population_cnt_);
+  for (size_t i = 0; i != population_cnt_; ++i) {
+    population_.push_back(get_genome(r, h, stations));
+  }
+}
+
+// 主线程只复制统计数据等少量状态, 种群的编码和文件写入交给后台线程,
+// 与下一代的繁殖并行进行
+void Solver::save_checkpoint() {
+  YAOHUI_PHASE_SCOPE(Phase::kCheckpoint);
+  if (pending_checkpoint_.valid()) {
+    checkpoint_written_ = pending_checkpoint_.get();
+    if (!checkpoint_written_) {
+      std::cout << "Failed to write [" << checkpoint_name_ << "] !"
+                << std::endl;
+    }
+  }
+  std::vector<char> head = encode_checkpoint_head();
+  SolverCheckpointHeader h;
+  std::memcpy(&h, head.data(), sizeof(h));
+  std::promise<void> released;
+  population_released_ = released.get_future();
+  pending_checkpoint_ = std::async(
+      std::launch::async, write_checkpoint_file, checkpoint_name_,
+      std::move(head), std::cref(population_), genome_size(h),
+      std::move(released));
+}
+
+} // namespace yaohui
@@ -0,0 +1,114 @@
+#include "SyntheticLine.hpp"
+#include <random>
+#include <sstream>
+#include <stdexcept>
+
+namespace yaohui {
+
+LineData make_synthetic_line(const SyntheticLineSpec &spec) {
+  if (spec.station_cnt < 2) {
+    throw std::invalid_argument("a synthetic line needs at least two stations");
+  }
+  if (spec.arm_cnt == 0 || spec.arm_cnt > spec.station_cnt) {
+    throw std::invalid_argument(
+        "supply arm count must be between 1 and the station count");
+  }
+  if (spec.headway_pattern.empty()) {
+    throw std::invalid_argument("headway pattern is empty");
+  }
+  for (const auto &p : spec.headway_pattern) {
+    if (p.length <= 0 || p.headway <= p.slack || p.slack < 0) {
+      throw std::invalid_argument(
+          "headway periods need length > 0 and headway > slack >= 0");
+    }
+  }
+  if (!(0 < spec.travel_min && spec.travel_min <= spec.travel_max)) {
+    throw std::invalid_argument("travel duration range is invalid");
+  }
+  if (!(0 <= spec.stop_slack && spec.stop_slack <= spec.stop_min &&
+        spec.stop_min <= spec.stop_max)) {
+    throw std::invalid_argument("stop duration range is invalid");
+  }
+
+  std::default_random_engine e(spec.seed);
+  LineData d; // 能量曲线和产能/用能时长沿用内置线路
+  d.stations.clear();
+  d.supply_arm.clear();
+  d.travel_duration.clear();
+  d.stop_duration.clear();
+  d.stop_duration_min.clear();
+  d.stop_duration_max.clear();
+  d.departure_T.clear();
+  d.departure_T_min.clear();
+  d.departure_T_max.clear();
+
+  std::uniform_int_distribution<second_t> travel_u(spec.travel_min,
+                                                    spec.travel_max);
+  std::uniform_int_distribution<second_t> stop_u(spec.stop_min, spec.stop_max);
+  const size_t n = spec.station_cnt;
+  for (size_t i = 0; i != n; ++i) {
+    station_id_t id = static_cast<station_id_t>(i);
+    d.stations.push_back(id);
+    // 第i个车站属于第i * arm_cnt / n个供电臂
+    d.supply_arm[id] = static_cast<supply_arm_id_t>(i * spec.arm_cnt / n);
+    if (i == 0 || i + 1 == n) {
+      d.stop_duration[id] = 0;
+      d.stop_duration_min[id] = 0;
+      d.stop_duration_max[id] = 0;
+    } else {
+      second_t stop = stop_u(e);
+      d.stop_duration[id] = stop;
+      d.stop_duration_min[id] = stop - spec.stop_slack;
+      d.stop_duration_max[id] = stop + spec.stop_slack;
+    }
+    if (i + 1 != n) {
+      second_t travel = travel_u(e);
+      d.travel_duration[{id, id + 1}] = travel;
+      d.travel_duration[{id + 1, id}] = travel;
+    }
+  }
+
+  // 循环排列追踪间隔时段. 最后一个时段不截断, 以便末班车附近的发车时刻
+  // 平移后仍能找到追踪间隔
+  d.first_train_time = spec.first_train_time;
+  d.last_train_time = spec.last_train_time;
+  second_t t = spec.first_train_time;
+  for (size_t k = 0; t < spec.last_train_time; ++k) {
+    const HeadwayPeriod &p =
+        spec.headway_pattern[k % spec.headway_pattern.size()];
+    std::pair<second_t, second_t> period(t, t + p.length);
+    d.departure_T[period] = p.headway;
+    d.departure_T_min[period] = p.headway - p.slack;
+    d.departure_T_max[period] = p.headway + p.slack;
+    t += p.length;
+  }
+  return d;
+}
+
+bool parse_synthetic_line(const std::string &text, SyntheticLineSpec &spec) {
+  std::istringstream in(text);
+  long station_cnt = 0;
+  long arm_cnt = 0;
+  char comma = 0;
+  if (!(in >> station_cnt >> comma) || comma != ',' || !(in >> arm_cnt)) {
+    return false;
+  }
+  double hours = 0.0;
+  if (in >> comma) {
+    if (comma != ',' || !(in >> hours) || hours <= 0.0) {
+      return false;
+    }
+  }
+  if (!in.eof() || station_cnt < 2 || arm_cnt < 1 || arm_cnt > station_cnt) {
+    return false;
+  }
+  spec.station_cnt = static_cast<size_t>(station_cnt);
+  spec.arm_cnt = static_cast<size_t>(arm_cnt);
+  if (hours > 0.0) {
+    spec.last_train_time =
+        spec.first_train_time + static_cast<second_t>(hours * 3600.0);
+  }
+  return true;
+}
+
+} // namespace yaohui
@@ -0,0 +1,45 @@
+#include "ThreadPool.hpp"
+#include <algorithm>
+
+namespace yaohui {
+
+ThreadPool::ThreadPool(size_t thread_cnt) {
+  if (thread_cnt == 0) {
+    thread_cnt = std::max(1u, std::thread::hardware_concurrency());
+  }
+  workers_.reserve(thread_cnt);
+  for (size_t i = 0; i != thread_cnt; ++i) {
+    workers_.emplace_back(&ThreadPool::work_loop, this);
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  cv_.notify_all();
+  for (auto &w : workers_) {
+    w.join();
+  }
+}
+
+size_t ThreadPool::size() const { return workers_.size(); }
+
+void ThreadPool::work_loop() {
+  while (true) {
+    std::function<void()> task;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cv_.wait(lock, [this] { return stop_ || !tasks_.empty(); });
+      if (tasks_.empty()) {
+        return; // stop_且队列已空
+      }
+      task = std::move(tasks_.front());
+      tasks_.pop_front();
+    }
+    task();
+  }
+}
+
+} // namespace yaohui
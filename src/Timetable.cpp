@@ -1,82 +1,138 @@
 #include "Timetable.hpp"
+#include "BufferedFile.hpp"
+#include "CsvWriter.hpp"
+#include "EnergyBinaryFormat.hpp"
+#include "JsonWriter.hpp"
 #include "TimetableConfig.hpp"
-#include <fstream>
-#include <json.hpp>
+#include <algorithm>
 #include <map>
 #include <numeric>
+#include <stdexcept>
 #include <string>
 #include <utility>
 #include <vector>
 
 using namespace std;
-using namespace nlohmann;
 
 namespace yaohui {
 
+namespace {
+
+// 列数据按零游程编码后的字节数
+size_t zero_run_byte_size(const vector<joule_t> &v, size_t value_size) {
+  size_t bytes = 0;
+  size_t i = 0;
+  while (i != v.size()) {
+    while (i != v.size() && v[i] == 0.0) {
+      ++i;
+    }
+    size_t lit_beg = i;
+    while (i != v.size() && v[i] != 0.0) {
+      ++i;
+    }
+    bytes += 2 * sizeof(uint32_t) + (i - lit_beg) * value_size;
+  }
+  return bytes;
+}
+
+// 按T(float或double)写出一列数据
+template <typename T>
+void write_energy_column(BufferedFile &of, const vector<joule_t> &v,
+                         bool zero_run) {
+  if (!zero_run) {
+    for (joule_t x : v) {
+      T y = static_cast<T>(x);
+      of.write(reinterpret_cast<const char *>(&y), sizeof(T));
+    }
+    return;
+  }
+  size_t i = 0;
+  while (i != v.size()) {
+    size_t zero_beg = i;
+    while (i != v.size() && v[i] == 0.0) {
+      ++i;
+    }
+    size_t lit_beg = i;
+    while (i != v.size() && v[i] != 0.0) {
+      ++i;
+    }
+    uint32_t run[2] = {static_cast<uint32_t>(lit_beg - zero_beg),
+                       static_cast<uint32_t>(i - lit_beg)};
+    of.write(reinterpret_cast<const char *>(run), sizeof(run));
+    for (size_t j = lit_beg; j != i; ++j) {
+      T y = static_cast<T>(v[j]);
+      of.write(reinterpret_cast<const char *>(&y), sizeof(T));
+    }
+  }
+}
+
+} // namespace
+
 const std::vector<Mission> &Timetable::missions() const { return missions_; }
 vector<Station> Timetable::make_down_stations_vec(size_t down_id) {
+  // 线路模型已在加载时校验, 这里直接使用按车站顺序排列的稠密查找表
+  const LineModel &line = config_.line();
+  const auto &stations = line.stations();
+  const auto &stop_dur = config_.down_stop_duration_vec()[down_id];
   // 第i条下行运行线的发车时刻
-  auto arrive_time = config_.down_departure_time_vec().at(down_id);
+  auto arrive_time = config_.down_departure_time_vec()[down_id];
   // 保存结果
   vector<Station> seq;
-  seq.reserve(config_.stations().size());
+  seq.reserve(stations.size());
   // 按照下行顺序遍历每一个车站
-  for (auto iter = config_.stations().cbegin();
-       iter != config_.stations().cend(); ++iter) {
+  for (size_t pos = 0; pos != stations.size(); ++pos) {
     // 当前station id
-    station_id_t curr_id = *iter;
+    station_id_t curr_id = stations[pos];
     // 当前车站停站时长
-    second_t curr_stop_dur =
-        config_.down_stop_duration_vec().at(down_id).at(curr_id);
+    second_t curr_stop_dur = stop_dur.find(curr_id)->second;
     // 当前车站离站时刻
     second_t de_time = arrive_time + curr_stop_dur;
     // 当前车站所属的供电臂id
-    supply_arm_id_t arm_id = config_.supply_arm().at(curr_id);
+    supply_arm_id_t arm_id = line.arm_seq()[pos];
     // 进入当前车站过程中, 产能开始时刻
-    second_t prod_beg_time = arrive_time - config_.produce_duration();
+    second_t prod_beg_time = arrive_time - line.produce_duration();
     // 离开当前车站的过程中, 用能结束时刻
-    second_t cons_end_time = de_time + config_.consume_duration();
+    second_t cons_end_time = de_time + line.consume_duration();
     // 构造第i个station
     seq.emplace_back(curr_id, arm_id, prod_beg_time, arrive_time, de_time,
                      cons_end_time, curr_stop_dur);
     // 更新arrive_time
-    if (iter + 1 != config_.stations().cend()) {
-      station_id_t next_id = *(iter + 1); // 下一个station的id
-      arrive_time = de_time + config_.travel_duration().at({curr_id, next_id});
+    if (pos + 1 != stations.size()) {
+      arrive_time = de_time + line.down_travel_seq()[pos];
     }
   }
   return std::move(seq);
 }
 
 vector<Station> Timetable::make_up_stations_vec(size_t up_id) {
+  const LineModel &line = config_.line();
+  const auto &stations = line.stations();
+  const auto &stop_dur = config_.up_stop_duration_vec()[up_id];
   // 第i条上行运行线的发车时刻
-  second_t arrive_time = config_.up_departure_time_vec().at(up_id);
+  second_t arrive_time = config_.up_departure_time_vec()[up_id];
   // 保存结果
   vector<Station> seq;
-  seq.reserve(config_.stations().size());
+  seq.reserve(stations.size());
   // 按照上行顺序遍历每一个车站
-  for (auto iter = config_.stations().crbegin();
-       iter != config_.stations().crend(); ++iter) {
+  for (size_t pos = stations.size(); pos-- != 0;) {
     // 当前station id
-    station_id_t curr_id = *iter;
+    station_id_t curr_id = stations[pos];
     // 当前车站停站时长
-    second_t curr_stop_dur =
-        config_.up_stop_duration_vec().at(up_id).at(curr_id);
+    second_t curr_stop_dur = stop_dur.find(curr_id)->second;
     // 当前车站离站时刻
     second_t de_time = arrive_time + curr_stop_dur;
     // 当前车站所属的供电臂id
-    supply_arm_id_t arm_id = config_.supply_arm().at(curr_id);
+    supply_arm_id_t arm_id = line.arm_seq()[pos];
     // 进入当前车站过程中, 产能开始时刻
-    second_t prod_beg_time = arrive_time - config_.produce_duration();
+    second_t prod_beg_time = arrive_time - line.produce_duration();
     // 离开当前车站的过程中, 用能结束时刻
-    second_t cons_end_time = de_time + config_.consume_duration();
+    second_t cons_end_time = de_time + line.consume_duration();
     // 构造第i个station
     seq.emplace_back(curr_id, arm_id, prod_beg_time, arrive_time, de_time,
                      cons_end_time, curr_stop_dur);
     // 更新arrive_time
-    if (iter + 1 != config_.stations().crend()) {
-      station_id_t next_id = *(iter + 1); // 下一个station的id
-      arrive_time = de_time + config_.travel_duration().at({curr_id, next_id});
+    if (pos != 0) {
+      arrive_time = de_time + line.up_travel_seq()[pos - 1];
     }
   }
   return std::move(seq);
@@ -183,23 +239,42 @@ Timetable::energy_distribution() const {
   auto energy_exchange_duration = this->energy_exchange_duration();
   const auto &consume_map = energy_exchange_duration.first;
   const auto &produce_map = energy_exchange_duration.second;
+  const auto &consume_vec = config_.consume_vec();
+  const auto &produce_vec = config_.produce_vec();
+
+  // 曲线长度至少为100000秒, 运行图更长时延长到最晚的结束时刻
+  size_t horizon = 100000;
+  for (const auto *m : {&consume_map, &produce_map}) {
+    for (const auto &p : *m) {
+      for (const auto &beg_end_time_pair : p.second) {
+        // 曲线从0秒开始, 更早的窗口会写到曲线之外
+        if (beg_end_time_pair.first < 0) {
+          throw std::out_of_range("energy window starts before 0 s at " +
+                                  std::to_string(beg_end_time_pair.first));
+        }
+        horizon = std::max(horizon,
+                           static_cast<size_t>(beg_end_time_pair.second));
+      }
+    }
+  }
 
   // 各个供电臂一个运行图周期内的用能分布
   map<supply_arm_id_t, vector<joule_t>> consume_distribution;
   for (const auto &p : consume_map) {
     supply_arm_id_t curr_arm_id = p.first;
     // 首先插入一个初始化k-v对
-    consume_distribution.insert(
-        make_pair(curr_arm_id, vector<joule_t>(100000, 0.0)));
-    auto finder = consume_distribution.find(curr_arm_id);
+    auto finder =
+        consume_distribution
+            .insert(make_pair(curr_arm_id, vector<joule_t>(horizon, 0.0)))
+            .first;
+    joule_t *curve = finder->second.data();
     // 然后开始累计能量
     for (const auto &beg_end_time_pair : p.second) {
       second_t beg_time = beg_end_time_pair.first;
       second_t end_time = beg_end_time_pair.second;
-      for (size_t i = beg_time; i != end_time; ++i) {
-        size_t curr_index = i - beg_time;
-        // 增加consume_vec_.at(curr_index)千焦
-        (finder->second).at(i) += config_.consume_vec().at(curr_index);
+      // 增加consume_vec[i - beg_time]千焦
+      for (second_t i = beg_time; i != end_time; ++i) {
+        curve[i] += consume_vec[i - beg_time];
       }
     }
   }
@@ -209,17 +284,18 @@ Timetable::energy_distribution() const {
   for (const auto &p : produce_map) {
     supply_arm_id_t curr_arm_id = p.first;
     // 首先插入一个初始化k-v对
-    produce_distribution.insert(
-        make_pair(curr_arm_id, vector<joule_t>(100000, 0.0)));
-    auto finder = produce_distribution.find(curr_arm_id);
+    auto finder =
+        produce_distribution
+            .insert(make_pair(curr_arm_id, vector<joule_t>(horizon, 0.0)))
+            .first;
+    joule_t *curve = finder->second.data();
     // 然后开始累计能量
     for (const auto &beg_end_time_pair : p.second) {
       second_t beg_time = beg_end_time_pair.first;
       second_t end_time = beg_end_time_pair.second;
-      for (size_t i = beg_time; i != end_time; ++i) {
-        size_t curr_index = i - beg_time;
-        // 增加produce_vec_.at(curr_index)千焦
-        (finder->second).at(i) += config_.produce_vec().at(curr_index);
+      // 增加produce_vec[i - beg_time]千焦
+      for (second_t i = beg_time; i != end_time; ++i) {
+        curve[i] += produce_vec[i - beg_time];
       }
     }
   }
@@ -248,8 +324,8 @@ double Timetable::total_reuse_ratio() const {
       curr_arm_produce_energy += curr_produce_v[i];
       // 再利用的能量
       curr_arm_reuse_energy +=
-          (curr_produce_v[i] > curr_consume_v[i] ? curr_consume_v.at(i)
-                                                 : curr_produce_v.at(i));
+          (curr_produce_v[i] > curr_consume_v[i] ? curr_consume_v[i]
+                                                 : curr_produce_v[i]);
     }
     // 将计算结果累计
     total_produce_energy += curr_arm_produce_energy;
@@ -258,10 +334,11 @@ double Timetable::total_reuse_ratio() const {
   return total_reuse_energy / total_produce_energy;
 }
 
-void Timetable::output_energy_distribution(std::string pre_name) const {
+bool Timetable::output_energy_distribution(std::string pre_name) const {
   auto energy_distribution = this->energy_distribution();
   const auto &energy_consume_distribution = energy_distribution.first;
   const auto &energy_produce_distribution = energy_distribution.second;
+  bool ok = true; // 所有文件均写入成功
   // 输出用能曲线
   for (const auto &kv : energy_consume_distribution) {
     supply_arm_id_t curr_arm_id = kv.first;
@@ -270,15 +347,21 @@ void Timetable::output_energy_distribution(std::string pre_name) const {
     out_file_name.append("consume-supply-id-");
     out_file_name.append(curr_arm_id_str);
     out_file_name.append(".csv");
-    ofstream of(out_file_name, std::ios::out);
+    CsvWriter of(out_file_name);
     if (!of.is_open()) {
       std::cout << "Failed to open [" << out_file_name << "] !" << std::endl;
+      ok = false;
+      continue;
     }
 
     for (const auto &item : kv.second) {
-      of << to_string(item) << "\n";
+      of.field(item).end_row();
+    }
+    if (!of.close()) {
+      std::cout << "Failed to write [" << out_file_name << "] !" << std::endl;
+      ok = false;
+      continue;
     }
-    of.close();
     std::cout << "Save file [" << out_file_name << "] successful!" << std::endl;
   }
   // 输出产能曲线
@@ -289,108 +372,206 @@ void Timetable::output_energy_distribution(std::string pre_name) const {
     out_file_name.append("produce-supply-id-");
     out_file_name.append(curr_arm_id_str);
     out_file_name.append(".csv");
-    ofstream of(out_file_name, std::ios::out);
+    CsvWriter of(out_file_name);
     if (!of.is_open()) {
       std::cout << "Failed to open [" << out_file_name << "] !" << std::endl;
+      ok = false;
+      continue;
     }
 
     for (const auto &item : kv.second) {
-      of << to_string(item) << "\n";
+      of.field(item).end_row();
+    }
+    if (!of.close()) {
+      std::cout << "Failed to write [" << out_file_name << "] !" << std::endl;
+      ok = false;
+      continue;
     }
-    of.close();
     std::cout << "Save file [" << out_file_name << "] successful!" << std::endl;
   }
+  return ok;
 }
 
-void Timetable::write_to_file(std::string json_name) const {
-  json timetable_j;
-  timetable_j["timetable_id"] = timetable_id_;
+bool Timetable::output_energy_distribution_binary(std::string f_name,
+                                                  bool use_float32,
+                                                  bool zero_run) const {
+  auto energy_distribution = this->energy_distribution();
+  // 列目录: 先用能曲线, 后产能曲线
+  vector<EnergyBinaryColumn> columns;
+  vector<const vector<joule_t> *> data;
+  for (const auto &kv : energy_distribution.first) {
+    columns.push_back({kv.first, kConsume, 0, 0, 0});
+    data.push_back(&kv.second);
+  }
+  for (const auto &kv : energy_distribution.second) {
+    columns.push_back({kv.first, kProduce, 0, 0, 0});
+    data.push_back(&kv.second);
+  }
+  const size_t value_size = use_float32 ? sizeof(float) : sizeof(double);
+  uint64_t sample_cnt = data.empty() ? 0 : data.front()->size();
+  uint64_t offset = sizeof(EnergyBinaryHeader) +
+                    columns.size() * sizeof(EnergyBinaryColumn);
+  for (size_t i = 0; i != columns.size(); ++i) {
+    const vector<joule_t> &v = *data[i];
+    columns[i].offset = offset;
+    columns[i].byte_size =
+        zero_run ? zero_run_byte_size(v, value_size) : v.size() * value_size;
+    columns[i].nonzero_cnt = static_cast<uint64_t>(
+        v.size() - std::count(v.begin(), v.end(), 0.0));
+    offset += (columns[i].byte_size + 7) / 8 * 8; // 8字节对齐
+  }
 
-  json missions_j;
+  BufferedFile of(f_name);
+  if (!of.is_open()) {
+    std::cout << "Failed to open [" << f_name << "] !" << std::endl;
+    return false;
+  }
+  EnergyBinaryHeader header = {};
+  std::copy(kEnergyBinaryMagic, kEnergyBinaryMagic + 8, header.magic);
+  header.version = kEnergyBinaryVersion;
+  header.column_cnt = static_cast<uint32_t>(columns.size());
+  header.sample_cnt = sample_cnt;
+  header.value_type = use_float32 ? kFloat32 : kFloat64;
+  header.encoding = zero_run ? kZeroRunLength : kRaw;
+  of.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  of.write(reinterpret_cast<const char *>(columns.data()),
+           columns.size() * sizeof(EnergyBinaryColumn));
+  for (size_t i = 0; i != columns.size(); ++i) {
+    if (use_float32) {
+      write_energy_column<float>(of, *data[i], zero_run);
+    } else {
+      write_energy_column<double>(of, *data[i], zero_run);
+    }
+    static const char padding[8] = {};
+    of.write(padding, (8 - columns[i].byte_size % 8) % 8);
+  }
+  if (!of.close()) {
+    std::cout << "Failed to write [" << f_name << "] !" << std::endl;
+    return false;
+  }
+  std::cout << "Save file [" << f_name << "] successful!" << std::endl;
+  return true;
+}
+
+bool Timetable::write_to_file(std::string json_name, bool compact) const {
+  BufferedFile of(json_name);
+  if (!of.is_open()) {
+    std::cout << "Failed to open [" << json_name << "] !" << std::endl;
+    return false;
+  }
+  // 流式写出, 键按字典序排列, 与原先nlohmann::json对象的输出保持一致.
+  // 原先的数组由push_back生成, 没有元素时为null而不是[]
+  JsonWriter w(of, compact ? -1 : 2); // 默认两个空格缩进
+  w.begin_object();
+  w.key("missions");
+  if (missions_.empty()) {
+    w.null();
+  } else {
+    w.begin_array();
+  }
   // 遍历每一条运行线
   for (const auto &mission : missions_) {
-    json mission_j;
-    mission_j["mission_id"] = mission.id();
-    mission_j["is_down_direction"] = mission.is_down_direction();
+    w.begin_object();
+    // 遍历当前运行线的每一个区间
+    w.key("intervals_seq");
+    if (mission.intervals().empty()) {
+      w.null();
+    } else {
+      w.begin_array();
+    }
+    for (const auto &interval : mission.intervals()) {
+      w.begin_object();
+      w.key("consume_beg_time");
+      w.value(interval.consume_beg_time()); // 用能开始时刻
+      w.key("consume_end_time");
+      w.value(interval.consume_end_time()); // 用能结束时刻
+      w.key("consume_supply_arm_id");
+      w.value(interval.consume_supply_arm_id()); // 用能阶段所属供电臂
+      w.key("interval_id_first");
+      w.value(interval.interval_id_first()); // 行车区间id first
+      w.key("interval_id_second");
+      w.value(interval.interval_id_second()); // 行车区间id second
+      w.key("produce_begin_time");
+      w.value(interval.produce_begin_time()); // 产能开始时刻
+      w.key("produce_end_time");
+      w.value(interval.produce_end_time()); // 产能结束时刻
+      w.key("produce_supply_arm_id");
+      w.value(interval.produce_supply_arm_id()); // 产能阶段所属供电臂
+      w.end_object();
+    }
+    if (!mission.intervals().empty()) {
+      w.end_array();
+    }
+    w.key("is_down_direction");
+    w.value(mission.is_down_direction());
+    w.key("mission_id");
+    w.value(mission.id());
     // 遍历当前运行线的每一个车站
-    json station_seq_j;
+    w.key("stations_seq");
+    if (mission.stations().empty()) {
+      w.null();
+    } else {
+      w.begin_array();
+    }
     for (const auto &station : mission.stations()) {
-      json station_info_j;
-      station_info_j["station_id"] = station.station_id();       // 车站id
-      station_info_j["supply_arm_id"] = station.supply_arm_id(); // 所属供电臂id
-      station_info_j["produce_begin_time"] =
-          station.produce_begin_time(); // 产能开始时刻
-      station_info_j["arrive_time"] =
-          station.arrive_time(); // 进站时刻-秒(产能结束时刻)
-      station_info_j["departure_time"] =
-          station.departure_time(); // 离站时刻-秒(用能开始时刻)
-      station_info_j["consume_end_time"] =
-          station.consume_end_time(); // 用能结束时刻
-      station_info_j["stop_duration"] = station.stop_duration(); // 停站时长
-      station_seq_j.push_back(station_info_j);
+      w.begin_object();
+      w.key("arrive_time");
+      w.value(station.arrive_time()); // 进站时刻-秒(产能结束时刻)
+      w.key("consume_end_time");
+      w.value(station.consume_end_time()); // 用能结束时刻
+      w.key("departure_time");
+      w.value(station.departure_time()); // 离站时刻-秒(用能开始时刻)
+      w.key("produce_begin_time");
+      w.value(station.produce_begin_time()); // 产能开始时刻
+      w.key("station_id");
+      w.value(station.station_id()); // 车站id
+      w.key("stop_duration");
+      w.value(station.stop_duration()); // 停站时长
+      w.key("supply_arm_id");
+      w.value(station.supply_arm_id()); // 所属供电臂id
+      w.end_object();
     }
-    mission_j["stations_seq"] = station_seq_j;
-    // 遍历当前运行线的每一个区间
-    json interval_seq_j;
-    for (const auto &interval : mission.intervals()) {
-      json interval_info_j;
-      interval_info_j["interval_id_first"] =
-          interval.interval_id_first(); // 行车区间id first
-      interval_info_j["interval_id_second"] =
-          interval.interval_id_second(); // 行车区间id second
-      interval_info_j["consume_supply_arm_id"] =
-          interval.consume_supply_arm_id(); // 用能阶段所属供电臂
-      interval_info_j["consume_beg_time"] =
-          interval.consume_beg_time(); // 用能开始时刻
-      interval_info_j["consume_end_time"] =
-          interval.consume_end_time(); // 用能结束时刻
-      interval_info_j["produce_supply_arm_id"] =
-          interval.produce_supply_arm_id(); // 产能阶段所属供电臂
-      interval_info_j["produce_begin_time"] =
-          interval.produce_begin_time(); // 产能开始时刻
-      interval_info_j["produce_end_time"] =
-          interval.produce_end_time(); // 产能结束时刻
-      interval_seq_j.push_back(interval_info_j);
+    if (!mission.stations().empty()) {
+      w.end_array();
     }
-    mission_j["intervals_seq"] = interval_seq_j;
-    missions_j.push_back(mission_j);
+    w.end_object();
+  }
+  if (!missions_.empty()) {
+    w.end_array();
   }
-  timetable_j["missions"] = missions_j;
+  w.key("timetable_id");
+  w.value(timetable_id_);
+  w.end_object();
 
-  // 输出到文件
-  string output_str = timetable_j.dump(2); // 两个空格缩进
-  ofstream of(json_name, fstream::out);
-  if (!of.is_open()) {
-    std::cout << "Failed to open [" << json_name << "] !" << std::endl;
+  if (!of.close()) {
+    std::cout << "Failed to write [" << json_name << "] !" << std::endl;
+    return false;
   }
-  of << output_str;
-  of.close();
   std::cout << "Save file [" << json_name << "] successful!" << std::endl;
+  return true;
 }
 
-void Timetable::output_plot_data(std::string f_name) const {
+bool Timetable::output_plot_data(std::string f_name) const {
   // 运行图画图数据输出到文件
   auto plot_info = this->get_plot_data();
   // 输出到文件
-  stringstream out_ss;
+  CsvWriter out_file(f_name);
+  if (!out_file.is_open()) {
+    std::cout << "Failed to open [" << f_name << "] !" << std::endl;
+    return false;
+  }
   for (const auto &m : plot_info) {
-    for (size_t i = 0; i != m.size(); ++i) {
-      out_ss << m[i].first << "," << m[i].second;
-      if (i != m.size() - 1) {
-        out_ss << ",";
-      }
+    for (const auto &p : m) {
+      out_file.field(p.first).field(p.second);
     }
-    out_ss << "\n";
+    out_file.end_row();
   }
-
-  fstream out_file;
-  out_file.open(f_name, ios::out);
-  if (!out_file.is_open()) {
-    std::cout << "Failed to open [" << f_name << "] !" << std::endl;
+  if (!out_file.close()) {
+    std::cout << "Failed to write [" << f_name << "] !" << std::endl;
+    return false;
   }
-  out_file << out_ss.str();
-  out_file.close();
   std::cout << "Save file [" << f_name << "] successful!" << std::endl;
+  return true;
 }
 
 } // namespace yaohui
@@ -1,51 +1,67 @@
 #include "TimetableConfig.hpp"
+#include <algorithm>
 #include <chrono>
+#include <fstream>
+#include <json.hpp>
 #include <random>
+#include <stdexcept>
 #include <vector>
 
 using namespace std;
 
 namespace yaohui {
+const LineModel &TimetableConfig::line() const { return *line_; }
+const std::shared_ptr<const LineModel> &TimetableConfig::line_ptr() const {
+  return line_;
+}
 const departure_T_t &TimetableConfig::departure_T() const {
-  return departure_T_;
+  return line_->departure_T();
 }
 const departure_T_t &TimetableConfig::departure_T_min() const {
-  return departure_T_min_;
+  return line_->departure_T_min();
 }
 const departure_T_t &TimetableConfig::departure_T_max() const {
-  return departure_T_max_;
+  return line_->departure_T_max();
 }
 const stop_duration_t &TimetableConfig::stop_duration() const {
-  return stop_duration_;
+  return line_->stop_duration();
 }
 const stop_duration_t &TimetableConfig::stop_duration_min() const {
-  return stop_duration_min_;
+  return line_->stop_duration_min();
 }
 const stop_duration_t &TimetableConfig::stop_duration_max() const {
-  return stop_duration_max_;
+  return line_->stop_duration_max();
 }
 
-second_t TimetableConfig::first_train_time() const { return first_train_time_; }
-second_t TimetableConfig::last_train_time() const { return last_train_time_; }
+second_t TimetableConfig::first_train_time() const {
+  return line_->first_train_time();
+}
+second_t TimetableConfig::last_train_time() const {
+  return line_->last_train_time();
+}
 
-second_t TimetableConfig::produce_duration() const { return produce_duration_; }
-second_t TimetableConfig::consume_duration() const { return consume_duration_; }
+second_t TimetableConfig::produce_duration() const {
+  return line_->produce_duration();
+}
+second_t TimetableConfig::consume_duration() const {
+  return line_->consume_duration();
+}
 const std::vector<station_id_t> &TimetableConfig::stations() const {
-  return stations_;
+  return line_->stations();
 }
 const std::map<station_id_t, supply_arm_id_t> &
 TimetableConfig::supply_arm() const {
-  return supply_arm_;
+  return line_->supply_arm();
 }
 const std::map<interval_id_t, second_t> &
 TimetableConfig::travel_duration() const {
-  return travel_duration_;
+  return line_->travel_duration();
 }
 const std::vector<kilojoule_t> &TimetableConfig::consume_vec() const {
-  return consume_vec_;
+  return line_->consume_vec();
 }
 const std::vector<kilojoule_t> &TimetableConfig::produce_vec() const {
-  return produce_vec_;
+  return line_->produce_vec();
 }
 
 // 运行图中下行运行线的数目
@@ -104,18 +120,130 @@ TimetableConfig::TimetableConfig() {
   init_basic_stop_duration(down_departure_time_vec_.size());
 }
 
+TimetableConfig::TimetableConfig(std::shared_ptr<const LineModel> line)
+    : line_(std::move(line)) {
+  init_basic_departure_time_sequence();
+  init_basic_stop_duration(down_departure_time_vec_.size());
+}
+
+TimetableConfig TimetableConfig::load_from_timetable_file(
+    const std::string &json_name, std::shared_ptr<const LineModel> line) {
+  ifstream in(json_name);
+  if (!in.is_open()) {
+    throw std::runtime_error("Failed to open [" + json_name + "] !");
+  }
+  TimetableConfig config(std::move(line));
+  config.down_departure_time_vec_.clear();
+  config.up_departure_time_vec_.clear();
+  config.down_stop_duration_vec_.clear();
+  config.up_stop_duration_vec_.clear();
+  const auto &stations = config.stations();
+  // 各方向运行线的mission_id, 用于错误信息
+  vector<string> down_ids;
+  vector<string> up_ids;
+  try {
+    nlohmann::json j = nlohmann::json::parse(in);
+    // 按mission_id排序, 与Timetable中运行线的生成顺序一致
+    vector<const nlohmann::json *> missions;
+    for (const auto &m : j.at("missions")) {
+      missions.push_back(&m);
+    }
+    std::sort(missions.begin(), missions.end(),
+              [](const nlohmann::json *a, const nlohmann::json *b) {
+                return a->at("mission_id").get<mission_id_t>() <
+                       b->at("mission_id").get<mission_id_t>();
+              });
+    for (const nlohmann::json *m : missions) {
+      bool is_down = m->at("is_down_direction").get<bool>();
+      const auto &seq = m->at("stations_seq");
+      if (seq.size() != stations.size()) {
+        throw std::runtime_error("mission " + m->at("mission_id").dump() +
+                                 " does not match the line's stations");
+      }
+      const string mission = "mission " + m->at("mission_id").dump();
+      stop_duration_t stop_dur;
+      for (size_t k = 0; k != seq.size(); ++k) {
+        // 上行运行线按车站的逆序排列
+        size_t pos = is_down ? k : seq.size() - 1 - k;
+        auto id = seq[k].at("station_id").get<station_id_t>();
+        if (id != stations[pos]) {
+          throw std::runtime_error("mission " + m->at("mission_id").dump() +
+                                   " does not match the line's stations");
+        }
+        second_t dwell = seq[k].at("stop_duration").get<second_t>();
+        second_t dwell_min = config.stop_duration_min().at(id);
+        second_t dwell_max = config.stop_duration_max().at(id);
+        if (dwell < dwell_min || dwell > dwell_max) {
+          throw std::runtime_error(
+              mission + " stop duration " + to_string(dwell) +
+              " at station " + to_string(id) + " is outside [" +
+              to_string(dwell_min) + ", " + to_string(dwell_max) + "]");
+        }
+        stop_dur[id] = dwell;
+      }
+      // 首站进站时刻即为首站发车时刻序列中的值
+      second_t first_departure = seq.front().at("arrive_time").get<second_t>();
+      if (first_departure < config.first_train_time() ||
+          first_departure >= config.last_train_time()) {
+        throw std::runtime_error(
+            mission + " departs at " + to_string(first_departure) +
+            ", outside [" + to_string(config.first_train_time()) + ", " +
+            to_string(config.last_train_time()) + ")");
+      }
+      if (is_down) {
+        config.down_departure_time_vec_.push_back(first_departure);
+        config.down_stop_duration_vec_.push_back(std::move(stop_dur));
+        down_ids.push_back(mission);
+      } else {
+        config.up_departure_time_vec_.push_back(first_departure);
+        config.up_stop_duration_vec_.push_back(std::move(stop_dur));
+        up_ids.push_back(mission);
+      }
+    }
+  } catch (const nlohmann::json::exception &e) {
+    throw std::runtime_error("Failed to parse [" + json_name + "] : " +
+                             e.what());
+  }
+  // 每个方向至少一条运行线, 相邻运行线的追踪间隔按前车发车时刻所在的时段
+  // 满足上下限, 与Individual和Solver::child_mutate的约束相同
+  const auto check_direction = [&](const first_departure_time_t &de_vec,
+                                   const vector<string> &ids,
+                                   const char *direction) {
+    if (de_vec.empty()) {
+      throw std::runtime_error("[" + json_name + "] has no " + direction +
+                               " missions");
+    }
+    for (size_t i = 1; i != de_vec.size(); ++i) {
+      second_t headway = de_vec[i] - de_vec[i - 1];
+      second_t t_min =
+          LineModel::find_departure_T(de_vec[i - 1], config.departure_T_min());
+      second_t t_max =
+          LineModel::find_departure_T(de_vec[i - 1], config.departure_T_max());
+      if (headway < t_min || headway > t_max) {
+        throw std::runtime_error(ids[i] + " headway " + to_string(headway) +
+                                 " is outside [" + to_string(t_min) + ", " +
+                                 to_string(t_max) + "]");
+      }
+    }
+  };
+  check_direction(config.down_departure_time_vec_, down_ids, "down-direction");
+  check_direction(config.up_departure_time_vec_, up_ids, "up-direction");
+  return config;
+}
+
 void TimetableConfig::init_basic_departure_time_sequence() {
   //  auto tp_epoch =
   //  std::chrono::system_clock::now().time_since_epoch().count(); static
   //  std::default_random_engine d_e(tp_epoch); static
   //  uniform_int_distribution<second_t> d_u(-30, 30);
   // 下行
-  for (second_t curr_time = first_train_time_; curr_time < last_train_time_;) {
+  for (second_t curr_time = first_train_time();
+       curr_time < last_train_time();) {
     // 将当前遍历到的时刻加入基本发车时刻序列
     down_departure_time_vec_.push_back(curr_time);
     // 遍历departure_T寻找当前循环的发车间隔
     second_t curr_departure_T;
-    for (const auto &dt : departure_T_) {
+    for (const auto &dt : departure_T()) {
       if (curr_time >= dt.first.first && curr_time < dt.first.second) {
         curr_departure_T = dt.second;
         break;
@@ -133,7 +261,8 @@ void TimetableConfig::init_basic_departure_time_sequence() {
 void TimetableConfig::init_basic_stop_duration(size_t missions_cnt) {
   down_stop_duration_vec_.reserve(missions_cnt);
   // 用map构造map
-  fill_n(back_inserter(down_stop_duration_vec_), missions_cnt, stop_duration_);
+  fill_n(back_inserter(down_stop_duration_vec_), missions_cnt,
+         stop_duration());
 
   // 上下行对开
   up_stop_duration_vec_ = down_stop_duration_vec_;
@@ -173,31 +302,31 @@ void TimetableConfig::show() const {
   cout << "<<<< Up Standard Stop Duration >>>>" << endl;
 
   cout << ">>>> Stations Info <<<<" << endl;
-  for (const auto &item : stations_) {
+  for (const auto &item : stations()) {
     cout << item << "\t";
   }
   cout << endl;
   cout << "<<<< Stations Info >>>>" << endl;
 
   cout << ">>>> Supply Arm Info <<<<" << endl;
-  for (const auto &item : supply_arm_) {
+  for (const auto &item : supply_arm()) {
     cout << "[station id =" << item.first << "] [supply arm=" << item.second
          << "]" << endl;
   }
   cout << "<<<< Supply Arm Info >>>>" << endl;
 
   cout << ">>>> Travel Duration Info <<<<" << endl;
-  for (const auto &item : travel_duration_) {
+  for (const auto &item : travel_duration()) {
     cout << "[from=" << item.first.first << "] [to=" << item.first.second
          << "] [duration=" << item.second << "]" << endl;
   }
   cout << "<<<< Travel Duration Info >>>>" << endl;
 
   cout << ">>>> Other Info <<<<" << endl;
-  cout << "[produce_duration=" << produce_duration_ << "]" << endl;
-  cout << "[consume_duration=" << consume_duration_ << "]" << endl;
-  cout << "[first_train_time=" << first_train_time_ << "]" << endl;
-  cout << "[last_train_time=" << last_train_time_ << "]" << endl;
+  cout << "[produce_duration=" << produce_duration() << "]" << endl;
+  cout << "[consume_duration=" << consume_duration() << "]" << endl;
+  cout << "[first_train_time=" << first_train_time() << "]" << endl;
+  cout << "[last_train_time=" << last_train_time() << "]" << endl;
   cout << "<<<< Other Info >>>>" << endl;
 }
 
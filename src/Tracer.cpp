@@ -0,0 +1,199 @@
+#include "Tracer.hpp"
+#include "BufferedFile.hpp"
+#include "JsonWriter.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <vector>
+
+namespace yaohui {
+
+namespace {
+
+struct TraceEvent {
+  const char *name;     // 事件名
+  const char *arg_name; // 附加参数名
+  int64_t arg;          // 附加参数
+  uint64_t beg_ns;      // 开始时刻, 相对于启用时刻
+  uint64_t dur_ns;      // 持续时间
+};
+
+// 单写者的环形缓冲区. 所属线程写入事件后以release发布head
+struct TraceBuffer {
+  std::vector<TraceEvent> events;
+  std::atomic<uint64_t> head; // 已写入的事件总数
+  std::atomic<bool> in_use;
+
+  explicit TraceBuffer(size_t capacity)
+      : events(capacity), head(0), in_use(true) {}
+
+  void push(const TraceEvent &e) {
+    uint64_t h = head.load(std::memory_order_relaxed);
+    events[h % events.size()] = e;
+    head.store(h + 1, std::memory_order_release);
+  }
+};
+
+std::atomic<bool> g_enabled(false);
+size_t g_capacity = 0;
+std::chrono::steady_clock::time_point g_epoch;
+
+std::mutex &registry_mutex() {
+  static std::mutex m;
+  return m;
+}
+
+// 所有线程的缓冲区, deque保证元素地址不变
+std::deque<TraceBuffer> &registry() {
+  static std::deque<TraceBuffer> buffers;
+  return buffers;
+}
+
+thread_local TraceBuffer *t_buffer = nullptr;
+
+// 线程退出时归还缓冲区
+struct BufferReleaser {
+  ~BufferReleaser() {
+    if (t_buffer != nullptr) {
+      t_buffer->in_use.store(false, std::memory_order_release);
+      t_buffer = nullptr;
+    }
+  }
+};
+thread_local BufferReleaser t_releaser;
+
+TraceBuffer *thread_buffer() {
+  if (t_buffer == nullptr) {
+    std::lock_guard<std::mutex> lock(registry_mutex());
+    for (auto &b : registry()) {
+      if (!b.in_use.load(std::memory_order_acquire)) {
+        b.in_use.store(true, std::memory_order_relaxed);
+        t_buffer = &b;
+        break;
+      }
+    }
+    if (t_buffer == nullptr) {
+      registry().emplace_back(g_capacity);
+      t_buffer = &registry().back();
+    }
+    static_cast<void>(&t_releaser); // 注册线程退出时的析构
+  }
+  return t_buffer;
+}
+
+uint64_t now_ns() {
+  return static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now() - g_epoch)
+          .count());
+}
+
+} // namespace
+
+void Tracer::enable(size_t capacity) {
+  g_capacity = std::max<size_t>(1, capacity);
+  g_epoch = std::chrono::steady_clock::now();
+  g_enabled.store(true, std::memory_order_release);
+}
+
+bool Tracer::enabled() { return g_enabled.load(std::memory_order_acquire); }
+
+bool Tracer::write_to_file(const std::string &json_name) {
+  BufferedFile of(json_name);
+  if (!of.is_open()) {
+    std::cout << "Failed to open [" << json_name << "] !" << std::endl;
+    return false;
+  }
+  std::lock_guard<std::mutex> lock(registry_mutex());
+  uint64_t dropped = 0;
+  JsonWriter w(of, -1); // 事件很多, 使用紧凑格式
+  w.begin_object();
+  w.key("displayTimeUnit");
+  w.value(std::string("ms"));
+  w.key("traceEvents");
+  w.begin_array();
+  int64_t tid = 0;
+  for (auto &b : registry()) {
+    ++tid;
+    w.begin_object();
+    w.key("name");
+    w.value(std::string("thread_name"));
+    w.key("ph");
+    w.value(std::string("M"));
+    w.key("pid");
+    w.value(int64_t(1));
+    w.key("tid");
+    w.value(tid);
+    w.key("args");
+    w.begin_object();
+    w.key("name");
+    w.value("buffer " + std::to_string(tid));
+    w.end_object();
+    w.end_object();
+
+    // 缓冲区写满后只保留最近的capacity个事件
+    uint64_t head = b.head.load(std::memory_order_acquire);
+    uint64_t cap = b.events.size();
+    uint64_t first = head > cap ? head - cap : 0;
+    dropped += first;
+    for (uint64_t i = first; i != head; ++i) {
+      const TraceEvent &e = b.events[i % cap];
+      w.begin_object();
+      w.key("name");
+      w.value(std::string(e.name));
+      w.key("ph");
+      w.value(std::string("X"));
+      w.key("ts");
+      w.value(static_cast<double>(e.beg_ns) * 1e-3); // 微秒
+      w.key("dur");
+      w.value(static_cast<double>(e.dur_ns) * 1e-3);
+      w.key("pid");
+      w.value(int64_t(1));
+      w.key("tid");
+      w.value(tid);
+      if (e.arg_name != nullptr) {
+        w.key("args");
+        w.begin_object();
+        w.key(e.arg_name);
+        w.value(e.arg);
+        w.end_object();
+      }
+      w.end_object();
+    }
+  }
+  w.end_array();
+  w.end_object();
+  if (!of.close()) {
+    std::cout << "Failed to write [" << json_name << "] !" << std::endl;
+    return false;
+  }
+  std::cout << "Save file [" << json_name << "] successful!" << std::endl;
+  if (dropped != 0) {
+    std::cout << dropped << " oldest trace events were overwritten"
+              << std::endl;
+  }
+  return true;
+}
+
+TraceScope::TraceScope(const char *name, const char *arg_name, int64_t arg)
+    : name_(name), arg_name_(arg_name), arg_(arg) {
+  if (!g_enabled.load(std::memory_order_relaxed)) {
+    return;
+  }
+  buffer_ = thread_buffer();
+  beg_ns_ = now_ns();
+}
+
+TraceScope::~TraceScope() {
+  if (buffer_ == nullptr) {
+    return;
+  }
+  uint64_t end_ns = now_ns();
+  static_cast<TraceBuffer *>(buffer_)->push(
+      {name_, arg_name_, arg_, beg_ns_, end_ns - beg_ns_});
+}
+
+} // namespace yaohui
@@ -1,5 +1,6 @@
 #include "TractionCalculator.hpp"
 
+#include <algorithm>
 #include <cmath>
 #include <iostream>
 
@@ -7,31 +8,116 @@ using namespace std;
 
 namespace yaohui {
 
+TractionCalculator::TractionCalculator(const TractionParams &params)
+    : passenger_capacity_(params.passenger_capacity),
+      vehicle_m_(params.vehicle_m), F_const_(params.F_const),
+      P_limit_(params.P_limit), F_brake_(params.F_brake),
+      brake_eta_(params.brake_eta) {}
+
 double TractionCalculator::f_w0(double v) const {
-  return 2.755102 + 0.000429 * pow(v, 2);
-}
-double TractionCalculator::f_wr() const { return 600.0 / r_; }
-double TractionCalculator::f_wi() const { return is_uphill_ ? i_ : -i_; }
-double TractionCalculator::f_ws(double v) const {
-  return ((0.00357 * L_) / train_m_) *
-         (pow(1.0 - (1.0 / (1.0 + sqrt((61.475 + 0.177 * (Ls_ - L_)) / L_))),
-              2)) *
-         pow(v, 2);
+  return 2.755102 + 0.000429 * (v * v);
 }
+double TractionCalculator::f_wr() const { return wr_; }
+double TractionCalculator::f_wi() const { return wi_; }
+double TractionCalculator::f_ws(double v) const { return ws_coef_ * (v * v); }
 double TractionCalculator::f_total(double v) const {
   return ((f_w0(v) + f_wi() + f_wr() + f_ws(v)) * train_m_ * g_) / 1000.0;
 }
 
 double TractionCalculator::F_traction(double v) const {
   if (v <= 35.0) {
-    return 352.0;
+    return F_const_;
   }
-  return 352.0;
+  return F_const_;
 }
 
 double TractionCalculator::P_traction(double v) const {
   return F_traction(v) * (v / 3.6);
 }
+
+vector<double>
+TractionCalculator::accelerating_stage_W_per_second(size_t seconds) const {
+  // 与accelerating_stage_W相同的积分过程, 直接按秒累计, 不再构造逐点的map
+  double t0 = 0.0;
+  double v0 = 0.0;
+  const double t1 = time_to_P_limit();
+  const double epsilon = 0.0001;
+  const double tm = static_cast<double>(seconds);
+  vector<double> W_sec(seconds, 0.0);
+  while (t0 <= tm) {
+    double P_curr = t0 < t1 ? F_const_ * (v0 / 3.6) : P_limit_;
+    size_t index = static_cast<size_t>(floor(t0));
+    if (index < seconds) {
+      W_sec[index] += P_curr * epsilon; // (kJ)
+    }
+    double acc_curr = (F_const_ - f_total(v0)) / train_m_;
+    v0 += (acc_curr * epsilon) * 3.6;
+    t0 += epsilon;
+  }
+  return W_sec;
+}
+
+vector<double>
+TractionCalculator::brake_stage_W_per_second(size_t seconds) const {
+  // 与brake_stage_W相同的逆过程积分, 按秒累计后反转为正向时间
+  double t0 = 0.0;
+  double v0 = 0.0;
+  const double v1 = 10.0;
+  const double vm = 80.0;
+  const double epsilon = 0.0001;
+  const double tm = static_cast<double>(seconds);
+  const double acc_curr = F_brake_ / train_m_;
+  const double delta_v0 = acc_curr * epsilon;
+  vector<double> W_sec(seconds, 0.0);
+  while (t0 <= tm) {
+    size_t index = static_cast<size_t>(floor(t0));
+    if (v0 >= v1 && v0 <= vm && index < seconds) {
+      const double delta_kinetic_energy =
+          0.5 * 1000 * train_m_ *
+          ((v0 / 3.6 + delta_v0) * (v0 / 3.6 + delta_v0) -
+           (v0 / 3.6) * (v0 / 3.6));
+      W_sec[index] += delta_kinetic_energy * brake_eta_ / 1000.0; // (kJ)
+    }
+    v0 += delta_v0 * 3.6;
+    t0 += epsilon;
+  }
+  std::reverse(W_sec.begin(), W_sec.end());
+  return W_sec;
+}
+
+void TractionCalculator::f_w0_batch(const double *__restrict v,
+                                    double *__restrict out, size_t n) const {
+  for (size_t i = 0; i < n; ++i) {
+    out[i] = 2.755102 + 0.000429 * (v[i] * v[i]);
+  }
+}
+void TractionCalculator::f_ws_batch(const double *__restrict v,
+                                    double *__restrict out, size_t n) const {
+  const double c = ws_coef_;
+  for (size_t i = 0; i < n; ++i) {
+    out[i] = c * (v[i] * v[i]);
+  }
+}
+void TractionCalculator::f_total_batch(const double *__restrict v,
+                                       double *__restrict out, size_t n) const {
+  // 与f_total相同的求和顺序
+  const double wi = wi_;
+  const double wr = wr_;
+  const double ws = ws_coef_;
+  const double m = train_m_;
+  const double g = g_;
+  for (size_t i = 0; i < n; ++i) {
+    const double v2 = v[i] * v[i];
+    out[i] = (((2.755102 + 0.000429 * v2) + wi + wr + ws * v2) * m * g) /
+             1000.0;
+  }
+}
+vector<double>
+TractionCalculator::f_total_batch(const vector<double> &v) const {
+  vector<double> out(v.size());
+  f_total_batch(v.data(), out.data(), v.size());
+  return out;
+}
 void TractionCalculator::show() const {
   cout << "乘客平均质量(t): " << passenger_m_avg_ << endl;
   cout << "定员载客量(人): " << passenger_capacity_ << endl;
@@ -39,7 +125,12 @@ void TractionCalculator::show() const {
   cout << "不带司机室的拖车数目: " << T_cnt << endl;
   cout << "带司机室的动车质量(t): " << MCP_m_ << endl;
   cout << "不带司机室的拖车质量(t): " << T_m_ << endl;
+  cout << "空车质量 (t): " << vehicle_m_ << endl;
   cout << "列车质量 (t): " << train_m_ << endl;
+  cout << "最大牵引力(kN): " << F_const_ << endl;
+  cout << "最大牵引功率(kW): " << P_limit_ << endl;
+  cout << "再生制动阶段制动力(kN): " << F_brake_ << endl;
+  cout << "再生制动能量占动能的比: " << brake_eta_ << endl;
   cout << "重力加速度 m·s^(-2): " << g_ << endl;
   cout << "隧道长度 (m): " << Ls_ << endl;
   cout << "列车长度 (m): " << L_ << endl;
@@ -63,6 +154,12 @@ double TractionCalculator::time_to_P_limit() const {
 double TractionCalculator::v_P_limit() const {
   return P_limit_ / F_const_ * 3.6; //  P = F * v;
 }
+bool TractionCalculator::reaches_P_limit() const {
+  // 总阻力随速度单调增加, 只需比较功率限制速度处的阻力
+  const double vt = v_P_limit();
+  return F_const_ > 0.0 && P_limit_ > 0.0 && std::isfinite(vt) &&
+         F_const_ > f_total(vt);
+}
 map<double, double> TractionCalculator::accelerating_stage_W(double tm) const {
   double t0 = 0.0;                     // 初始时刻(s)
   double v0 = 0.0;                     // 初始速度(km/h)
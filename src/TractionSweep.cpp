@@ -0,0 +1,209 @@
+#include "TractionSweep.hpp"
+#include "CsvWriter.hpp"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <future>
+#include <iostream>
+#include <limits>
+
+using namespace std;
+
+namespace yaohui {
+
+TractionSweep::TractionSweep() {
+  TractionParams p;
+  mass_ = {p.vehicle_m};
+  passenger_capacity_ = {p.passenger_capacity};
+  F_const_ = {p.F_const};
+  P_limit_ = {p.P_limit};
+  F_brake_ = {p.F_brake};
+  brake_eta_ = {p.brake_eta};
+}
+
+bool TractionSweep::set_range(const std::string &name, double beg, double end,
+                              double step) {
+  if (name == "passenger_capacity") {
+    return set_capacity_range(beg, end, step);
+  }
+  vector<double> *target = nullptr;
+  if (name == "mass") {
+    target = &mass_;
+  } else if (name == "F_const") {
+    target = &F_const_;
+  } else if (name == "P_limit") {
+    target = &P_limit_;
+  } else if (name == "F_brake") {
+    target = &F_brake_;
+  } else if (name == "brake_eta") {
+    target = &brake_eta_;
+  }
+  if (target == nullptr || end < beg || (step <= 0.0 && end != beg)) {
+    return false;
+  }
+  // 取值从beg开始递增, 下界只需检查beg, 上界只需检查end
+  if (beg <= 0.0) {
+    return false;
+  }
+  if (target == &brake_eta_ && end > 1.0) {
+    return false;
+  }
+  target->clear();
+  if (end == beg) {
+    target->push_back(beg);
+    return true;
+  }
+  // 用整数步数生成取值, 避免累加步长带来的误差
+  auto cnt = static_cast<size_t>(floor((end - beg) / step + 1e-9)) + 1;
+  for (size_t i = 0; i != cnt; ++i) {
+    target->push_back(beg + static_cast<double>(i) * step);
+  }
+  return true;
+}
+
+// 定员是整数轴. 非整数的取值取整后会产生重复的参数组合, 因此直接拒绝
+bool TractionSweep::set_capacity_range(double beg, double end, double step) {
+  auto is_count = [](double x) {
+    return x >= 0.0 && x <= numeric_limits<int32_t>::max() && x == floor(x);
+  };
+  if (!is_count(beg) || !is_count(end) || end < beg ||
+      (end != beg && (!is_count(step) || step < 1.0))) {
+    return false;
+  }
+  // 用64位整数递增, 避免end接近int32上限时溢出
+  const auto last = static_cast<int64_t>(end);
+  const int64_t inc = end != beg ? static_cast<int64_t>(step) : 1;
+  passenger_capacity_.clear();
+  for (auto c = static_cast<int64_t>(beg); c <= last; c += inc) {
+    passenger_capacity_.push_back(static_cast<int32_t>(c));
+  }
+  return true;
+}
+
+size_t TractionSweep::grid_size() const {
+  return mass_.size() * passenger_capacity_.size() * F_const_.size() *
+         P_limit_.size() * F_brake_.size() * brake_eta_.size();
+}
+
+TractionParams TractionSweep::params_at(size_t index) const {
+  // 混合进制解码, brake_eta变化最快
+  TractionParams p;
+  p.brake_eta = brake_eta_.at(index % brake_eta_.size());
+  index /= brake_eta_.size();
+  p.F_brake = F_brake_.at(index % F_brake_.size());
+  index /= F_brake_.size();
+  p.P_limit = P_limit_.at(index % P_limit_.size());
+  index /= P_limit_.size();
+  p.F_const = F_const_.at(index % F_const_.size());
+  index /= F_const_.size();
+  p.passenger_capacity =
+      passenger_capacity_.at(index % passenger_capacity_.size());
+  index /= passenger_capacity_.size();
+  p.vehicle_m = mass_.at(index % mass_.size());
+  return p;
+}
+
+void TractionSweep::run_range(const TractionSweep &sweep, size_t beg,
+                              size_t end,
+                              std::vector<TractionSweepRecord> &out) {
+  for (size_t i = beg; i != end; ++i) {
+    TractionSweepRecord &r = out[i];
+    r.params = sweep.params_at(i);
+    TractionCalculator calculator(r.params);
+    r.consume = calculator.accelerating_stage_W_per_second(
+        sweep.consume_seconds_);
+    r.produce = calculator.brake_stage_W_per_second(sweep.produce_seconds_);
+    r.total_consume = 0.0;
+    for (double w : r.consume) {
+      r.total_consume += w;
+    }
+    r.total_produce = 0.0;
+    for (double w : r.produce) {
+      r.total_produce += w;
+    }
+  }
+}
+
+bool TractionSweep::run(size_t thread_cnt) {
+  const size_t sz = grid_size();
+  // 先检查所有组合, 避免工作线程在time_to_P_limit中死循环
+  for (size_t i = 0; i != sz; ++i) {
+    TractionParams p = params_at(i);
+    if (!TractionCalculator(p).reaches_P_limit()) {
+      cout << "无法加速到功率限制阶段的参数组合: mass=" << p.vehicle_m
+           << ", passenger_capacity=" << p.passenger_capacity
+           << ", F_const=" << p.F_const << ", P_limit=" << p.P_limit << endl;
+      return false;
+    }
+  }
+  thread_cnt = std::max<size_t>(1, std::min(thread_cnt, sz));
+  records_.assign(sz, TractionSweepRecord());
+  // 各线程写入records_中互不重叠的区段
+  size_t avg_task_cnt = sz / thread_cnt;
+  vector<future<void>> fut_vec;
+  fut_vec.reserve(thread_cnt);
+  for (size_t i = 0; i != thread_cnt; ++i) {
+    size_t beg = i * avg_task_cnt;
+    size_t end = i + 1 == thread_cnt ? sz : beg + avg_task_cnt;
+    fut_vec.emplace_back(std::async(std::launch::async, run_range,
+                                    std::cref(*this), beg, end,
+                                    std::ref(records_)));
+  }
+  for (auto &fut : fut_vec) {
+    fut.get();
+  }
+  return true;
+}
+
+const std::vector<TractionSweepRecord> &TractionSweep::records() const {
+  return records_;
+}
+
+void TractionSweep::output_result(const std::string &f_name) const {
+  CsvWriter of(f_name);
+  if (!of.is_open()) {
+    std::cout << "Failed to open [" << f_name << "] !" << std::endl;
+    return;
+  }
+  of.field("mass")
+      .field("passenger_capacity")
+      .field("F_const")
+      .field("P_limit")
+      .field("F_brake")
+      .field("brake_eta")
+      .field("total_consume")
+      .field("total_produce")
+      .field("regen_ratio");
+  for (size_t i = 0; i != consume_seconds_; ++i) {
+    of.field("consume_" + to_string(i));
+  }
+  for (size_t i = 0; i != produce_seconds_; ++i) {
+    of.field("produce_" + to_string(i));
+  }
+  of.end_row();
+  for (const auto &r : records_) {
+    of.field(r.params.vehicle_m)
+        .field(r.params.passenger_capacity)
+        .field(r.params.F_const)
+        .field(r.params.P_limit)
+        .field(r.params.F_brake)
+        .field(r.params.brake_eta)
+        .field(r.total_consume)
+        .field(r.total_produce)
+        .field(r.total_produce / r.total_consume);
+    for (double w : r.consume) {
+      of.field(w);
+    }
+    for (double w : r.produce) {
+      of.field(w);
+    }
+    of.end_row();
+  }
+  if (!of.close()) {
+    std::cout << "Failed to write [" << f_name << "] !" << std::endl;
+    return;
+  }
+  std::cout << "Save file [" << f_name << "] successful!" << std::endl;
+}
+
+} // namespace yaohui
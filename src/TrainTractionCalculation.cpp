@@ -1,17 +1,97 @@
 #include <algorithm>
 #include <cmath>
+#include <exception>
 #include <fstream>
 #include <iostream>
 #include <limits>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include "TractionCalculator.hpp"
+#include "TractionSweep.hpp"
 
 using namespace std;
 using namespace yaohui;
 
-int main() {
+namespace {
+
+void print_sweep_usage() {
+  cout << "用法: TrainTractionCalculation --sweep [--<参数>=起:止:步长 | "
+          "--<参数>=值]... [--threads=N] [--output=文件名]"
+       << endl;
+  cout << "参数: mass passenger_capacity F_const P_limit F_brake brake_eta"
+       << endl;
+}
+
+// 参数扫描模式
+int run_sweep(int argc, char *argv[]) {
+  TractionSweep sweep;
+  size_t thread_cnt = std::max(1u, std::thread::hardware_concurrency());
+  string out_file = "traction-sweep.csv";
+  for (int i = 2; i < argc; ++i) {
+    string arg = argv[i];
+    size_t eq = arg.find('=');
+    if (arg.compare(0, 2, "--") != 0 || eq == string::npos) {
+      print_sweep_usage();
+      return 1;
+    }
+    string name = arg.substr(2, eq - 2);
+    string value = arg.substr(eq + 1);
+    if (name == "threads") {
+      try {
+        thread_cnt = std::max(1ul, stoul(value));
+      } catch (const std::exception &) {
+        cout << "无效参数: " << arg << endl;
+        print_sweep_usage();
+        return 1;
+      }
+      continue;
+    }
+    if (name == "output") {
+      out_file = value;
+      continue;
+    }
+    // 起:止:步长 或 单个取值
+    double beg = 0.0, end = 0.0, step = 0.0;
+    size_t c1 = value.find(':');
+    size_t c2 = c1 == string::npos ? string::npos : value.find(':', c1 + 1);
+    bool parsed = true;
+    try {
+      if (c1 == string::npos) {
+        beg = end = stod(value);
+      } else if (c2 != string::npos) {
+        beg = stod(value.substr(0, c1));
+        end = stod(value.substr(c1 + 1, c2 - c1 - 1));
+        step = stod(value.substr(c2 + 1));
+      }
+    } catch (const std::exception &) {
+      parsed = false;
+    }
+    if (!parsed || (c1 != string::npos && c2 == string::npos) ||
+        !sweep.set_range(name, beg, end, step)) {
+      cout << "无效参数: " << arg << endl;
+      print_sweep_usage();
+      return 1;
+    }
+  }
+
+  cout << "参数组合数目: " << sweep.grid_size() << ", 线程数目: " << thread_cnt
+       << endl;
+  if (!sweep.run(thread_cnt)) {
+    return 1;
+  }
+  sweep.output_result(out_file);
+  return 0;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  if (argc > 1 && string(argv[1]) == "--sweep") {
+    return run_sweep(argc, argv);
+  }
+
   TractionCalculator traction_calculator;
   //  traction_calculator.calculate_power_time_data_0_to_40();
 
@@ -1,14 +1,230 @@
+#include "Evaluator.hpp"
 #include "Individual.hpp"
+#include "LineModel.hpp"
+#include "ParallelTempering.hpp"
+#include "PhaseTimer.hpp"
 #include "RandomWalk.hpp"
+#include "RunReport.hpp"
+#include "ScalingBenchmark.hpp"
+#include "SimulatedAnnealing.hpp"
 #include "Solver.hpp"
+#include "SyntheticLine.hpp"
 #include "Timetable.hpp"
+#include "Tracer.hpp"
+#include <algorithm>
 #include <chrono>
 #include <iostream>
+#include <limits>
+#include <memory>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <thread>
 
 using namespace std;
 using namespace yaohui;
 
-int main() {
+namespace {
+
+// 数值型选项的上限
+const size_t kMaxCount = std::numeric_limits<size_t>::max();
+
+void print_usage() {
+  std::cout << "Usage: YH-Master-Thesis [--line=<line.json>] "
+               "[--synthetic-line=<stations>,<arms>[,<hours>]] "
+               "[--warm-start=<timetable.json>] [--fitness-log=<csv>] "
+               "[--checkpoint=<file>] [--checkpoint-every=<n>] "
+               "[--resume=<file>] [--init=<sobol|lhs>] "
+               "[--baseline=<sobol|lhs>] [--walk-online] "
+               "[--walk-spill=<file>] [--anneal] "
+               "[--cooling=<geometric|linear>] [--tempering] "
+               "[--replicas=<n>] [--local-search=<k>] "
+               "[--gain-table=<csv>] [--phase-profile=<csv>] "
+               "[--trace=<json>] [--perf-counters] [--seed=<n>] "
+               "[--run-report=<json>] "
+               "[--benchmark=<json>] [--benchmark-threads=<n>]"
+            << std::endl;
+}
+
+/**
+ * @brief 解析数值型选项的取值
+ *
+ * arg中前缀之后的部分须全部为十进制数字, 且在[min_value, max_value]内.
+ * 解析失败时输出出错的选项和用法, 返回false.
+ */
+bool parse_count(const string &arg, size_t prefix_len, size_t min_value,
+                 size_t max_value, size_t &value) {
+  string text = arg.substr(prefix_len);
+  bool ok = !text.empty() &&
+            text.find_first_not_of("0123456789") == string::npos;
+  if (ok) {
+    try {
+      unsigned long long v = std::stoull(text);
+      ok = v >= min_value && v <= max_value;
+      if (ok) {
+        value = static_cast<size_t>(v);
+      }
+    } catch (const std::exception &) {
+      ok = false; // 超出范围
+    }
+  }
+  if (!ok) {
+    std::cout << "Invalid value: " << arg << std::endl;
+    print_usage();
+  }
+  return ok;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  // 命令行参数: --line=<线路描述文件>, 缺省时使用内置线路
+  //            --synthetic-line=<车站数>,<供电臂数>[,<小时数>], 使用合成线路
+  //            --warm-start=<运行图json>, 以已有运行图热启动遗传算法
+  //            --fitness-log=<csv>, 边运行边写出每代的适应度
+  //            --checkpoint=<文件>, 定期写出检查点
+  //            --checkpoint-every=<代数>, 检查点间隔, 缺省为10代
+  //            --resume=<检查点>, 从检查点继续进化
+  //            --init=<sobol|lhs>, 以低差异序列生成遗传算法的初始种群
+  //            --baseline=<sobol|lhs>, 基准样本用低差异序列代替随机漫步
+  //            --walk-online, 随机漫步只做在线统计, 不保存每个样本
+  //            --walk-spill=<文件>, 在线统计时把原始样本写入二进制文件
+  //            --anneal, 以模拟退火代替遗传算法
+  //            --cooling=<geometric|linear>, 模拟退火的降温方式
+  //            --tempering, 以并行退火(副本交换)代替遗传算法
+  //            --replicas=<n>, 并行退火的温度层数, 缺省为硬件线程数
+  //            --local-search=<k>, 遗传算法每代对最好的k个个体做局部搜索
+  //            --gain-table=<csv>, 输出最优运行图各事件平移的增益表
+  //            --phase-profile=<csv>, 输出遗传算法每代各阶段的计时
+  //            --trace=<json>, 记录各线程的事件, 结束时输出Chrome trace
+  //            --perf-counters, 按阶段统计硬件计数器(周期、指令、缓存和分支)
+  //            --seed=<n>, 各优化引擎和随机漫步的种子, 缺省取时钟
+  //            --run-report=<json>, 运行汇总, 缺省为run-report.json
+  //            --benchmark=<json>, 以固定种子测量1..n线程的吞吐率后退出
+  //            --benchmark-threads=<n>, 最大线程数, 缺省为硬件线程数
+  string warm_start_file;
+  string fitness_log_file;
+  string checkpoint_file;
+  size_t checkpoint_every = 10;
+  string resume_file;
+  bool init_sampled = false;
+  SamplingMethod init_method = SamplingMethod::kSobol;
+  bool baseline_sampled = false;
+  SamplingMethod baseline_method = SamplingMethod::kSobol;
+  bool walk_online = false;
+  string walk_spill_file;
+  bool anneal = false;
+  CoolingSchedule cooling = CoolingSchedule::kGeometric;
+  bool tempering = false;
+  size_t replica_cnt = 0;
+  size_t local_search_k = 0;
+  string gain_table_file;
+  string phase_profile_file;
+  string trace_file;
+  bool perf_counters = false;
+  unsigned seed = static_cast<unsigned>(
+      std::chrono::system_clock::now().time_since_epoch().count());
+  string run_report_file = "run-report.json";
+  bool synthetic_line_saved = false;
+  string benchmark_file;
+  size_t benchmark_threads = 0;
+  for (int i = 1; i < argc; ++i) {
+    string arg = argv[i];
+    if (arg.compare(0, 7, "--line=") == 0) {
+      try {
+        LineModel::set_current(LineModel::load_from_file(arg.substr(7)));
+      } catch (const std::exception &e) {
+        std::cout << e.what() << std::endl;
+        return 1;
+      }
+    } else if (arg.compare(0, 17, "--synthetic-line=") == 0) {
+      SyntheticLineSpec spec;
+      if (!parse_synthetic_line(arg.substr(17), spec)) {
+        std::cout << "Invalid synthetic line: " << arg.substr(17) << std::endl;
+        return 1;
+      }
+      try {
+        auto line =
+            std::make_shared<const LineModel>(make_synthetic_line(spec));
+        // 便于复现
+        synthetic_line_saved = line->write_to_file("synthetic-line.json");
+        LineModel::set_current(line);
+      } catch (const std::exception &e) {
+        std::cout << e.what() << std::endl;
+        return 1;
+      }
+    } else if (arg.compare(0, 13, "--warm-start=") == 0) {
+      warm_start_file = arg.substr(13);
+    } else if (arg.compare(0, 14, "--fitness-log=") == 0) {
+      fitness_log_file = arg.substr(14);
+    } else if (arg.compare(0, 13, "--checkpoint=") == 0) {
+      checkpoint_file = arg.substr(13);
+    } else if (arg.compare(0, 19, "--checkpoint-every=") == 0) {
+      // 0会使检查点从不写出, 不接受
+      if (!parse_count(arg, 19, 1, kMaxCount, checkpoint_every)) {
+        return 1;
+      }
+    } else if (arg.compare(0, 9, "--resume=") == 0) {
+      resume_file = arg.substr(9);
+    } else if (arg.compare(0, 7, "--init=") == 0 &&
+               parse_sampling_method(arg.substr(7), init_method)) {
+      init_sampled = true;
+    } else if (arg.compare(0, 11, "--baseline=") == 0 &&
+               parse_sampling_method(arg.substr(11), baseline_method)) {
+      baseline_sampled = true;
+    } else if (arg == "--walk-online") {
+      walk_online = true;
+    } else if (arg.compare(0, 13, "--walk-spill=") == 0) {
+      walk_online = true;
+      walk_spill_file = arg.substr(13);
+    } else if (arg == "--anneal") {
+      anneal = true;
+    } else if (arg.compare(0, 10, "--cooling=") == 0 &&
+               parse_cooling_schedule(arg.substr(10), cooling)) {
+      anneal = true;
+    } else if (arg == "--tempering") {
+      tempering = true;
+    } else if (arg.compare(0, 11, "--replicas=") == 0) {
+      tempering = true;
+      if (!parse_count(arg, 11, 1, kMaxCount, replica_cnt)) {
+        return 1;
+      }
+    } else if (arg.compare(0, 15, "--local-search=") == 0) {
+      if (!parse_count(arg, 15, 0, kMaxCount, local_search_k)) {
+        return 1;
+      }
+    } else if (arg.compare(0, 13, "--gain-table=") == 0) {
+      gain_table_file = arg.substr(13);
+    } else if (arg.compare(0, 16, "--phase-profile=") == 0) {
+      phase_profile_file = arg.substr(16);
+    } else if (arg.compare(0, 8, "--trace=") == 0) {
+      trace_file = arg.substr(8);
+      Tracer::enable();
+    } else if (arg == "--perf-counters") {
+      // 不可用时只输出原因, 照常优化
+      perf_counters = ScopedPhase::enable_perf_counters();
+    } else if (arg.compare(0, 7, "--seed=") == 0) {
+      size_t value = 0;
+      if (!parse_count(arg, 7, 0, std::numeric_limits<unsigned>::max(),
+                       value)) {
+        return 1;
+      }
+      seed = static_cast<unsigned>(value);
+    } else if (arg.compare(0, 13, "--run-report=") == 0) {
+      run_report_file = arg.substr(13);
+    } else if (arg.compare(0, 12, "--benchmark=") == 0) {
+      benchmark_file = arg.substr(12);
+    } else if (arg.compare(0, 20, "--benchmark-threads=") == 0) {
+      if (!parse_count(arg, 20, 1, kMaxCount, benchmark_threads)) {
+        return 1;
+      }
+    } else {
+      std::cout << "Unknown argument: " << arg << std::endl;
+      print_usage();
+      return 1;
+    }
+  }
+
   size_t gene_cnt = 200;       // 进化次数
   size_t population_cnt = 100; // 种群规模
   double alpha = 0.015;        // 选择参数alpha
@@ -16,47 +232,237 @@ int main() {
   double mutate_p = 0.05;      // 变异概率
   size_t thread_cnt = 8;       // 线程数目
 
-  auto start = std::chrono::system_clock::now();
+  size_t local_search_budget = 2000; // 局部搜索每个个体的评价次数
+
+  size_t anneal_steps = 2000000; // 每轮退火的步数
+  size_t anneal_restarts = 4;    // 退火轮数
+  double t_begin = 1e-3;         // 初始温度
+  double t_end = 1e-6;           // 终止温度
+
+  size_t tempering_steps = 4000000; // 并行退火每条链的步数
+  double t_min = 1e-6;              // 并行退火的最低温度
+  double t_max = 1e-4;              // 并行退火的最高温度
+  size_t exchange_every = 10000;    // 相邻温度层每隔多少步交换一次
+
+  // 基准测试: 与上面相同的进化参数, 但只进化少数几代
+  if (!benchmark_file.empty()) {
+    size_t benchmark_gene_cnt = 10;   // 进化次数
+    size_t benchmark_walk_times = 10; // 随机漫步每个个体的步数
+    unsigned benchmark_seed = 20230101;
+    if (benchmark_threads == 0) {
+      benchmark_threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    ScalingBenchmark benchmark(benchmark_gene_cnt, population_cnt, cross_p,
+                               mutate_p, alpha, benchmark_walk_times,
+                               benchmark_seed);
+    benchmark.run(benchmark_threads);
+    benchmark.print_summary();
+    return benchmark.write_to_file(benchmark_file) ? 0 : 1;
+  }
+
+  RunReport report(gene_cnt, population_cnt, cross_p, mutate_p, alpha,
+                   thread_cnt, seed);
+  if (synthetic_line_saved) {
+    report.add_output("synthetic-line.json");
+  }
+  report.begin_engine(tempering ? "tempering" : anneal ? "annealing" : "ga");
   // construct solver
-  Solver solver(gene_cnt, population_cnt, cross_p, mutate_p, alpha, thread_cnt);
-  solver.do_optimization();
-  auto end = std::chrono::system_clock::now();
+  std::unique_ptr<Solver> solver_ptr;
+  std::unique_ptr<SimulatedAnnealing> annealing_ptr;
+  std::unique_ptr<ParallelTempering> tempering_ptr;
+  if (anneal || tempering) {
+    TimetableConfig start_config;
+    if (!warm_start_file.empty()) {
+      try {
+        start_config =
+            TimetableConfig::load_from_timetable_file(warm_start_file);
+      } catch (const std::exception &e) {
+        std::cout << e.what() << std::endl;
+        return 1;
+      }
+    }
+    if (tempering) {
+      tempering_ptr.reset(new ParallelTempering(tempering_steps, replica_cnt,
+                                                t_min, t_max, exchange_every,
+                                                start_config, seed));
+    } else {
+      annealing_ptr.reset(new SimulatedAnnealing(anneal_steps,
+                                                 anneal_restarts, t_begin,
+                                                 t_end, cooling, start_config,
+                                                 seed));
+    }
+  } else if (!resume_file.empty()) {
+    try {
+      solver_ptr.reset(new Solver(resume_file, thread_cnt));
+      report.clear_seed(); // 随机数引擎状态取自检查点
+    } catch (const std::exception &e) {
+      std::cout << e.what() << std::endl;
+      return 1;
+    }
+  } else {
+    SolverOptions options;
+    options.gene_cnt = gene_cnt;
+    options.population_cnt = population_cnt;
+    options.cross_p = cross_p;
+    options.mutate_p = mutate_p;
+    options.alpha = alpha;
+    options.thread_cnt = thread_cnt;
+    options.has_seed = true;
+    options.seed = seed;
+    options.sampled_init = init_sampled;
+    options.init_method = init_method;
+    try {
+      std::unique_ptr<TimetableConfig> seed_config;
+      if (!warm_start_file.empty()) {
+        seed_config.reset(new TimetableConfig(
+            TimetableConfig::load_from_timetable_file(warm_start_file)));
+        options.warm_start = seed_config.get();
+      }
+      solver_ptr.reset(new Solver(options));
+    } catch (const std::exception &e) {
+      std::cout << e.what() << std::endl;
+      return 1;
+    }
+  }
+  if (solver_ptr) {
+    Solver &solver = *solver_ptr;
+    if (!fitness_log_file.empty() &&
+        !solver.set_fitness_log(fitness_log_file)) {
+      fitness_log_file.clear(); // 适应度仍写入processing-data.csv
+    }
+    if (!checkpoint_file.empty()) {
+      solver.set_checkpoint(checkpoint_file, checkpoint_every);
+    }
+    if (local_search_k != 0) {
+      solver.set_local_search(local_search_k, local_search_budget);
+    }
+    solver.do_optimization();
+    if (!checkpoint_file.empty() && solver.checkpoint_written()) {
+      report.add_output(checkpoint_file);
+    }
+  } else {
+    ScopedPhase::collect(); // 丢弃初始解等之前的计数
+    if (tempering_ptr) {
+      tempering_ptr->do_optimization();
+    } else {
+      annealing_ptr->do_optimization();
+    }
+    if (perf_counters) {
+      print_perf_summary(ScopedPhase::collect().perf);
+    }
+  }
   std::cout << "The cost of time for optimizing timetable: "
-            << std::chrono::duration<double>(end - start).count() << " second."
-            << std::endl;
+            << report.end_engine() << " second." << std::endl;
   // output processing data
-  solver.output_optimization_result("processing-data.csv"); // output
+  Individual best_individual;
+  if (solver_ptr) {
+    if (solver_ptr->output_optimization_result("processing-data.csv")) {
+      report.add_output(fitness_log_file.empty() ? "processing-data.csv"
+                                                 : fitness_log_file);
+      report.add_output("only-best-processing-data.csv");
+    }
+    if (!phase_profile_file.empty() &&
+        solver_ptr->output_phase_profile(phase_profile_file)) {
+      report.add_output(phase_profile_file);
+    }
+    if (perf_counters) {
+      solver_ptr->print_perf_summary();
+    }
+    best_individual = solver_ptr->individual_after_optimize();
+  } else if (tempering_ptr) {
+    if (tempering_ptr->output_optimization_result(
+            "tempering-process-data.csv")) {
+      report.add_output("tempering-process-data.csv");
+    }
+    best_individual = tempering_ptr->individual_after_optimize();
+  } else {
+    if (annealing_ptr->output_optimization_result(
+            "annealing-process-data.csv")) {
+      report.add_output("annealing-process-data.csv");
+    }
+    best_individual = annealing_ptr->individual_after_optimize();
+  }
 
   // get best solution
-  Timetable best_solution =
-      Timetable(solver.individual_after_optimize().timetable_config());
+  Timetable best_solution = Timetable(best_individual.timetable_config());
 
   // output the file of energy distribution
-  best_solution.output_energy_distribution("optimized");
+  if (best_solution.output_energy_distribution("optimized")) {
+    // 每个供电臂一个用能和一个产能文件
+    std::set<supply_arm_id_t> arms;
+    for (const auto &kv : LineModel::current()->supply_arm()) {
+      arms.insert(kv.second);
+    }
+    for (supply_arm_id_t arm : arms) {
+      string arm_str = std::to_string(arm);
+      report.add_output("optimized-consume-supply-id-" + arm_str + ".csv");
+      report.add_output("optimized-produce-supply-id-" + arm_str + ".csv");
+    }
+  }
+  if (best_solution.output_energy_distribution_binary(
+          "optimized-energy-distribution.bin", false, true)) {
+    report.add_output("optimized-energy-distribution.bin");
+  }
 
   // output the json file of timetable
-  best_solution.write_to_file("optimized-timetable.json");
+  if (best_solution.write_to_file("optimized-timetable.json")) {
+    report.add_output("optimized-timetable.json");
+  }
 
   // output plot data of the best timetable
-  best_solution.output_plot_data("best-timetable-plot-data.csv");
+  if (best_solution.output_plot_data("best-timetable-plot-data.csv")) {
+    report.add_output("best-timetable-plot-data.csv");
+  }
+
+  // 各事件平移-30..30秒的增益表
+  if (!gain_table_file.empty() &&
+      Evaluator(best_individual.timetable_config())
+          .output_gain_table(gain_table_file, 30)) {
+    report.add_output(gain_table_file);
+  }
 
   // default timetable
   TimetableConfig tbc;
   Timetable default_tb(tbc);
-  std::cout << "The reuse ratio of default timetable: "
-            << default_tb.total_reuse_ratio() << std::endl;
+  double default_reuse_ratio = default_tb.total_reuse_ratio();
+  std::cout << "The reuse ratio of default timetable: " << default_reuse_ratio
+            << std::endl;
+  report.set_reuse_ratio(best_individual.score(), default_reuse_ratio);
   // output plot data
-  default_tb.output_plot_data("default-timetable-plot-data.csv");
+  if (default_tb.output_plot_data("default-timetable-plot-data.csv")) {
+    report.add_output("default-timetable-plot-data.csv");
+  }
 
   // random walk
-  start = std::chrono::system_clock::now();
-  RandomWalk rw = RandomWalk(population_cnt, gene_cnt);
+  report.begin_engine("random_walk");
+  RandomWalk rw = RandomWalk(population_cnt, gene_cnt, 0, seed);
+  if (walk_online) {
+    rw.set_online(10, walk_spill_file);
+  }
+  if (baseline_sampled) {
+    rw.set_sampling(baseline_method);
+  }
   rw.do_random_walk();
-  end = std::chrono::system_clock::now();
-  std::cout << "The cost of time for random walk: "
-            << std::chrono::duration<double>(end - start).count() << " second."
-            << std::endl;
-  rw.output_process_result("random-walk-process-result.csv");
-  rw.output_plot_data("random-walk-timetable-plot-data.csv");
-  return 0;
+  std::cout << "The cost of time for random walk: " << report.end_engine()
+            << " second." << std::endl;
+  if (walk_online) {
+    if (rw.output_statistics("random-walk-statistics.csv")) {
+      report.add_output("random-walk-statistics.csv");
+    }
+    if (rw.output_histogram("random-walk-histogram.csv")) {
+      report.add_output("random-walk-histogram.csv");
+    }
+    if (rw.spill_written()) {
+      report.add_output(walk_spill_file);
+    }
+  } else if (rw.output_process_result("random-walk-process-result.csv")) {
+    report.add_output("random-walk-process-result.csv");
+  }
+  if (rw.output_plot_data("random-walk-timetable-plot-data.csv")) {
+    report.add_output("random-walk-timetable-plot-data.csv");
+  }
+  if (!trace_file.empty() && Tracer::write_to_file(trace_file)) {
+    report.add_output(trace_file);
+  }
+  return report.write_to_file(run_report_file) ? 0 : 1;
 }